@@ -0,0 +1,377 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "ofx/HTTP/UpstreamConnection.h"
+#include "ofx/JSONRPC/CircuitBreaker.h"
+#include "ofx/JSONRPC/HashRing.h"
+#include "ofx/JSONRPC/MethodArgs.h"
+#include "ofx/JSONRPC/MethodRegistry.h"
+#include "ofx/JSONRPC/Reducer.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief Settings for a Gateway's outlier detection.
+class OutlierDetectionSettings
+{
+public:
+    /// \brief How often the backends are checked.
+    ///
+    /// Zero disables outlier detection.
+    std::chrono::milliseconds interval = std::chrono::seconds(1);
+
+    /// \brief Eject backends whose average latency is this many times the
+    ///        median of the backends.
+    double latencyFactor = 3.0;
+
+    /// \brief Backends faster than this are never ejected for latency.
+    std::chrono::milliseconds minLatency = std::chrono::milliseconds(50);
+
+    /// \brief Latencies are only compared among at least this many
+    ///        backends.
+    std::size_t minBackends = 3;
+
+    /// \brief How long a backend is ejected for the first time.
+    ///
+    /// A backend ejected again soon after it returns is ejected for a
+    /// multiple of this duration.
+    std::chrono::milliseconds ejectionDuration = std::chrono::seconds(30);
+
+    /// \brief The largest fraction of the backends ejected at once.
+    double maxEjectedFraction = 0.5;
+};
+
+
+/// \brief Forwards JSONRPC calls to a set of backend servers.
+///
+/// A gateway is attached to a MethodRegistry as its fallback, so calls to
+/// methods the registry does not have are forwarded to a backend:
+///
+/// ~~~{.cpp}
+///     gateway.addBackend("render-1", "10.0.0.1", 8197);
+///     gateway.addBackend("render-2", "10.0.0.2", 8197);
+///     gateway.addBackend("store", "10.0.0.3", 8197);
+///
+///     gateway.routePrefix("store", "store");
+///     gateway.shardBy("render", "sceneId");
+///
+///     gateway.attach(server);
+/// ~~~
+///
+/// Calls are routed by the longest matching method prefix. A prefix
+/// matches a method of the same name and the methods below it, so `store`
+/// matches `store` and `store.get`. The empty prefix matches every method.
+///
+/// A prefix is either routed to one backend, or sharded across every
+/// backend added to the gateway by consistent hashing of a parameter. Calls
+/// with the same parameter value always reach the same backend, and adding
+/// or removing a backend moves few keys. A call without the parameter is
+/// sharded by its method name.
+///
+/// A prefix may instead be fanned out: the call is sent to every backend in
+/// parallel and the results are combined by a JSONRPC::Reducer. See
+/// fanOut().
+///
+/// Each backend is reached over one persistent UpstreamConnection, on which
+/// calls are pipelined. Calls to a backend that fails are answered with
+/// JSONRPC::Errors::RPC_ERROR_CONNECTION_CLOSED.
+///
+/// Each connection has a circuit breaker, so calls to a failing or stalled
+/// backend fail fast with JSONRPC::Errors::RPC_ERROR_UNAVAILABLE. With
+/// outlier detection enabled, backends whose breaker is open or whose
+/// latency is far above their peers' are ejected from the ring used by
+/// sharded routes for a while, and their keys move to the other backends.
+///
+/// Gateway is thread-safe.
+class Gateway
+{
+public:
+    /// \brief Create a Gateway.
+    /// \param timers The wheel used to enforce call deadlines. The wheel
+    ///        must outlive the gateway.
+    Gateway(JSONRPC::TimerWheel& timers);
+
+    /// \brief Destroy the Gateway, closing its backend connections.
+    ~Gateway();
+
+    /// \brief Add a backend, replacing any backend of the same name.
+    /// \param name The name of the backend.
+    /// \param host The backend's host.
+    /// \param port The backend's port.
+    /// \param path The path of the backend's WebSocket route.
+    /// \param weight The backend's relative share of sharded calls.
+    void addBackend(const std::string& name,
+                    const std::string& host,
+                    uint16_t port,
+                    const std::string& path = "/",
+                    std::size_t weight = 1);
+
+    /// \brief Set the circuit breaker settings of backends added later.
+    /// \param settings The circuit breaker settings.
+    void setCircuitBreakerSettings(const JSONRPC::CircuitBreakerSettings& settings);
+
+    /// \brief Enable or reconfigure outlier detection.
+    ///
+    /// Outlier detection is disabled until this is called. Disabling it
+    /// returns every ejected backend to the ring.
+    ///
+    /// \param settings The outlier detection settings.
+    void setOutlierDetection(const OutlierDetectionSettings& settings);
+
+    /// \brief Remove a backend and close its connection.
+    ///
+    /// Prefixes routed to the backend are no longer forwarded.
+    ///
+    /// \param name The name of the backend.
+    void removeBackend(const std::string& name);
+
+    /// \brief Route methods under a prefix to one backend.
+    /// \param prefix The method name prefix.
+    /// \param backend The name of the backend.
+    void routePrefix(const std::string& prefix, const std::string& backend);
+
+    /// \brief Shard methods under a prefix across the backends.
+    /// \param prefix The method name prefix.
+    /// \param paramKey The name of the parameter hashed to choose a
+    ///        backend, or an empty string to hash the method name.
+    void shardBy(const std::string& prefix, const std::string& paramKey);
+
+    /// \brief Fan methods under a prefix out to every backend.
+    ///
+    /// Calls are answered with the object described in fanOut().
+    ///
+    /// \param prefix The method name prefix.
+    /// \param reducer The reducer combining the backends' results.
+    /// \param deadline The time the backends are given to answer, or zero
+    ///        to use the call timeout.
+    void fanOutPrefix(const std::string& prefix,
+                      const JSONRPC::Reducer& reducer,
+                      std::chrono::milliseconds deadline = std::chrono::milliseconds(0));
+
+    /// \brief Stop forwarding methods under a prefix.
+    /// \param prefix The method name prefix.
+    void removeRoute(const std::string& prefix);
+
+    /// \brief Set the time a forwarded call may take.
+    /// \param timeout The call timeout.
+    void setCallTimeout(std::chrono::milliseconds timeout);
+
+    /// \returns the time a forwarded call may take.
+    std::chrono::milliseconds getCallTimeout() const;
+
+    /// \brief Forward a call and wait for its response.
+    /// \param method The method name.
+    /// \param args The call's arguments. The response's result or error is
+    ///        stored in them.
+    /// \returns true iff a route matched the method.
+    bool forward(const std::string& method, JSONRPC::MethodArgs& args);
+
+    /// \brief Forward a batch of requests.
+    ///
+    /// The batch is split by backend and each backend's share is pipelined
+    /// on its connection, so the backends work on the batch in parallel.
+    /// The backends' responses are merged in the order of the batch.
+    /// Notifications are forwarded but have no response.
+    ///
+    /// \param batch A JSON array of JSONRPC requests.
+    /// \returns a JSON array of the responses.
+    ofJson forwardBatch(const ofJson& batch);
+
+    /// \brief Call a method on several backends and combine the results.
+    ///
+    /// The call is sent to every backend before any response is awaited.
+    /// Results are passed to the reducer as they arrive, until every
+    /// backend has answered, the reducer is satisfied or the deadline
+    /// passes. The combined result is returned with the errors of the
+    /// backends that failed or missed the deadline:
+    ///
+    /// ~~~{.json}
+    ///     {
+    ///         "result": 42,
+    ///         "complete": false,
+    ///         "responses": 49,
+    ///         "errors": {
+    ///             "worker-17": { "code": -32000, "message": "..." }
+    ///         }
+    ///     }
+    /// ~~~
+    ///
+    /// `complete` is true if every backend answered or the reducer was
+    /// satisfied.
+    ///
+    /// \param method The method name.
+    /// \param params The method parameters.
+    /// \param reducer The reducer combining the results.
+    /// \param deadline The time the backends are given to answer, or zero
+    ///        to use the call timeout.
+    /// \param backends The names of the backends to call, or an empty list
+    ///        to call every backend.
+    /// \returns the combined result and the errors.
+    ofJson fanOut(const std::string& method,
+                  const ofJson& params,
+                  const JSONRPC::Reducer& reducer,
+                  std::chrono::milliseconds deadline,
+                  const std::vector<std::string>& backends = std::vector<std::string>());
+
+    /// \brief Forward a registry's calls to unregistered methods.
+    /// \param registry The registry. It must not outlive the gateway.
+    template <typename LockingPolicy>
+    void attach(JSONRPC::MethodRegistry_<LockingPolicy>& registry)
+    {
+        registry.setFallback([this](const void*,
+                                    const std::string& method,
+                                    JSONRPC::MethodArgs& args) {
+            return forward(method, args);
+        });
+    }
+
+    /// \returns the names of the backends.
+    std::vector<std::string> backends() const;
+
+    /// \brief Get the health of the backends.
+    ///
+    /// Each backend's breaker state, counters, average latency, pending
+    /// calls and ejection are listed by name.
+    ///
+    /// \returns the backend metrics.
+    ofJson metrics() const;
+
+    /// \param name The name of the backend.
+    /// \returns the backend's connection, or nullptr if there is none.
+    std::shared_ptr<UpstreamConnection> backend(const std::string& name) const;
+
+    enum
+    {
+        /// \brief The default time a forwarded call may take.
+        DEFAULT_CALL_TIMEOUT_MILLISECONDS = 30000,
+        /// \brief The largest multiple of the ejection duration.
+        MAX_EJECTION_MULTIPLIER = 10
+    };
+
+private:
+    /// \brief A backend and its standing in the ring.
+    struct Backend
+    {
+        /// \brief The connection to the backend.
+        std::shared_ptr<UpstreamConnection> connection;
+
+        /// \brief The backend's weight in the ring.
+        std::size_t weight = 1;
+
+        /// \brief True iff the backend is ejected from the ring.
+        bool ejected = false;
+
+        /// \brief The time an ejected backend returns to the ring.
+        JSONRPC::TimerWheel::Clock::time_point ejectedUntil;
+
+        /// \brief The time the backend last returned to the ring.
+        JSONRPC::TimerWheel::Clock::time_point admittedAt;
+
+        /// \brief The number of recent ejections.
+        std::size_t ejections = 0;
+    };
+
+    /// \brief How the methods under a prefix are routed.
+    struct Route
+    {
+        /// \brief The backend, or an empty string if the route is sharded
+        ///        or fanned out.
+        std::string backend;
+
+        /// \brief The parameter hashed by a sharded route.
+        std::string paramKey;
+
+        /// \brief The reducer of a fan-out route, or nullptr.
+        std::shared_ptr<const JSONRPC::Reducer> reducer;
+
+        /// \brief The deadline of a fan-out route.
+        std::chrono::milliseconds deadline = std::chrono::milliseconds(0);
+    };
+
+    /// \brief Find the route with the longest prefix matching a method.
+    /// \param method The method name.
+    /// \param route Set to the matching route.
+    /// \returns true iff a route matched the method.
+    bool _findRoute(const std::string& method, Route& route) const;
+
+    /// \brief Choose the backend for a call.
+    /// \param route The call's route.
+    /// \param method The method name.
+    /// \param params The method parameters.
+    /// \returns the backend's connection, or nullptr if the route's
+    ///          backend is missing.
+    std::shared_ptr<UpstreamConnection> _select(const Route& route,
+                                                const std::string& method,
+                                                const ofJson& params) const;
+
+    /// \brief Schedule the next outlier check.
+    ///
+    /// The caller must hold _mutex.
+    void _scheduleOutlierCheck();
+
+    /// \brief Cancel the pending outlier check and wait for one in progress.
+    ///
+    /// The caller must not hold _mutex.
+    void _cancelOutlierCheck();
+
+    /// \brief Eject outliers from the ring and readmit recovered backends.
+    /// \param check The check's number. Checks other than the latest one
+    ///        do nothing.
+    void _checkOutliers(uint64_t check);
+
+    /// \brief Compose an error response.
+    /// \param id The request id.
+    /// \param error The error.
+    /// \returns the response.
+    static ofJson _errorResponse(const ofJson& id, const JSONRPC::Error& error);
+
+    /// \brief The wheel enforcing call deadlines.
+    JSONRPC::TimerWheel& _timers;
+
+    /// \brief Maps backend names to the backends.
+    std::map<std::string, Backend> _backends;
+
+    /// \brief The ring of backends used by sharded routes.
+    JSONRPC::HashRing _ring;
+
+    /// \brief Maps method name prefixes to routes.
+    std::map<std::string, Route> _routes;
+
+    /// \brief The time a forwarded call may take.
+    std::chrono::milliseconds _callTimeout;
+
+    /// \brief The circuit breaker settings of new backends.
+    JSONRPC::CircuitBreakerSettings _breakerSettings;
+
+    /// \brief The outlier detection settings.
+    OutlierDetectionSettings _outlierSettings;
+
+    /// \brief The pending outlier check, or zero.
+    JSONRPC::TimerWheel::TimerId _outlierTimer = 0;
+
+    /// \brief The number of the latest outlier check.
+    uint64_t _outlierCheck = 0;
+
+    /// \brief A mutex to protect the backends and routes.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::HTTP
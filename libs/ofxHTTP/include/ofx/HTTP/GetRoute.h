@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <string>
+#include "ofEvents.h"
+#include "Poco/URI.h"
+#include "ofx/HTTP/BaseServer.h"
+#include "ofx/HTTP/ServerEvents.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief The arguments of a GET request.
+class GetEventArgs: public ServerEventArgs
+{
+public:
+    /// \brief Create GetEventArgs.
+    /// \param evt The arguments of the request.
+    GetEventArgs(ServerEventArgs& evt);
+
+    /// \brief Destroy the GetEventArgs.
+    virtual ~GetEventArgs();
+
+    /// \returns the decoded query parameters of the request.
+    const Poco::URI::QueryParameters& query() const;
+
+    /// \brief Get a query parameter.
+    /// \param name The name of the parameter.
+    /// \param defaultValue The value returned if the parameter is absent.
+    /// \returns the value of the first parameter with the name.
+    std::string get(const std::string& name,
+                    const std::string& defaultValue = "") const;
+
+    /// \param name The name of the parameter.
+    /// \returns true iff the query has a parameter with the name.
+    bool has(const std::string& name) const;
+
+private:
+    /// \brief The decoded query parameters.
+    Poco::URI::QueryParameters _query;
+
+};
+
+
+/// \brief The events of a GetRoute.
+class GetEvents
+{
+public:
+    /// \brief Notified when a GET request arrives.
+    ofEvent<GetEventArgs> onHTTPGetEvent;
+
+};
+
+
+/// \brief Settings for a GetRoute.
+class GetRouteSettings: public BaseRouteSettings
+{
+public:
+    /// \brief Create GetRouteSettings.
+    /// \param routePathPattern The route path pattern.
+    GetRouteSettings(const std::string& routePathPattern = DEFAULT_GET_ROUTE);
+
+    /// \brief Destroy the GetRouteSettings.
+    virtual ~GetRouteSettings();
+
+    /// \brief The default route path pattern.
+    static const std::string DEFAULT_GET_ROUTE;
+
+};
+
+
+/// \brief A route that hands GET requests and their query to listeners.
+///
+/// If no listener attends to a request, it is answered with a 400 status.
+class GetRoute: public BaseRoute_<GetRouteSettings>
+{
+public:
+    /// \brief A typedef for GetRouteSettings.
+    typedef GetRouteSettings Settings;
+
+    /// \brief Create a GetRoute.
+    /// \param settings The route settings.
+    GetRoute(const Settings& settings = Settings());
+
+    /// \brief Destroy the GetRoute.
+    virtual ~GetRoute();
+
+    virtual bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                  bool isSecurePort) const override;
+
+    virtual void handleRequest(ServerEventArgs& evt) override;
+
+    /// \brief Register a listener for GET events.
+    /// \param listener The listener to register.
+    /// \param priority The priority of the listener.
+    template <class ListenerClass>
+    void registerGetEvents(ListenerClass* listener,
+                           int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        ofAddListener(events.onHTTPGetEvent, listener, &ListenerClass::onHTTPGetEvent, priority);
+    }
+
+    /// \brief Unregister a listener for GET events.
+    /// \param listener The listener to unregister.
+    /// \param priority The priority of the listener.
+    template <class ListenerClass>
+    void unregisterGetEvents(ListenerClass* listener,
+                             int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        ofRemoveListener(events.onHTTPGetEvent, listener, &ListenerClass::onHTTPGetEvent, priority);
+    }
+
+    /// \brief The route's events.
+    GetEvents events;
+
+};
+
+
+} } // namespace ofx::HTTP
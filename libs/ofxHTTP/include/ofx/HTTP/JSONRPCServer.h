@@ -7,36 +7,168 @@
 #pragma once
 
 
+#include <chrono>
+#include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "ofTypes.h"
 #include "ofx/HTTP/BaseServer.h"
 #include "ofx/HTTP/FileSystemRoute.h"
+#include "ofx/HTTP/GetRoute.h"
+#include "ofx/HTTP/KeepAliveTracker.h"
 #include "ofx/HTTP/PostRoute.h"
+#include "ofx/HTTP/ServerSentEventsRoute.h"
+#include "ofx/HTTP/StreamingPostRoute.h"
 #include "ofx/HTTP/WebSocketConnection.h"
 #include "ofx/HTTP/WebSocketRoute.h"
+#include "ofx/JSONRPC/Connection.h"
+#include "ofx/JSONRPC/MessageLimits.h"
 #include "ofx/JSONRPC/MethodRegistry.h"
+#include "ofx/JSONRPC/PendingCalls.h"
+#include "ofx/JSONRPC/ResultCache.h"
+#include "ofx/JSONRPC/StreamingRequestParser.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+#include "ofx/JSONRPC/TrafficLog.h"
 
 
 namespace ofx {
 namespace HTTP {
 
 
+/// \brief Settings for a JSONRPCServer.
+///
+/// HTTP keep-alive is enabled by default, so POST clients can send many
+/// calls over one connection. The limits are configured with
+/// BaseServerSettings::setMaxKeepAliveRequests() and
+/// BaseServerSettings::setKeepAliveTimeout().
 class JSONRPCServerSettings: public BaseServerSettings
 {
 public:
+    /// \brief Create JSONRPCServerSettings.
+    JSONRPCServerSettings()
+    {
+        setKeepAlive(true);
+        setMaxKeepAliveRequests(DEFAULT_MAX_KEEP_ALIVE_REQUESTS);
+        setKeepAliveTimeout(Poco::Timespan(DEFAULT_KEEP_ALIVE_TIMEOUT_SECONDS, 0));
+    }
+
+    enum
+    {
+        /// \brief The default maximum number of requests per connection.
+        DEFAULT_MAX_KEEP_ALIVE_REQUESTS = 1000,
+        /// \brief The default idle time before a connection is closed.
+        DEFAULT_KEEP_ALIVE_TIMEOUT_SECONDS = 15
+    };
+
     FileSystemRouteSettings fileSystemRouteSettings;
+    GetRouteSettings getRouteSettings;
     PostRouteSettings postRouteSettings;
+    ServerSentEventsRouteSettings serverSentEventsRouteSettings;
+    StreamingPostRouteSettings streamingPostRouteSettings;
     WebSocketRouteSettings webSocketRouteSettings;
+
+    /// \brief The default time to wait for a client to answer a server call.
+    std::chrono::milliseconds callTimeout = std::chrono::milliseconds(5000);
+
+    /// \brief Ping WebSocket clients that have been quiet for this long.
+    ///
+    /// Zero disables keepalive pings.
+    std::chrono::milliseconds heartbeatInterval = std::chrono::seconds(30);
+
+    /// \brief Close WebSocket clients that have been quiet for this long.
+    ///
+    /// Zero disables idle timeouts.
+    std::chrono::milliseconds idleTimeout = std::chrono::milliseconds(0);
+
+    /// \brief Size and complexity limits for incoming messages.
+    JSONRPC::MessageLimits messageLimits;
+
+    /// \brief The maximum number of bytes queued for each WebSocket client.
+    ///
+    /// A client that falls further behind is disconnected. Zero disables the
+    /// budget.
+    std::size_t outboundBudget = 16 * 1024 * 1024;
+
+    /// \brief Close WebSocket clients that send a message exceeding a limit.
+    ///
+    /// If false, the client receives an RPC_ERROR_LIMIT_EXCEEDED response.
+    bool closeOnLimitExceeded = false;
+
+    /// \brief The maximum size of a streamed POST body.
+    ///
+    /// Bodies with a JSON content type are parsed as they are read and the
+    /// elements of array parameters of streaming methods are not retained.
+    /// messageLimits.maxMessageSize bounds the bytes that are retained; this
+    /// bounds the whole body, checked against the declared length up front
+    /// and against the bytes read for chunked bodies. Zero disables the
+    /// check.
+    uint64_t maxStreamedMessageSize = 1024 * 1024 * 1024;
+
+    /// \brief Abandon uploads that have made no progress for this long.
+    ///
+    /// An upload is abandoned if its form never completes, e.g. because the
+    /// client disconnected. Zero disables the timeout.
+    std::chrono::milliseconds uploadTimeout = std::chrono::minutes(5);
+
+    /// \brief The maximum number of results cached for GET requests.
+    ///
+    /// Zero disables the cache.
+    std::size_t resultCacheSize = JSONRPC::ResultCache::DEFAULT_CAPACITY;
 };
 
 
 /// \brief A simple JSONRPCServer.
 ///
+/// \tparam SessionStoreType The session store used by the server.
+/// \tparam LockingPolicy The locking policy of the server's method registry.
+///
 /// This server can process JSONRPC calls submitted via WebSockets or
-/// POST requests.
-template <typename SessionStoreType>
+/// POST requests. It can also call methods on connected WebSocket clients
+/// and await their responses.
+///
+/// POST bodies with a JSON content type are parsed incrementally as they are
+/// read from the socket. The array parameters of methods registered with
+/// registerStreamingMethod() are passed to the method one element at a time
+/// rather than being buffered.
+///
+/// Multipart form uploads whose file input is named after a method
+/// registered with registerUploadMethod() are passed to the method as they
+/// progress, and the method's result is returned when the form completes.
+///
+/// Notifications sent with broadcast() are serialized once and delivered to
+/// WebSocket clients and to Server-Sent Events clients of the
+/// ServerSentEventsRoute, where connection groups act as topics.
+///
+/// Idempotent methods can also be called with a GET request to the GetRoute,
+/// so browsers and intermediary caches can absorb repeated calls:
+///
+///     GET /rpc?method=get-text&params={"lang":"en"}&id=1
+///
+/// The params and id are optional and params must be URL encoded JSON.
+/// Responses carry an ETag and a Cache-Control max-age taken from the
+/// method's CachePolicy, and results are kept in a ResultCache for that
+/// long. Results are shared by all callers and marked public, so they must
+/// not depend on the session. Requests whose If-None-Match matches are
+/// answered with 304 Not Modified. Other methods are answered with 405 Method Not Allowed.
+///
+/// POST requests are answered on persistent connections. Poco serves the
+/// requests of a connection in order, so pipelined calls are answered in the
+/// order they were sent. Every POST receives a complete response, with a
+/// 204 No Content status for notifications, so the connection can carry the
+/// next request. keepAliveMetrics() reports how often connections are reused.
+///
+/// A single TimerWheel thread drives WebSocket keepalive pings, idle
+/// timeouts and server call deadlines for all connections.
+///
+/// Incoming traffic can be recorded with startCapture() and fed back to a
+/// server or a method registry with a TrafficReplayer, e.g. to reproduce a
+/// production workload in a benchmark.
+template <typename SessionStoreType, typename LockingPolicy = JSONRPC::MutexLockingPolicy>
 class JSONRPCServer_:
     public BaseServer_<JSONRPCServerSettings, SessionStoreType>,
-    public JSONRPC::MethodRegistry
+    public JSONRPC::MethodRegistry_<LockingPolicy>
 {
 public:
     /// \brief A typedef for JSONRPCServerSettings.
@@ -59,14 +191,122 @@ public:
     /// \returns the PostRoute attached to this server.
     FileSystemRoute& fileSystemRoute();
 
+    /// \brief Get the GetRoute.
+    /// \returns the GetRoute attached to this server.
+    GetRoute& getRoute();
+
     /// \brief Get the PostRoute.
     /// \returns the PostRoute attached to this server.
     PostRoute& postRoute();
 
+    /// \brief Get the ServerSentEventsRoute.
+    /// \returns the ServerSentEventsRoute attached to this server.
+    ServerSentEventsRoute& serverSentEventsRoute();
+
+    /// \brief Get the StreamingPostRoute.
+    /// \returns the StreamingPostRoute attached to this server.
+    StreamingPostRoute& streamingPostRoute();
+
     /// \brief Get the WebSocketRoute.
     /// \returns the WebSocketRoute attached to this server.
     WebSocketRoute& webSocketRoute();
 
+    /// \brief Call a method on a WebSocket client.
+    ///
+    /// The request is assigned a unique id and sent to the client. The
+    /// returned future is fulfilled when the client's response with the
+    /// matching id arrives. The call will fail with a CallTimeoutException
+    /// if the client does not respond within the configured callTimeout, or
+    /// with a ConnectionClosedException if the connection closes first.
+    ///
+    /// \param connection The client connection to call.
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns a future holding the result of the call.
+    std::future<ofJson> call(const JSONRPC::Connection& connection,
+                             const std::string& method,
+                             const ofJson& params = nullptr);
+
+    /// \brief Call a method on a WebSocket client.
+    /// \param connection The client connection to call.
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \param timeout The maximum time to wait for a response.
+    /// \returns a future holding the result of the call.
+    std::future<ofJson> call(const JSONRPC::Connection& connection,
+                             const std::string& method,
+                             const ofJson& params,
+                             std::chrono::milliseconds timeout);
+
+    /// \brief Send a notification to every connected WebSocket client.
+    ///
+    /// The notification is also sent to every Server-Sent Events client.
+    ///
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns the number of WebSocket clients the notification was queued
+    ///          on.
+    std::size_t broadcast(const std::string& method,
+                          const ofJson& params = nullptr);
+
+    /// \brief Send a notification to every member of a connection group.
+    ///
+    /// The notification is also sent to the Server-Sent Events clients
+    /// subscribed to the group as a topic.
+    ///
+    /// \param group The name of the group, as passed to join().
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns the number of WebSocket clients the notification was queued
+    ///          on.
+    std::size_t broadcast(const std::string& group,
+                          const std::string& method,
+                          const ofJson& params);
+
+    /// \brief Get the registry of open WebSocket connections.
+    ///
+    /// The registry is used to look up connections and to manage group
+    /// membership via ConnectionRegistry::join() and leave().
+    ///
+    /// \returns the ConnectionRegistry for this server.
+    JSONRPC::ConnectionRegistry& connections();
+
+    /// \brief Get the TimerWheel that drives the server's timers.
+    ///
+    /// The wheel's thread runs for the lifetime of the server. It may be used
+    /// to schedule additional coarse timers, e.g. cache entry expiry.
+    ///
+    /// \returns the server's TimerWheel.
+    JSONRPC::TimerWheel& timers();
+
+    /// \brief Get the cache of results served to GET requests.
+    /// \returns the server's ResultCache.
+    JSONRPC::ResultCache& resultCache();
+
+    /// \brief Get the keep-alive counters of the POST routes.
+    /// \returns a snapshot of the approximate counters.
+    /// \sa KeepAliveTracker
+    KeepAliveTracker::Metrics keepAliveMetrics() const;
+
+    /// \brief Start recording incoming messages to a traffic log.
+    ///
+    /// WebSocket text frames and POST bodies are recorded as they arrive,
+    /// before they are processed. Frames carry the id of their connection
+    /// and POST bodies carry connection id 0. Only the first
+    /// messageLimits.maxMessageSize bytes of a streamed POST body are
+    /// recorded, so a longer body is recorded truncated. GET requests are
+    /// not recorded. A capture in progress is replaced.
+    ///
+    /// \param path The path of the log file. An existing file is replaced.
+    /// \throws Poco::IOException if the file cannot be opened.
+    void startCapture(const std::string& path);
+
+    /// \brief Stop recording incoming messages and close the log.
+    void stopCapture();
+
+    /// \returns true iff incoming messages are being recorded.
+    bool isCapturing() const;
+
     bool onWebSocketOpenEvent(WebSocketOpenEventArgs& evt);
     bool onWebSocketCloseEvent(WebSocketCloseEventArgs& evt);
     bool onWebSocketFrameReceivedEvent(WebSocketFrameEventArgs& evt);
@@ -77,110 +317,665 @@ public:
     bool onHTTPFormEvent(PostFormEventArgs& evt);
     bool onHTTPUploadEvent(PostUploadEventArgs& evt);
 
+    bool onHTTPStreamingPostEvent(StreamingPostEventArgs& evt);
+
+    bool onHTTPGetEvent(GetEventArgs& evt);
+
 protected:
+    /// \brief Schedule the next heartbeat check for a connection.
+    /// \param connection The connection to check.
+    void _scheduleHeartbeat(const JSONRPC::Connection& connection);
+
+    /// \brief Ping or close a connection depending on its activity.
+    /// \param connection The connection to check.
+    void _onHeartbeat(const JSONRPC::Connection& connection);
+
+    /// \brief An upload whose form has not yet completed.
+    struct PendingUpload
+    {
+        /// \brief The name of the upload method.
+        std::string method;
+
+        /// \brief The stream receiving the uploads.
+        std::shared_ptr<JSONRPC::UploadStream> stream;
+
+        /// \brief The time of the most recent upload event.
+        JSONRPC::TimerWheel::Clock::time_point lastActivity;
+
+        /// \brief The message of an exception thrown by the stream, if any.
+        std::string error;
+    };
+
+    /// \brief Schedule the next expiry check for a pending upload.
+    /// \param postId The id of the post.
+    void _scheduleUploadExpiry(const std::string& postId);
+
+    /// \brief Record a POST request in the keep-alive counters.
+    /// \param args The arguments of the POST request.
+    void _beginPost(ServerEventArgs& args);
+
+    /// \brief Complete a POST request that has not been answered.
+    ///
+    /// Notifications are answered with 204 No Content, so that the client
+    /// can send its next request on the same connection.
+    ///
+    /// \param args The arguments of the POST request.
+    void _endPost(ServerEventArgs& args);
+
+    /// \brief Send a Response to a POST request.
+    ///
+    /// Responses with a produced result are sent with chunked transfer
+    /// encoding as the result is written. Others are sent in one buffer.
+    ///
+    /// \param args The arguments of the POST request.
+    /// \param response The Response to send.
+    void _sendResponse(ServerEventArgs& args,
+                       const JSONRPC::Response& response);
+
+    /// \brief Parse a call id passed as text, e.g. in a form or query.
+    ///
+    /// Numeric ids are recovered. Other ids are strings.
+    ///
+    /// \param id The id text.
+    /// \returns the id.
+    ofJson _parseId(const std::string& id) const;
+
+    /// \brief Answer a discovery request from the cached OpenRPC document.
+    ///
+    /// The cached document is spliced into the response without parsing.
+    ///
+    /// \param request The incoming Request.
+    /// \param connection The connection the Request arrived on.
+    /// \param buffer Filled with the serialized response if the request
+    ///        expects one.
+    /// \returns true iff the request was a discovery request.
+    bool _processDiscovery(const JSONRPC::Request& request,
+                           const JSONRPC::Connection& connection,
+                           std::string& buffer) const;
+
+    /// \brief Record an incoming message if a capture is in progress.
+    /// \param connectionId The id of the connection the message arrived on.
+    /// \param source The transport the message arrived on.
+    /// \param message The raw message.
+    void _capture(uint64_t connectionId,
+                  JSONRPC::TrafficRecord::Source source,
+                  const std::string& message);
+
     /// \brief The FileSystemRoute attached to this server.
     FileSystemRoute _fileSystemRoute;
 
+    /// \brief The GetRoute attached to this server.
+    GetRoute _getRoute;
+
     /// \brief The PostRoute attached to this server.
     PostRoute _postRoute;
 
+    /// \brief The ServerSentEventsRoute attached to this server.
+    ServerSentEventsRoute _serverSentEventsRoute;
+
+    /// \brief The StreamingPostRoute attached to this server.
+    StreamingPostRoute _streamingPostRoute;
+
     /// \brief The WebSocketRoute attached to this server.
     WebSocketRoute _webSocketRoute;
 
+    /// \brief The open WebSocket connections.
+    JSONRPC::ConnectionRegistry _connections;
+
+    /// \brief The wheel driving heartbeats, idle timeouts and deadlines.
+    JSONRPC::TimerWheel _timers;
+
+    /// \brief Tracks the reuse of persistent POST connections.
+    KeepAliveTracker _keepAlive;
+
+    /// \brief Calls made to clients that are awaiting a response.
+    JSONRPC::PendingCalls _pendingCalls;
+
+    /// \brief Results of idempotent methods served to GET requests.
+    JSONRPC::ResultCache _resultCache;
+
+    /// \brief The default time to wait for a client response.
+    std::chrono::milliseconds _callTimeout;
+
+    /// \brief The interval between keepalive pings.
+    std::chrono::milliseconds _heartbeatInterval;
+
+    /// \brief The idle time after which connections are closed.
+    std::chrono::milliseconds _idleTimeout;
+
+    /// \brief The limits for incoming messages.
+    JSONRPC::MessageLimits _messageLimits;
+
+    /// \brief The outbound budget for each WebSocket client.
+    std::size_t _outboundBudget;
+
+    /// \brief True iff clients exceeding a limit are disconnected.
+    bool _closeOnLimitExceeded;
+
+    /// \brief The maximum declared size of a streamed POST body.
+    uint64_t _maxStreamedMessageSize;
+
+    /// \brief The inactivity after which uploads are abandoned.
+    std::chrono::milliseconds _uploadTimeout;
+
+    /// \brief Uploads awaiting their form, keyed by post id.
+    std::map<std::string, PendingUpload> _uploads;
+
+    /// \brief A mutex to protect the pending uploads.
+    std::mutex _uploadsMutex;
+
+    /// \brief The serialized response sent when a message exceeds a limit.
+    ///
+    /// The response is prepared once, since it is sent when the server is
+    /// under memory pressure.
+    std::string _limitExceededResponse;
+
+    /// \brief The recorder of the capture in progress, if any.
+    ///
+    /// The pointer is loaded and stored atomically, so that messages can be
+    /// recorded without taking a lock when no capture is in progress.
+    std::shared_ptr<JSONRPC::TrafficRecorder> _recorder;
+
 };
 
 
 typedef JSONRPCServer_<SimpleSessionStore> JSONRPCServer;
 
 
-template <typename SessionStoreType>
-JSONRPCServer_<SessionStoreType>::JSONRPCServer_(const Settings& settings):
+template <typename SessionStoreType, typename LockingPolicy>
+JSONRPCServer_<SessionStoreType, LockingPolicy>::JSONRPCServer_(const Settings& settings):
     BaseServer_<JSONRPCServerSettings, SessionStoreType>(settings),
     _fileSystemRoute(settings.fileSystemRouteSettings),
+    _getRoute(settings.getRouteSettings),
     _postRoute(settings.postRouteSettings),
-    _webSocketRoute(settings.webSocketRouteSettings)
+    _serverSentEventsRoute(settings.serverSentEventsRouteSettings),
+    _streamingPostRoute(settings.streamingPostRouteSettings),
+    _webSocketRoute(settings.webSocketRouteSettings),
+    _keepAlive(_timers),
+    _pendingCalls(&_timers),
+    _resultCache(_timers, settings.resultCacheSize),
+    _callTimeout(settings.callTimeout),
+    _heartbeatInterval(settings.heartbeatInterval),
+    _idleTimeout(settings.idleTimeout),
+    _messageLimits(settings.messageLimits),
+    _outboundBudget(settings.outboundBudget),
+    _closeOnLimitExceeded(settings.closeOnLimitExceeded),
+    _maxStreamedMessageSize(settings.maxStreamedMessageSize),
+    _uploadTimeout(settings.uploadTimeout),
+    _limitExceededResponse(ofJson({
+        { "jsonrpc", "2.0" },
+        { "id", nullptr },
+        { "error", JSONRPC::Error::toJSON(JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_LIMIT_EXCEEDED)) }
+    }).dump())
 {
-    this->addRoute(&_fileSystemRoute); // #3 to test.
-    this->addRoute(&_postRoute);       // #2 to test.
-    this->addRoute(&_webSocketRoute);  // #1 to test.
+    this->addRoute(&_fileSystemRoute);       // #6 to test.
+    this->addRoute(&_postRoute);             // #5 to test.
+    this->addRoute(&_getRoute);              // #4 to test.
+    this->addRoute(&_serverSentEventsRoute); // #3 to test.
+    this->addRoute(&_streamingPostRoute);    // #2 to test.
+    this->addRoute(&_webSocketRoute);        // #1 to test.
 
     _postRoute.registerPostEvents(this);
+    _getRoute.registerGetEvents(this);
+    _streamingPostRoute.registerStreamingPostEvents(this);
     _webSocketRoute.registerWebSocketEvents(this);
+
+    _keepAlive.setup(settings.getKeepAlive() ? settings.getMaxKeepAliveRequests() : 1,
+                     std::chrono::milliseconds(settings.getKeepAliveTimeout().totalMilliseconds()));
+
+    _timers.start();
 }
 
 
-template <typename SessionStoreType>
-JSONRPCServer_<SessionStoreType>::~JSONRPCServer_()
+template <typename SessionStoreType, typename LockingPolicy>
+JSONRPCServer_<SessionStoreType, LockingPolicy>::~JSONRPCServer_()
 {
+    _timers.stop();
+
     _webSocketRoute.unregisterWebSocketEvents(this);
+    _streamingPostRoute.unregisterStreamingPostEvents(this);
+    _getRoute.unregisterGetEvents(this);
     _postRoute.unregisterPostEvents(this);
 
     this->removeRoute(&_webSocketRoute);
+    this->removeRoute(&_streamingPostRoute);
+    this->removeRoute(&_serverSentEventsRoute);
+    this->removeRoute(&_getRoute);
     this->removeRoute(&_postRoute);
     this->removeRoute(&_fileSystemRoute);
 }
 
 
-template <typename SessionStoreType>
-void JSONRPCServer_<SessionStoreType>::setup(const Settings& settings)
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::setup(const Settings& settings)
 {
     BaseServer_<JSONRPCServerSettings, SessionStoreType>::setup(settings);
     _fileSystemRoute.setup(settings.fileSystemRouteSettings);
+    _getRoute.setup(settings.getRouteSettings);
     _postRoute.setup(settings.postRouteSettings);
+    _serverSentEventsRoute.setup(settings.serverSentEventsRouteSettings);
+    _streamingPostRoute.setup(settings.streamingPostRouteSettings);
     _webSocketRoute.setup(settings.webSocketRouteSettings);
+    _callTimeout = settings.callTimeout;
+    _heartbeatInterval = settings.heartbeatInterval;
+    _idleTimeout = settings.idleTimeout;
+    _messageLimits = settings.messageLimits;
+    _outboundBudget = settings.outboundBudget;
+    _closeOnLimitExceeded = settings.closeOnLimitExceeded;
+    _maxStreamedMessageSize = settings.maxStreamedMessageSize;
+    _uploadTimeout = settings.uploadTimeout;
+    _resultCache.setCapacity(settings.resultCacheSize);
+    _keepAlive.setup(settings.getKeepAlive() ? settings.getMaxKeepAliveRequests() : 1,
+                     std::chrono::milliseconds(settings.getKeepAliveTimeout().totalMilliseconds()));
 }
 
 
-template <typename SessionStoreType>
-FileSystemRoute& JSONRPCServer_<SessionStoreType>::fileSystemRoute()
+template <typename SessionStoreType, typename LockingPolicy>
+FileSystemRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::fileSystemRoute()
 {
     return _fileSystemRoute;
 }
 
 
-template <typename SessionStoreType>
-PostRoute& JSONRPCServer_<SessionStoreType>::postRoute()
+template <typename SessionStoreType, typename LockingPolicy>
+GetRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::getRoute()
+{
+    return _getRoute;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+PostRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::postRoute()
 {
     return _postRoute;
 }
 
 
-template <typename SessionStoreType>
-WebSocketRoute& JSONRPCServer_<SessionStoreType>::webSocketRoute()
+template <typename SessionStoreType, typename LockingPolicy>
+ServerSentEventsRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::serverSentEventsRoute()
+{
+    return _serverSentEventsRoute;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+StreamingPostRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::streamingPostRoute()
+{
+    return _streamingPostRoute;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+WebSocketRoute& JSONRPCServer_<SessionStoreType, LockingPolicy>::webSocketRoute()
 {
     return _webSocketRoute;
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onWebSocketOpenEvent(WebSocketOpenEventArgs& evt)
+template <typename SessionStoreType, typename LockingPolicy>
+std::future<ofJson> JSONRPCServer_<SessionStoreType, LockingPolicy>::call(const JSONRPC::Connection& connection,
+                                                          const std::string& method,
+                                                          const ofJson& params)
+{
+    return call(connection, method, params, _callTimeout);
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+std::future<ofJson> JSONRPCServer_<SessionStoreType, LockingPolicy>::call(const JSONRPC::Connection& connection,
+                                                          const std::string& method,
+                                                          const ofJson& params,
+                                                          std::chrono::milliseconds timeout)
+{
+    uint64_t id = _pendingCalls.nextId();
+
+    // Register the call before sending so a fast response can't be missed.
+    std::future<ofJson> result = _pendingCalls.add(id, connection.id(), timeout);
+
+    if (!connection.send(JSONRPC::Request::toJSON(id, method, params).dump()))
+    {
+        _pendingCalls.fail(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_CONNECTION_CLOSED));
+    }
+
+    return result;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+std::size_t JSONRPCServer_<SessionStoreType, LockingPolicy>::broadcast(const std::string& method,
+                                                        const ofJson& params)
+{
+    JSONRPC::NotificationLog::Message message = std::make_shared<const std::string>(JSONRPC::Request::toJSON(nullptr, method, params).dump());
+
+    _serverSentEventsRoute.publish("", message);
+
+    return JSONRPC::ConnectionRegistry::broadcast(_connections.connections(),
+                                                  WebSocketFrame(*message));
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+std::size_t JSONRPCServer_<SessionStoreType, LockingPolicy>::broadcast(const std::string& group,
+                                                        const std::string& method,
+                                                        const ofJson& params)
+{
+    JSONRPC::NotificationLog::Message message = std::make_shared<const std::string>(JSONRPC::Request::toJSON(nullptr, method, params).dump());
+
+    _serverSentEventsRoute.publish(group, message);
+
+    return JSONRPC::ConnectionRegistry::broadcast(_connections.members(group),
+                                                  WebSocketFrame(*message));
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+JSONRPC::ConnectionRegistry& JSONRPCServer_<SessionStoreType, LockingPolicy>::connections()
+{
+    return _connections;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+JSONRPC::TimerWheel& JSONRPCServer_<SessionStoreType, LockingPolicy>::timers()
+{
+    return _timers;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+KeepAliveTracker::Metrics JSONRPCServer_<SessionStoreType, LockingPolicy>::keepAliveMetrics() const
+{
+    return _keepAlive.metrics();
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+JSONRPC::ResultCache& JSONRPCServer_<SessionStoreType, LockingPolicy>::resultCache()
+{
+    return _resultCache;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::startCapture(const std::string& path)
 {
+    std::atomic_store(&_recorder, std::make_shared<JSONRPC::TrafficRecorder>(path));
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::stopCapture()
+{
+    // The log is closed once messages being recorded have been written.
+    std::atomic_store(&_recorder, std::shared_ptr<JSONRPC::TrafficRecorder>());
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::isCapturing() const
+{
+    return std::atomic_load(&_recorder) != nullptr;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_scheduleHeartbeat(const JSONRPC::Connection& connection)
+{
+    std::chrono::milliseconds interval = _heartbeatInterval;
+
+    if (_idleTimeout.count() > 0 && (interval.count() == 0 || _idleTimeout < interval))
+    {
+        interval = _idleTimeout;
+    }
+
+    if (interval.count() > 0)
+    {
+        _timers.schedule(interval, [this, connection]() {
+            _onHeartbeat(connection);
+        });
+    }
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_onHeartbeat(const JSONRPC::Connection& connection)
+{
+    if (!connection.isOpen())
+    {
+        return;
+    }
+
+    auto idle = JSONRPC::TimerWheel::Clock::now() - connection.lastActivity();
+
+    if (_idleTimeout.count() > 0 && idle >= _idleTimeout)
+    {
+        connection.disconnect();
+        return;
+    }
+
+    // Only ping clients that have been quiet; traffic is proof of life.
+    if (_heartbeatInterval.count() > 0 && idle >= _heartbeatInterval)
+    {
+        connection.ping();
+    }
+
+    _scheduleHeartbeat(connection);
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_scheduleUploadExpiry(const std::string& postId)
+{
+    if (_uploadTimeout.count() == 0)
+    {
+        return;
+    }
+
+    _timers.schedule(_uploadTimeout, [this, postId]() {
+        std::unique_lock<std::mutex> lock(_uploadsMutex);
+
+        auto upload = _uploads.find(postId);
+
+        if (upload == _uploads.end())
+        {
+            return;
+        }
+
+        if (JSONRPC::TimerWheel::Clock::now() - upload->second.lastActivity >= _uploadTimeout)
+        {
+            ofLogWarning("JSONRPCServer::_scheduleUploadExpiry") << "Abandoning upload " << postId << " to " << upload->second.method << ".";
+            _uploads.erase(upload);
+            return;
+        }
+
+        lock.unlock();
+
+        _scheduleUploadExpiry(postId);
+    });
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_beginPost(ServerEventArgs& args)
+{
+    // Poco enforces the keep-alive limit and closes the connection itself.
+    _keepAlive.track(args.request());
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_endPost(ServerEventArgs& args)
+{
+    if (!args.response().sent())
+    {
+        args.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NO_CONTENT);
+        args.response().setContentLength(0);
+        args.response().send();
+    }
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_sendResponse(ServerEventArgs& args,
+                                                                    const JSONRPC::Response& response)
+{
+    if (!response.resultProducer() || response.isErrorResponse())
+    {
+        std::string buffer = response.toString();
+        args.response().sendBuffer(buffer.c_str(), buffer.length());
+        return;
+    }
+
+    args.response().setChunkedTransferEncoding(true);
+    args.response().setContentType("application/json");
+
+    std::ostream& stream = args.response().send();
+
+    try
+    {
+        JSONRPC::ResultWriter::writeResponse(stream, response.id(), response.resultProducer());
+    }
+    catch (const std::exception& exc)
+    {
+        // The status has been sent, so the truncated body signals the error.
+        ofLogError("JSONRPCServer::_sendResponse") << "Result producer failed: " << exc.what();
+    }
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+ofJson JSONRPCServer_<SessionStoreType, LockingPolicy>::_parseId(const std::string& id) const
+{
+    if (!id.empty() && id.find_first_not_of("0123456789") == std::string::npos)
+    {
+        return _messageLimits.parse(id);
+    }
+
+    return id;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::_processDiscovery(const JSONRPC::Request& request,
+                                                                        const JSONRPC::Connection& connection,
+                                                                        std::string& buffer) const
+{
+    if (request.method() != JSONRPC::MethodCatalog::DISCOVER_METHOD
+    || this->hasMethod(request.method()))
+    {
+        return false;
+    }
+
+    if (request.hasId())
+    {
+        buffer = JSONRPC::MethodCatalog::toResponse(request.id(), *this->discover(connection));
+    }
+
+    return true;
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+void JSONRPCServer_<SessionStoreType, LockingPolicy>::_capture(uint64_t connectionId,
+                                                               JSONRPC::TrafficRecord::Source source,
+                                                               const std::string& message)
+{
+    std::shared_ptr<JSONRPC::TrafficRecorder> recorder = std::atomic_load(&_recorder);
+
+    if (recorder)
+    {
+        recorder->record(connectionId, source, message);
+    }
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onWebSocketOpenEvent(WebSocketOpenEventArgs& evt)
+{
+    JSONRPC::Connection connection = _connections.add(evt.connection());
+    connection.setOutboundBudget(_outboundBudget);
+    _scheduleHeartbeat(connection);
     return false;  // We did not attend to this event, so pass it along.
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onWebSocketCloseEvent(WebSocketCloseEventArgs& evt)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onWebSocketCloseEvent(WebSocketCloseEventArgs& evt)
 {
+    JSONRPC::Connection connection = _connections.remove(evt.connection());
+
+    // Fail any server calls that are still waiting on this client.
+    if (connection)
+    {
+        _pendingCalls.cancel(connection.id());
+    }
+
     return false;  // We did not attend to this event, so pass it along.
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onWebSocketFrameReceivedEvent(WebSocketFrameEventArgs& evt)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onWebSocketFrameReceivedEvent(WebSocketFrameEventArgs& evt)
 {
+    JSONRPC::Connection connection = _connections.add(evt.connection());
+    connection.touch();
+
     try
     {
-        ofJson json = ofJson::parse(evt.frame().getText());
+        // Check the size before the frame's payload is copied.
+        _messageLimits.checkSize(evt.frame().size());
+
+        std::string text = evt.frame().getText();
+
+        _capture(connection.id(), JSONRPC::TrafficRecord::SOURCE_WEBSOCKET, text);
+
+        ofJson json = _messageLimits.parse(text);
+
+        // Responses to server calls are routed back to the waiting caller,
+        // but only from the client that the call was sent to. Anything else
+        // is handled as an ordinary message.
+        if (JSONRPC::PendingCalls::isResponse(json) && _pendingCalls.resolve(json, connection.id()))
+        {
+            return true;
+        }
 
         try
         {
             JSONRPC::Request request = JSONRPC::Request::fromJSON(evt, json);
-            JSONRPC::Response response = processCall(this, request);
+            std::string buffer;
+
+            if (_processDiscovery(request, connection, buffer))
+            {
+                if (!buffer.empty())
+                {
+                    connection.send(buffer);
+                }
+
+                return true;
+            }
+
+            JSONRPC::Response response = this->processCall(this, request, connection);
 
             if (response.hasId())
             {
-                evt.connection().sendFrame(response.toString());
+                std::string buffer;
+
+                try
+                {
+                    // A result producer runs here, after the registry has
+                    // stopped converting exceptions to error responses.
+                    buffer = response.toString();
+                }
+                catch (const std::exception& exc)
+                {
+                    ofLogError("JSONRPCServer::onWebSocketFrameReceivedEvent") << "Result producer failed: " << exc.what();
+
+                    buffer = JSONRPC::Response(evt,
+                                               response.id(),
+                                               JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR, exc.what(), nullptr)).toString();
+                }
+
+                connection.send(buffer);
             }
         }
         catch (const Poco::InvalidArgumentException& exc)
@@ -189,7 +984,7 @@ bool JSONRPCServer_<SessionStoreType>::onWebSocketFrameReceivedEvent(WebSocketFr
                                        ofJson(nullptr), // null value is required when parse exceptions
                                        JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_PARAMETERS));
 
-            evt.connection().sendFrame(response.toString());
+            connection.send(response.toString());
         }
         catch (const Poco::Exception& exc)
         {
@@ -197,12 +992,27 @@ bool JSONRPCServer_<SessionStoreType>::onWebSocketFrameReceivedEvent(WebSocketFr
                                        ofJson(nullptr), // null value is required when parse exceptions
                                        JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR));
 
-            evt.connection().sendFrame(response.toString());
+            connection.send(response.toString());
         }
 
         return true;  // We attended to the event, so consume it.
 
     }
+    catch (const JSONRPC::LimitExceededException& exc)
+    {
+        ofLogWarning("JSONRPCServer::onWebSocketFrameReceivedEvent") << "Connection " << connection.id() << ": " << exc.displayText();
+
+        if (_closeOnLimitExceeded)
+        {
+            connection.disconnect();
+        }
+        else
+        {
+            connection.send(_limitExceededResponse);
+        }
+
+        return true;  // We attended to the event, so consume it.
+    }
     catch (const std::invalid_argument& exc)
     {
         ofLogVerbose("JSONRPCServer::onWebSocketFrameReceivedEvent") << "Could not parse as JSON: " << exc.what();
@@ -212,44 +1022,155 @@ bool JSONRPCServer_<SessionStoreType>::onWebSocketFrameReceivedEvent(WebSocketFr
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onWebSocketFrameSentEvent(WebSocketFrameEventArgs& evt)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onWebSocketFrameSentEvent(WebSocketFrameEventArgs& evt)
 {
+    JSONRPC::Connection connection = _connections.find(evt.connection());
+
+    if (connection)
+    {
+        connection.sent(evt.frame().size());
+    }
+
     return false;  // We did not attend to this event, so pass it along.
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onWebSocketErrorEvent(WebSocketErrorEventArgs& evt)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onWebSocketErrorEvent(WebSocketErrorEventArgs& evt)
 {
     return false;  // We did not attend to this event, so pass it along.
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onHTTPFormEvent(PostFormEventArgs& args)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onHTTPFormEvent(PostFormEventArgs& args)
 {
-    ofLogVerbose("JSONRPCServer::onHTTPFormEvent") << "";
-    return false;  // We did not attend to this event, so pass it along.
+    PendingUpload upload;
+
+    {
+        std::unique_lock<std::mutex> lock(_uploadsMutex);
+
+        auto iter = _uploads.find(args.getPostId());
+
+        if (iter == _uploads.end())
+        {
+            ofLogVerbose("JSONRPCServer::onHTTPFormEvent") << "No upload method for post " << args.getPostId() << ".";
+            return false;  // We did not attend to this event, so pass it along.
+        }
+
+        upload = std::move(iter->second);
+        _uploads.erase(iter);
+    }
+
+    _beginPost(args);
+
+    const Poco::Net::NameValueCollection& form = args.getForm();
+    std::string buffer;
+
+    try
+    {
+        ofJson json = {
+            { "jsonrpc", "2.0" },
+            { "method", upload.method }
+        };
+
+        if (form.has("params"))
+        {
+            json["params"] = _messageLimits.parse(form.get("params"));
+        }
+
+        if (form.has("id"))
+        {
+            json["id"] = _parseId(form.get("id"));
+        }
+
+        JSONRPC::Connection connection;
+        JSONRPC::Request request = JSONRPC::Request::fromJSON(args, json);
+        JSONRPC::Response response = upload.error.empty()
+            ? this->processStreamedCall(this, request, *upload.stream)
+            : JSONRPC::Response(request,
+                                request.id(),
+                                JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR, upload.error, nullptr));
+
+        if (response.hasId())
+        {
+            _sendResponse(args, response);
+        }
+    }
+    catch (const JSONRPC::LimitExceededException& exc)
+    {
+        ofLogWarning("JSONRPCServer::onHTTPFormEvent") << exc.displayText();
+        buffer = _limitExceededResponse;
+    }
+    catch (const Poco::Exception& exc)
+    {
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr), // null value is required when parse exceptions.
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_REQUEST));
+
+        buffer = response.toString();
+    }
+    catch (const std::invalid_argument& exc)
+    {
+        ofLogVerbose("JSONRPCServer::onHTTPFormEvent") << "Could not parse params as JSON: " << exc.what();
+
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_PARSE));
+
+        buffer = response.toString();
+    }
+
+    if (!buffer.empty())
+    {
+        args.response().sendBuffer(buffer.c_str(), buffer.length());
+    }
+
+    _endPost(args);
+
+    return true;  // We attended to the event, so consume it.
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onHTTPPostEvent(PostEventArgs& args)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onHTTPPostEvent(PostEventArgs& args)
 {
     try
     {
-        ofJson json = ofJson::parse(args.getBuffer().getText());
+        _messageLimits.checkSize(args.getBuffer().size());
+
+        std::string text = args.getBuffer().getText();
+
+        _capture(0, JSONRPC::TrafficRecord::SOURCE_POST, text);
+
+        ofJson json = _messageLimits.parse(text);
+
+        _beginPost(args);
 
         try
         {
+            JSONRPC::Connection connection;
             JSONRPC::Request request = JSONRPC::Request::fromJSON(args, json);
-            JSONRPC::Response response = processCall(this, request);
+            std::string buffer;
+
+            if (_processDiscovery(request, connection, buffer))
+            {
+                if (!buffer.empty())
+                {
+                    args.response().sendBuffer(buffer.c_str(), buffer.length());
+                }
+
+                _endPost(args);
+
+                return true;
+            }
+
+            JSONRPC::Response response = this->processCall(this, request, connection);
 
             if (response.hasId())
             {
-                std::string buffer = response.toString();
-                args.response().sendBuffer(buffer.c_str(), buffer.length());
+                _sendResponse(args, response);
             }
         }
         catch (Poco::Exception& exc)
@@ -262,6 +1183,17 @@ bool JSONRPCServer_<SessionStoreType>::onHTTPPostEvent(PostEventArgs& args)
             args.response().sendBuffer(buffer.c_str(), buffer.length());
         }
 
+        _endPost(args);
+
+        return true;  // We attended to the event, so consume it.
+    }
+    catch (const JSONRPC::LimitExceededException& exc)
+    {
+        ofLogWarning("JSONRPCServer::onHTTPPostEvent") << exc.displayText();
+
+        _beginPost(args);
+        args.response().sendBuffer(_limitExceededResponse.c_str(), _limitExceededResponse.length());
+
         return true;  // We attended to the event, so consume it.
     }
     catch (const std::invalid_argument& exc)
@@ -274,28 +1206,355 @@ bool JSONRPCServer_<SessionStoreType>::onHTTPPostEvent(PostEventArgs& args)
 }
 
 
-template <typename SessionStoreType>
-bool JSONRPCServer_<SessionStoreType>::onHTTPUploadEvent(PostUploadEventArgs& args)
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onHTTPUploadEvent(PostUploadEventArgs& args)
 {
-    std::string stateString = "";
-    
-    switch (args.getState())
+    std::shared_ptr<JSONRPC::UploadStream> stream;
+
+    {
+        std::unique_lock<std::mutex> lock(_uploadsMutex);
+
+        auto upload = _uploads.find(args.getPostId());
+
+        if (upload != _uploads.end())
+        {
+            upload->second.lastActivity = JSONRPC::TimerWheel::Clock::now();
+
+            if (upload->second.error.empty())
+            {
+                stream = upload->second.stream;
+            }
+            else
+            {
+                return true;  // The upload already failed, so drop the rest.
+            }
+        }
+    }
+
+    // The first file of a post names the method by its form field name.
+    if (!stream && args.getState() == PostUploadEventArgs::UPLOAD_STARTING)
     {
-        case HTTP::PostUploadEventArgs::UPLOAD_STARTING:
-            stateString = "STARTING";
-            break;
-        case HTTP::PostUploadEventArgs::UPLOAD_PROGRESS:
-            stateString = "PROGRESS";
-            break;
-        case HTTP::PostUploadEventArgs::UPLOAD_FINISHED:
-            stateString = "FINISHED";
-            break;
+        stream = this->openUpload(args.getFormFieldName());
+
+        if (stream)
+        {
+            PendingUpload upload;
+            upload.method = args.getFormFieldName();
+            upload.stream = stream;
+            upload.lastActivity = JSONRPC::TimerWheel::Clock::now();
+
+            {
+                std::unique_lock<std::mutex> lock(_uploadsMutex);
+                _uploads[args.getPostId()] = upload;
+            }
+
+            _scheduleUploadExpiry(args.getPostId());
+        }
     }
-    
-    return false;  // We did not attend to this event, so pass it along.
+
+    if (!stream)
+    {
+        return false;  // We did not attend to this event, so pass it along.
+    }
+
+    try
+    {
+        stream->upload(args);
+    }
+    catch (const std::exception& exc)
+    {
+        // The error is returned when the form completes.
+        ofLogError("JSONRPCServer::onHTTPUploadEvent") << exc.what();
+
+        std::unique_lock<std::mutex> lock(_uploadsMutex);
+
+        auto upload = _uploads.find(args.getPostId());
+
+        if (upload != _uploads.end())
+        {
+            upload->second.error = exc.what();
+        }
+    }
+
+    return true;  // We attended to the event, so consume it.
+}
+
+
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onHTTPStreamingPostEvent(StreamingPostEventArgs& args)
+{
+    std::string buffer;
+
+    _beginPost(args);
+
+    try
+    {
+        // A declared length can be rejected before anything is read.
+        if (_maxStreamedMessageSize > 0
+        && args.request().hasContentLength()
+        && uint64_t(args.request().getContentLength64()) > _maxStreamedMessageSize)
+        {
+            throw JSONRPC::LimitExceededException("Message is " + std::to_string(args.request().getContentLength64()) + " bytes; the limit is " + std::to_string(_maxStreamedMessageSize) + ".");
+        }
+
+        JSONRPC::StreamingRequestParser parser(_messageLimits, [this](const std::string& method) {
+            return this->openStream(method);
+        }, _maxStreamedMessageSize);
+
+        // While capturing, the start of the body is read and recorded before
+        // it is parsed. The copy is capped at the message size, so a longer
+        // body is recorded truncated.
+        std::shared_ptr<JSONRPC::TrafficRecorder> recorder = std::atomic_load(&_recorder);
+        std::string head;
+
+        if (recorder)
+        {
+            std::size_t capacity = _messageLimits.maxMessageSize > 0 ? _messageLimits.maxMessageSize
+                                                                     : std::size_t(JSONRPC::MessageLimits::DEFAULT_MAX_MESSAGE_SIZE);
+            head.resize(capacity);
+            args.stream().read(&head[0], std::streamsize(capacity));
+            head.resize(std::size_t(args.stream().gcount()));
+            args.stream().clear();
+            recorder->record(0, JSONRPC::TrafficRecord::SOURCE_POST, head);
+        }
+
+        ofJson json = parser.parse(head, args.stream());
+
+        // Trailing whitespace must be consumed before the next request on
+        // the connection can be read.
+        args.stream().ignore(std::numeric_limits<std::streamsize>::max());
+
+        try
+        {
+            JSONRPC::Connection connection;
+            JSONRPC::Request request = JSONRPC::Request::fromJSON(args, json);
+
+            if (!_processDiscovery(request, connection, buffer))
+            {
+                std::shared_ptr<JSONRPC::ParamsStream> stream = parser.paramsStream();
+
+                JSONRPC::Response response = stream ? this->processStreamedCall(this, request, *stream)
+                                                    : this->processCall(this, request, connection);
+
+                if (response.hasId())
+                {
+                    _sendResponse(args, response);
+                }
+            }
+        }
+        catch (const Poco::Exception& exc)
+        {
+            JSONRPC::Response response(args,
+                                       ofJson(nullptr), // null value is required when parse exceptions.
+                                       JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_METHOD_NOT_FOUND));
+
+            buffer = response.toString();
+        }
+    }
+    catch (const JSONRPC::LimitExceededException& exc)
+    {
+        // The rest of the body is not read, so the connection can't be reused.
+        ofLogWarning("JSONRPCServer::onHTTPStreamingPostEvent") << exc.displayText();
+        args.response().setKeepAlive(false);
+        buffer = _limitExceededResponse;
+    }
+    catch (const Poco::InvalidArgumentException& exc)
+    {
+        // The envelope was rejected before the body was read.
+        args.response().setKeepAlive(false);
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_REQUEST, exc.message()));
+
+        buffer = response.toString();
+    }
+    catch (const std::invalid_argument& exc)
+    {
+        // The body has been consumed, so it can't be passed along.
+        ofLogVerbose("JSONRPCServer::onHTTPStreamingPostEvent") << "Could not parse as JSON: " << exc.what();
+        args.response().setKeepAlive(false);
+
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_PARSE));
+
+        buffer = response.toString();
+    }
+    catch (const Poco::Exception& exc)
+    {
+        // A resolver or stream failed while the body was being read.
+        ofLogError("JSONRPCServer::onHTTPStreamingPostEvent") << exc.displayText();
+        args.response().setKeepAlive(false);
+
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR));
+
+        buffer = response.toString();
+    }
+    catch (const std::exception& exc)
+    {
+        ofLogError("JSONRPCServer::onHTTPStreamingPostEvent") << exc.what();
+        args.response().setKeepAlive(false);
+
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR));
+
+        buffer = response.toString();
+    }
+
+    if (!buffer.empty())
+    {
+        args.response().sendBuffer(buffer.c_str(), buffer.length());
+    }
+
+    _endPost(args);
+
+    return true;  // We attended to the event, so consume it.
 }
 
 
+template <typename SessionStoreType, typename LockingPolicy>
+bool JSONRPCServer_<SessionStoreType, LockingPolicy>::onHTTPGetEvent(GetEventArgs& args)
+{
+    std::string method = args.get("method");
+
+    if (method.empty())
+    {
+        return false;  // We did not attend to this event, so pass it along.
+    }
+
+    std::string buffer;
+    JSONRPC::CachePolicy policy = this->cachePolicy(method);
+
+    if (!policy.isIdempotent())
+    {
+        // Calls that may have side effects must be POSTed.
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_REQUEST, "Method is not idempotent."));
+
+        buffer = response.toString();
+
+        args.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_METHOD_NOT_ALLOWED);
+        args.response().set("Allow", Poco::Net::HTTPRequest::HTTP_POST);
+        args.response().sendBuffer(buffer.c_str(), buffer.length());
+        return true;  // We attended to the event, so consume it.
+    }
+
+    ofJson params = nullptr;
+    ofJson id = nullptr;
+
+    try
+    {
+        if (args.has("params"))
+        {
+            params = _messageLimits.parse(args.get("params"));
+        }
+
+        if (args.has("id"))
+        {
+            id = _parseId(args.get("id"));
+        }
+    }
+    catch (const JSONRPC::LimitExceededException& exc)
+    {
+        ofLogWarning("JSONRPCServer::onHTTPGetEvent") << exc.displayText();
+        buffer = _limitExceededResponse;
+    }
+    catch (const std::invalid_argument& exc)
+    {
+        ofLogVerbose("JSONRPCServer::onHTTPGetEvent") << "Could not parse query as JSON: " << exc.what();
+
+        JSONRPC::Response response(args,
+                                   ofJson(nullptr),
+                                   JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_PARSE));
+
+        buffer = response.toString();
+    }
+
+    if (!buffer.empty())
+    {
+        args.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+        args.response().sendBuffer(buffer.c_str(), buffer.length());
+        return true;  // We attended to the event, so consume it.
+    }
+
+    _resultCache.validate(this->generation());
+
+    JSONRPC::ResultCache::Entry entry;
+
+    if (!_resultCache.find(method, params, entry))
+    {
+        ofJson json = {
+            { "jsonrpc", "2.0" },
+            { "method", method },
+            { "params", params },
+            { "id", 0 }
+        };
+
+        JSONRPC::Connection connection;
+        JSONRPC::Request request = JSONRPC::Request::fromJSON(args, json);
+        JSONRPC::Response response = this->processCall(this, request, connection);
+
+        std::string result;
+
+        if (!response.isErrorResponse())
+        {
+            try
+            {
+                result = response.resultProducer()
+                    ? JSONRPC::ResultWriter::collect(response.resultProducer()).dump()
+                    : response.result().dump();
+            }
+            catch (const std::exception& exc)
+            {
+                ofLogError("JSONRPCServer::onHTTPGetEvent") << "Result producer failed: " << exc.what();
+
+                response = JSONRPC::Response(args,
+                                             id,
+                                             JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INTERNAL_ERROR, exc.what(), nullptr));
+            }
+        }
+
+        if (response.isErrorResponse())
+        {
+            // Errors are answered with the caller's id and never cached.
+            buffer = JSONRPC::Response(args, id, response.error()).toString();
+
+            args.response().set("Cache-Control", "no-store");
+            args.response().sendBuffer(buffer.c_str(), buffer.length());
+            return true;  // We attended to the event, so consume it.
+        }
+
+        entry = _resultCache.insert(method, params, result, policy.maxAge());
+    }
+
+    // Cached results are only fresh for the rest of their time to live,
+    // rounded up so that a fraction of a second isn't advertised as zero.
+    auto maxAge = std::chrono::duration_cast<std::chrono::seconds>(entry.expires - JSONRPC::TimerWheel::Clock::now() + std::chrono::seconds(1) - JSONRPC::TimerWheel::Clock::duration(1));
+
+    args.response().set("ETag", entry.etag);
+    args.response().set("Cache-Control", maxAge.count() > 0 ? "public, max-age=" + std::to_string(maxAge.count()) : "no-cache");
+
+    std::string ifNoneMatch = args.request().get("If-None-Match", "");
+
+    if (!ifNoneMatch.empty() && JSONRPC::ResultCache::matchesETag(ifNoneMatch, entry.etag))
+    {
+        args.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED);
+        args.response().setContentLength(0);
+        args.response().send();
+        return true;  // We attended to the event, so consume it.
+    }
+
+    buffer = "{\"jsonrpc\":\"2.0\",\"id\":" + id.dump() + ",\"result\":" + *entry.result + "}";
+
+    args.response().setContentType("application/json");
+    args.response().sendBuffer(buffer.c_str(), buffer.length());
+
+    return true;  // We attended to the event, so consume it.
+}
 
 
 } } // namespace ofx::HTTP
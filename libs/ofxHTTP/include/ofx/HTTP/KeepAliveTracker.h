@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Poco/Net/HTTPServerRequest.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief Counts the requests made on each persistent HTTP connection.
+///
+/// Poco serves the requests of a persistent connection one at a time, in
+/// order, so pipelined requests are answered in the order they were sent as
+/// long as every request receives a complete response. Poco also closes a
+/// connection once it has served
+/// Poco::Net::HTTPServerParams::setMaxKeepAliveRequests() requests; the
+/// tracker only records how often connections are reused.
+///
+/// The metrics are approximate. Poco doesn't expose its connections, so they
+/// are identified by the client's address and port. A new connection that
+/// reuses the port of a closed one before its entry expires is counted as a
+/// reuse, and a connection that closes without a final request is only
+/// forgotten when its entry expires. Entries for connections that have been
+/// idle longer than the idle timeout are removed by the TimerWheel, since the
+/// server will have closed them.
+class KeepAliveTracker
+{
+public:
+    /// \brief A snapshot of the approximate keep-alive counters.
+    struct Metrics
+    {
+        /// \brief The number of requests tracked.
+        uint64_t requests = 0;
+
+        /// \brief The number of connections that made a request.
+        uint64_t connections = 0;
+
+        /// \brief The number of requests that reused a connection.
+        uint64_t reusedRequests = 0;
+
+        /// \brief The number of connections closed after their maximum
+        ///        number of requests.
+        uint64_t closedAtLimit = 0;
+    };
+
+    /// \brief Create a KeepAliveTracker.
+    /// \param timers The wheel that expires idle connection entries.
+    KeepAliveTracker(JSONRPC::TimerWheel& timers);
+
+    /// \brief Destroy the KeepAliveTracker.
+    ~KeepAliveTracker();
+
+    /// \brief Configure the tracker.
+    /// \param maxRequests The maximum number of requests per connection that
+    ///        the server was configured with, or zero for no limit.
+    /// \param idleTimeout The time after which an idle connection is
+    ///        assumed to be closed.
+    void setup(std::size_t maxRequests, std::chrono::milliseconds idleTimeout);
+
+    /// \brief Record a request.
+    /// \param request The request.
+    void track(const Poco::Net::HTTPServerRequest& request);
+
+    /// \returns a snapshot of the counters.
+    Metrics metrics() const;
+
+private:
+    /// \brief The use of a single connection.
+    struct Use
+    {
+        /// \brief The number of requests made on the connection.
+        std::size_t requests = 0;
+
+        /// \brief The time of the most recent request.
+        JSONRPC::TimerWheel::Clock::time_point lastRequest;
+    };
+
+    /// \brief Schedule the next idle check for a connection.
+    /// \param key The connection's client address.
+    void _scheduleExpiry(const std::string& key);
+
+    /// \brief The wheel that expires idle connection entries.
+    JSONRPC::TimerWheel& _timers;
+
+    /// \brief The maximum number of requests per connection.
+    std::size_t _maxRequests = 0;
+
+    /// \brief The idle time after which a connection is assumed closed.
+    std::chrono::milliseconds _idleTimeout;
+
+    /// \brief The open connections, keyed by client address.
+    std::unordered_map<std::string, Use> _uses;
+
+    /// \brief The counters.
+    Metrics _metrics;
+
+    /// \brief A mutex to protect the connections and counters.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include "ofConstants.h"
+
+
+#if !defined(TARGET_WIN32)
+
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief Settings for a PreforkSupervisor.
+class PreforkSettings
+{
+public:
+    /// \brief The number of worker processes.
+    std::size_t workers = 4;
+
+    /// \brief The interval between worker metric reports.
+    std::chrono::milliseconds reportInterval = std::chrono::seconds(1);
+
+    /// \brief Kill and restart workers that have not reported for this long.
+    ///
+    /// Zero disables health checks.
+    std::chrono::milliseconds healthTimeout = std::chrono::seconds(10);
+
+    /// \brief The delay before a crashed worker is first restarted.
+    ///
+    /// The delay doubles each time a worker crashes again before it has
+    /// run for maxRestartDelay, up to maxRestartDelay.
+    std::chrono::milliseconds restartDelay = std::chrono::milliseconds(250);
+
+    /// \brief The maximum delay before a crashed worker is restarted.
+    std::chrono::milliseconds maxRestartDelay = std::chrono::seconds(30);
+
+    /// \brief The time workers are given to exit before they are killed.
+    std::chrono::milliseconds shutdownTimeout = std::chrono::seconds(10);
+};
+
+
+/// \brief The view of a PreforkSupervisor from inside a worker process.
+class PreforkWorker
+{
+public:
+    /// \brief Create a PreforkWorker.
+    /// \param index The index of the worker.
+    /// \param reportFd The pipe reports are written to.
+    /// \param reportInterval The interval between reports.
+    PreforkWorker(std::size_t index,
+                  int reportFd,
+                  std::chrono::milliseconds reportInterval);
+
+    /// \brief Destroy the PreforkWorker.
+    ~PreforkWorker();
+
+    /// \returns the index of the worker, from zero to the number of workers.
+    ///
+    /// A restarted worker keeps the index of the worker it replaces.
+    std::size_t index() const;
+
+    /// \returns true iff the supervisor has asked the worker to stop.
+    bool isStopping() const;
+
+    /// \brief Send metrics to the supervisor.
+    ///
+    /// Each report also tells the supervisor that the worker is healthy.
+    ///
+    /// \param metrics A JSON object of the worker's metrics.
+    /// \returns true iff the report was written.
+    bool report(const ofJson& metrics);
+
+    /// \brief Report metrics periodically until asked to stop.
+    /// \param metrics A function returning the worker's metrics.
+    void run(std::function<ofJson()> metrics);
+
+private:
+    /// \brief The index of the worker.
+    std::size_t _index;
+
+    /// \brief The pipe reports are written to.
+    int _reportFd;
+
+    /// \brief The interval between reports.
+    std::chrono::milliseconds _reportInterval;
+
+};
+
+
+/// \brief Runs a server in several worker processes sharing one port.
+///
+/// Some method handlers are not thread-safe, so a single server can't use
+/// every core. The supervisor forks a number of worker processes, each of
+/// which runs its own JSONRPCServer on the same port:
+///
+/// ~~~{.cpp}
+///     int main()
+///     {
+///         ofx::HTTP::PreforkSupervisor supervisor;
+///
+///         return supervisor.run([](ofx::HTTP::PreforkWorker& worker) {
+///             ofx::HTTP::JSONRPCServer server;
+///             // Register methods ...
+///             server.start();
+///             worker.run([&]() {
+///                 return ofJson({ { "requests", server.keepAliveMetrics().requests } });
+///             });
+///             server.stop();
+///             return 0;
+///         });
+///     }
+/// ~~~
+///
+/// Poco binds server sockets with SO_REUSEPORT, so the workers' listeners
+/// share the port and the kernel balances connections among them. Each
+/// worker has its own method registry, session store and connections.
+///
+/// Workers report metrics over a pipe. A worker that crashes, or stops
+/// reporting for longer than the health timeout, is restarted after a
+/// backoff delay. The supervisor aggregates the latest reports in
+/// metrics().
+///
+/// run() forks, so it should be called before the process starts any
+/// threads. SIGINT and SIGTERM stop the supervisor and its workers.
+class PreforkSupervisor
+{
+public:
+    /// \brief The function run in each worker process.
+    ///
+    /// The function's return value is the worker's exit status.
+    typedef std::function<int(PreforkWorker& worker)> WorkerFunction;
+
+    /// \brief Create a PreforkSupervisor.
+    /// \param settings The supervisor settings.
+    PreforkSupervisor(const PreforkSettings& settings = PreforkSettings());
+
+    /// \brief Destroy the PreforkSupervisor.
+    ~PreforkSupervisor();
+
+    /// \brief Start the workers and supervise them until stopped.
+    /// \param function The function run in each worker process.
+    /// \returns zero in the supervisor once every worker has exited.
+    int run(WorkerFunction function);
+
+    /// \brief Ask the supervisor and its workers to stop.
+    void stop();
+
+    /// \brief Get the aggregated metrics of the workers.
+    ///
+    /// Numeric members of the workers' latest reports are summed in
+    /// `totals`, and each worker's own report is listed in `workers`.
+    ///
+    /// \returns the aggregated metrics.
+    ofJson metrics() const;
+
+private:
+    /// \brief The supervisor's record of a worker process.
+    struct Process
+    {
+        /// \brief The process id, or zero if the worker is not running.
+        pid_t pid = 0;
+
+        /// \brief The read end of the worker's report pipe.
+        int reportFd = -1;
+
+        /// \brief Bytes of an incomplete report.
+        std::string buffer;
+
+        /// \brief The worker's latest metrics.
+        ofJson metrics;
+
+        /// \brief The time the worker was started.
+        std::chrono::steady_clock::time_point started;
+
+        /// \brief The time of the worker's latest report.
+        std::chrono::steady_clock::time_point lastReport;
+
+        /// \brief The time a stopped worker is restarted.
+        std::chrono::steady_clock::time_point restartAt;
+
+        /// \brief The current restart delay.
+        std::chrono::milliseconds restartDelay = std::chrono::milliseconds(0);
+
+        /// \brief The number of times the worker was restarted.
+        std::size_t restarts = 0;
+    };
+
+    /// \brief Fork a worker process.
+    /// \param index The index of the worker.
+    /// \param function The function run in the worker.
+    void _spawn(std::size_t index, const WorkerFunction& function);
+
+    /// \brief Read the reports available from the workers.
+    /// \param timeout The maximum time to wait for a report.
+    void _readReports(std::chrono::milliseconds timeout);
+
+    /// \brief Reap exited workers and schedule their restarts.
+    void _reap();
+
+    /// \brief Kill workers that have stopped reporting.
+    void _checkHealth();
+
+    /// \brief Ask every worker to exit and wait for them.
+    void _shutdown();
+
+    /// \brief The supervisor settings.
+    PreforkSettings _settings;
+
+    /// \brief The worker processes, indexed by worker index.
+    std::vector<Process> _processes;
+
+    /// \brief True iff the supervisor has been asked to stop.
+    std::atomic<bool> _stopping;
+
+    /// \brief A mutex to protect the worker records.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::HTTP
+
+
+#endif
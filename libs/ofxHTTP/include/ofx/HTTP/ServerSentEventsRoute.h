@@ -0,0 +1,169 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "ofx/HTTP/BaseServer.h"
+#include "ofx/JSONRPC/NotificationLog.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief Settings for a ServerSentEventsRoute.
+class ServerSentEventsRouteSettings: public BaseRouteSettings
+{
+public:
+    /// \brief Create ServerSentEventsRouteSettings.
+    /// \param routePathPattern The route path pattern.
+    ServerSentEventsRouteSettings(const std::string& routePathPattern = DEFAULT_EVENTS_ROUTE);
+
+    /// \brief Destroy the ServerSentEventsRouteSettings.
+    virtual ~ServerSentEventsRouteSettings();
+
+    /// \brief Set the number of notifications retained for resuming clients.
+    /// \param bufferSize The number of notifications retained.
+    void setBufferSize(std::size_t bufferSize);
+
+    /// \returns the number of notifications retained for resuming clients.
+    std::size_t getBufferSize() const;
+
+    /// \brief Set the interval between comments sent to quiet clients.
+    ///
+    /// The comments keep intermediaries from closing the stream and detect
+    /// clients that have gone away.
+    ///
+    /// \param heartbeatInterval The heartbeat interval.
+    void setHeartbeatInterval(std::chrono::milliseconds heartbeatInterval);
+
+    /// \returns the interval between comments sent to quiet clients.
+    std::chrono::milliseconds getHeartbeatInterval() const;
+
+    /// \brief Set the delay clients should wait before reconnecting.
+    /// \param retryInterval The reconnection delay.
+    void setRetryInterval(std::chrono::milliseconds retryInterval);
+
+    /// \returns the delay clients should wait before reconnecting.
+    std::chrono::milliseconds getRetryInterval() const;
+
+    /// \brief Set the maximum number of connected clients.
+    ///
+    /// Each client holds a server thread while it is connected. Clients
+    /// beyond the maximum are refused with 503 Service Unavailable.
+    ///
+    /// \param maxClients The maximum number of connected clients.
+    void setMaxClients(std::size_t maxClients);
+
+    /// \returns the maximum number of connected clients.
+    std::size_t getMaxClients() const;
+
+    enum
+    {
+        /// \brief The default maximum number of connected clients.
+        DEFAULT_MAX_CLIENTS = 8
+    };
+
+    /// \brief The default route path pattern.
+    static const std::string DEFAULT_EVENTS_ROUTE;
+
+private:
+    /// \brief The number of notifications retained for resuming clients.
+    std::size_t _bufferSize = JSONRPC::NotificationLog::DEFAULT_CAPACITY;
+
+    /// \brief The interval between comments sent to quiet clients.
+    std::chrono::milliseconds _heartbeatInterval = std::chrono::seconds(15);
+
+    /// \brief The delay clients should wait before reconnecting.
+    std::chrono::milliseconds _retryInterval = std::chrono::seconds(3);
+
+    /// \brief The maximum number of connected clients.
+    std::size_t _maxClients = DEFAULT_MAX_CLIENTS;
+
+};
+
+
+/// \brief A route that streams notifications as Server-Sent Events.
+///
+/// Clients that can't use WebSockets, e.g. a browser EventSource or a
+/// simple HTTP client, receive the JSON-RPC notifications published to the
+/// route as a text/event-stream:
+///
+///     GET /events?topics=room1,room2
+///
+/// Each event's data is a serialized JSON-RPC notification and its id is the
+/// notification's sequence number. Notifications published with an empty
+/// topic are sent to every client; others only to clients that listed their
+/// topic.
+///
+/// A reconnecting client sends the id of the last event it received in the
+/// Last-Event-ID header, or the lastEventId query parameter, and the
+/// retained notifications it missed are sent before new ones. A client that
+/// was away longer than the buffer covers misses the oldest notifications.
+///
+/// Each stream occupies one server thread for as long as the client is
+/// connected, and that thread can't serve other requests meanwhile. The
+/// number of clients is capped with
+/// ServerSentEventsRouteSettings::setMaxClients(), which should be well below
+/// the server's thread limit. Clients over the cap are refused with
+/// 503 Service Unavailable and a Retry-After header.
+class ServerSentEventsRoute: public BaseRoute_<ServerSentEventsRouteSettings>
+{
+public:
+    /// \brief A typedef for ServerSentEventsRouteSettings.
+    typedef ServerSentEventsRouteSettings Settings;
+
+    /// \brief Create a ServerSentEventsRoute.
+    /// \param settings The route settings.
+    ServerSentEventsRoute(const Settings& settings = Settings());
+
+    /// \brief Destroy the ServerSentEventsRoute.
+    virtual ~ServerSentEventsRoute();
+
+    virtual void setup(const Settings& settings) override;
+
+    virtual bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                  bool isSecurePort) const override;
+
+    virtual void handleRequest(ServerEventArgs& evt) override;
+
+    /// \brief End every open event stream.
+    virtual void stop() override;
+
+    /// \brief Publish a serialized notification to the route's clients.
+    /// \param topic The topic, or an empty string for all clients.
+    /// \param message The serialized JSON-RPC notification.
+    /// \returns the event id of the notification.
+    uint64_t publish(const std::string& topic,
+                     JSONRPC::NotificationLog::Message message);
+
+    /// \returns the number of connected clients.
+    std::size_t clients() const;
+
+    /// \brief The name of the query parameter listing a client's topics.
+    static const std::string TOPICS_PARAMETER;
+
+    /// \brief The name of the query parameter resuming a stream.
+    static const std::string LAST_EVENT_ID_PARAMETER;
+
+    /// \brief The name of the header resuming a stream.
+    static const std::string LAST_EVENT_ID_HEADER;
+
+private:
+    /// \brief The notifications retained for resuming clients.
+    JSONRPC::NotificationLog _log;
+
+    /// \brief The number of connected clients.
+    std::atomic<std::size_t> _clients;
+
+};
+
+
+} } // namespace ofx::HTTP
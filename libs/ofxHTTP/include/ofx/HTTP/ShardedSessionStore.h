@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ofx/HTTP/ServerEvents.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief A session stored in a ShardedSessionStore.
+///
+/// Each session has its own lock, so requests for different sessions never
+/// contend with each other.
+class ShardedSession: public AbstractSession
+{
+public:
+    /// \brief Create a ShardedSession.
+    /// \param id The unique session id.
+    ShardedSession(const std::string& id);
+
+    /// \brief Destroy the ShardedSession.
+    virtual ~ShardedSession();
+
+    std::string getId() const override;
+    bool has(const std::string& key) const override;
+    std::string get(const std::string& key,
+                    const std::string& defaultValue) const override;
+    void put(const std::string& key, const std::string& value) override;
+    void remove(const std::string& key) override;
+    void clear() override;
+
+    /// \brief Mark the session as accessed now.
+    ///
+    /// This is a single atomic store and never takes a lock.
+    void touch();
+
+    /// \returns the time at which the session was last accessed.
+    JSONRPC::TimerWheel::Clock::time_point lastAccess() const;
+
+private:
+    /// \brief The session id.
+    const std::string _id;
+
+    /// \brief The session's key value data.
+    std::map<std::string, std::string> _data;
+
+    /// \brief The last access time, in clock ticks.
+    std::atomic<JSONRPC::TimerWheel::Clock::rep> _lastAccess;
+
+    /// \brief A mutex to protect the session data.
+    mutable std::mutex _mutex;
+
+};
+
+
+/// \brief A session store that scales to many concurrent clients.
+///
+/// Sessions are partitioned across a number of shards by a hash of their id.
+/// Each shard has its own lock, so concurrent lookups of different sessions
+/// rarely contend.
+///
+/// Idle sessions are expired by a TimerWheel rather than by periodically
+/// scanning every session. Accessing a session only updates an atomic
+/// timestamp; when a session's expiry timer fires, it is either removed or,
+/// if it was accessed in the meantime, rescheduled for the remaining time.
+///
+/// The ShardedSessionStore is a drop-in replacement for SimpleSessionStore:
+///
+/// ~~~{.cpp}
+///     ofx::HTTP::JSONRPCServer_<ofx::HTTP::ShardedSessionStore> server;
+/// ~~~
+///
+/// Method callbacks access the session via MethodArgs::session(), which
+/// returns a reference to the stored session without copying its data.
+class ShardedSessionStore: public BaseSessionStore
+{
+public:
+    /// \brief Create a ShardedSessionStore.
+    /// \param sessionTimeout The idle time after which a session is removed.
+    /// \param shardCount The number of shards. More shards reduce contention.
+    /// \param sessionKeyName The name of the session cookie.
+    ShardedSessionStore(std::chrono::seconds sessionTimeout = std::chrono::seconds(DEFAULT_SESSION_TIMEOUT_S),
+                        std::size_t shardCount = DEFAULT_SHARD_COUNT,
+                        const std::string& sessionKeyName = DEFAULT_SESSION_KEY_NAME);
+
+    /// \brief Destroy the ShardedSessionStore.
+    virtual ~ShardedSessionStore();
+
+    AbstractSession& getSession(Poco::Net::HTTPServerRequest& request,
+                                Poco::Net::HTTPServerResponse& response) override;
+
+    void destroySession(Poco::Net::HTTPServerRequest& request,
+                        Poco::Net::HTTPServerResponse& response) override;
+
+    /// \brief Fire any session expiry timers that have come due.
+    ///
+    /// This is called automatically on each getSession(), but may also be
+    /// called periodically to expire sessions when the server is idle.
+    void expire();
+
+    /// \returns the number of live sessions.
+    std::size_t size() const;
+
+    enum
+    {
+        /// \brief The default session idle timeout in seconds.
+        DEFAULT_SESSION_TIMEOUT_S = 60 * 30,
+
+        /// \brief The default number of shards.
+        DEFAULT_SHARD_COUNT = 32
+    };
+
+private:
+    /// \brief A single partition of the session map.
+    struct Shard
+    {
+        /// \brief Sessions keyed by id.
+        std::unordered_map<std::string, std::shared_ptr<ShardedSession>> sessions;
+
+        /// \brief A mutex to protect this shard.
+        mutable std::mutex mutex;
+    };
+
+    /// \brief Find the shard for a session id.
+    Shard& _shardFor(const std::string& id);
+
+    /// \brief Find the session id in the request cookies.
+    /// \returns the id or an empty string.
+    std::string _sessionId(const Poco::Net::HTTPServerRequest& request) const;
+
+    /// \brief Schedule an expiry check for a session.
+    void _scheduleExpiry(const std::string& id,
+                         JSONRPC::TimerWheel::Clock::duration delay);
+
+    /// \brief Called by the timer wheel when a session may have expired.
+    void _onExpiry(const std::string& id);
+
+    /// \brief The idle session timeout.
+    JSONRPC::TimerWheel::Clock::duration _sessionTimeout;
+
+    /// \brief The session shards.
+    std::vector<std::unique_ptr<Shard>> _shards;
+
+    /// \brief The wheel driving session expiry.
+    JSONRPC::TimerWheel _wheel;
+
+};
+
+
+} } // namespace ofx::HTTP
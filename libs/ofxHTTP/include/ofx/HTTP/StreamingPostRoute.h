@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <istream>
+#include <string>
+#include "ofEvents.h"
+#include "ofx/HTTP/BaseServer.h"
+#include "ofx/HTTP/ServerEvents.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief The arguments of a streamed POST request.
+///
+/// Unlike PostEventArgs, the body has not been read when the event is
+/// delivered. Listeners read it from stream() as it arrives.
+class StreamingPostEventArgs: public ServerEventArgs
+{
+public:
+    /// \brief Create StreamingPostEventArgs.
+    /// \param evt The arguments of the request.
+    StreamingPostEventArgs(ServerEventArgs& evt);
+
+    /// \brief Destroy the StreamingPostEventArgs.
+    virtual ~StreamingPostEventArgs();
+
+    /// \returns the stream of the request body.
+    std::istream& stream();
+
+};
+
+
+/// \brief The events of a StreamingPostRoute.
+class StreamingPostEvents
+{
+public:
+    /// \brief Notified when a streamed POST request arrives.
+    ofEvent<StreamingPostEventArgs> onHTTPStreamingPostEvent;
+
+};
+
+
+/// \brief Settings for a StreamingPostRoute.
+class StreamingPostRouteSettings: public BaseRouteSettings
+{
+public:
+    /// \brief Create StreamingPostRouteSettings.
+    /// \param routePathPattern The route path pattern.
+    StreamingPostRouteSettings(const std::string& routePathPattern = DEFAULT_POST_ROUTE);
+
+    /// \brief Destroy the StreamingPostRouteSettings.
+    virtual ~StreamingPostRouteSettings();
+
+    /// \brief The default route path pattern, shared with PostRoute.
+    static const std::string DEFAULT_POST_ROUTE;
+
+};
+
+
+/// \brief A route that hands JSON POST bodies to listeners unread.
+///
+/// PostRoute reads the entire body into a buffer before notifying its
+/// listeners. This route claims POST requests with a JSON content type and
+/// notifies listeners before the body is read, so it can be parsed
+/// incrementally from the socket. Other POST requests, e.g. forms and file
+/// uploads, are left to a PostRoute on the same path.
+///
+/// If no listener attends to a request, it is answered with a 400 status.
+class StreamingPostRoute: public BaseRoute_<StreamingPostRouteSettings>
+{
+public:
+    /// \brief A typedef for StreamingPostRouteSettings.
+    typedef StreamingPostRouteSettings Settings;
+
+    /// \brief Create a StreamingPostRoute.
+    /// \param settings The route settings.
+    StreamingPostRoute(const Settings& settings = Settings());
+
+    /// \brief Destroy the StreamingPostRoute.
+    virtual ~StreamingPostRoute();
+
+    virtual bool canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                  bool isSecurePort) const override;
+
+    virtual void handleRequest(ServerEventArgs& evt) override;
+
+    /// \brief Register a listener for streamed POST events.
+    /// \param listener The listener to register.
+    /// \param priority The priority of the listener.
+    template <class ListenerClass>
+    void registerStreamingPostEvents(ListenerClass* listener,
+                                     int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        ofAddListener(events.onHTTPStreamingPostEvent, listener, &ListenerClass::onHTTPStreamingPostEvent, priority);
+    }
+
+    /// \brief Unregister a listener for streamed POST events.
+    /// \param listener The listener to unregister.
+    /// \param priority The priority of the listener.
+    template <class ListenerClass>
+    void unregisterStreamingPostEvents(ListenerClass* listener,
+                                       int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        ofRemoveListener(events.onHTTPStreamingPostEvent, listener, &ListenerClass::onHTTPStreamingPostEvent, priority);
+    }
+
+    /// \brief The route's events.
+    StreamingPostEvents events;
+
+};
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,175 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include "json.hpp"
+#include "ofx/HTTP/ServerEvents.h"
+#include "ofx/HTTP/StreamingPostRoute.h"
+#include "ofx/JSONRPC/MethodRegistry.h"
+#include "ofx/JSONRPC/PendingCalls.h"
+#include "ofx/JSONRPC/Request.h"
+#include "ofx/JSONRPC/TrafficLog.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief Feeds a traffic log captured by a JSONRPCServer back to a target.
+///
+/// Records are delivered one at a time, in the order they were captured,
+/// from the thread calling replay(). The gaps between records are kept,
+/// divided by the speed, so a production capture can be replayed as a
+/// repeatable benchmark or regression workload:
+///
+/// ~~~{.cpp}
+///     ofx::HTTP::TrafficReplayer replayer("capture.jrpclog");
+///     replayer.setSpeed(10);
+///
+///     // Into a running server, over WebSockets and POST requests.
+///     replayer.replay(ofx::HTTP::TrafficReplayer::toServer("localhost", 8197));
+///
+///     // Or directly into a method registry, without any networking.
+///     replayer.replay(replayer.toRegistry(registry));
+/// ~~~
+class TrafficReplayer
+{
+public:
+    /// \brief A function delivering a record to the replay target.
+    ///
+    /// \returns true iff the record was delivered.
+    typedef std::function<bool(const JSONRPC::TrafficRecord& record)> Sink;
+
+    /// \brief The outcome of a replay.
+    struct Result
+    {
+        /// \brief The number of records delivered.
+        uint64_t replayed = 0;
+
+        /// \brief The number of records the target did not accept.
+        uint64_t skipped = 0;
+
+        /// \brief The time the replay took.
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::duration::zero();
+
+        /// \brief The furthest a record fell behind its scheduled time.
+        std::chrono::steady_clock::duration maxLag = std::chrono::steady_clock::duration::zero();
+    };
+
+    /// \brief Create a TrafficReplayer.
+    /// \param path The path of the traffic log.
+    TrafficReplayer(const std::string& path);
+
+    /// \brief Destroy the TrafficReplayer.
+    ~TrafficReplayer();
+
+    /// \brief Set the replay speed.
+    /// \param speed The speed relative to the original traffic, e.g. 1 for
+    ///        the original speed and 10 for ten times faster. Zero replays
+    ///        the records as fast as the target accepts them.
+    void setSpeed(double speed);
+
+    /// \returns the replay speed.
+    double getSpeed() const;
+
+    /// \brief Replay the log.
+    /// \param sink The function delivering each record.
+    /// \returns the outcome of the replay.
+    /// \throws Poco::IOException if the log cannot be opened.
+    /// \throws Poco::DataFormatException if the file is not a traffic log.
+    Result replay(Sink sink);
+
+    /// \brief Stop a replay in progress.
+    void stop();
+
+    /// \brief Deliver records to a server the way they arrived.
+    ///
+    /// WebSocket frames are sent over WebSockets, and each captured
+    /// connection is replayed on a connection of its own. POST bodies are
+    /// sent as JSON POST requests, one at a time on a single keep-alive
+    /// HTTP connection. The server's responses are ignored.
+    ///
+    /// \param host The server's host.
+    /// \param port The server's port.
+    /// \param path The path of the server's WebSocket route.
+    /// \param postPath The path of the server's POST route.
+    /// \returns the sink.
+    static Sink toServer(const std::string& host,
+                         uint16_t port,
+                         const std::string& path = "/",
+                         const std::string& postPath = StreamingPostRouteSettings::DEFAULT_POST_ROUTE);
+
+    /// \brief Deliver records directly to a method registry.
+    ///
+    /// Each message, whether it was a WebSocket frame or a POST body, is
+    /// parsed and processed as a call or notification.
+    /// Responses to server calls are skipped. Method callbacks receive a
+    /// request without a client and a response that discards its output.
+    ///
+    /// \param registry The registry. It must outlive the sink.
+    /// \returns the sink, which must not outlive the replayer.
+    template <typename LockingPolicy>
+    Sink toRegistry(JSONRPC::MethodRegistry_<LockingPolicy>& registry)
+    {
+        return [this, &registry](const JSONRPC::TrafficRecord& record) {
+            ofJson json = ofJson::parse(record.message);
+
+            if (JSONRPC::PendingCalls::isResponse(json))
+            {
+                return false;
+            }
+
+            JSONRPC::Request request = JSONRPC::Request::fromJSON(_event(), json);
+
+            if (request.isNotification())
+            {
+                registry.processNotification(nullptr, request);
+            }
+            else
+            {
+                registry.processCall(nullptr, request);
+            }
+
+            return true;
+        };
+    }
+
+    enum
+    {
+        /// \brief The longest a replay sleeps before checking stop().
+        SLEEP_SLICE_MILLISECONDS = 100
+    };
+
+private:
+    struct Context;
+
+    /// \returns the server event passed to replayed requests.
+    ServerEventArgs& _event();
+
+    /// \brief The path of the traffic log.
+    std::string _path;
+
+    /// \brief The replay speed.
+    std::atomic<double> _speed;
+
+    /// \brief True when the replay in progress should stop.
+    std::atomic<bool> _stopping;
+
+    /// \brief The request, response and session of replayed requests.
+    std::unique_ptr<Context> _context;
+
+};
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include "json.hpp"
+#include "Poco/Net/HTTPClientSession.h"
+#include "Poco/Net/WebSocket.h"
+#include "ofx/JSONRPC/CircuitBreaker.h"
+#include "ofx/JSONRPC/PendingCalls.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+/// \brief A persistent WebSocket connection to a JSONRPC backend.
+///
+/// Calls are written to the socket as soon as they are made, without
+/// waiting for earlier calls to complete, so many calls can be in flight on
+/// one connection. Each call is given an id unique to the connection and
+/// its response is matched by that id, in whatever order the backend
+/// answers.
+///
+/// The connection is opened by the first call and reopened by the first
+/// call after it fails. Calls in flight when the connection fails throw a
+/// JSONRPC::ConnectionClosedException.
+///
+/// Every call's outcome and latency is reported to the connection's
+/// JSONRPC::CircuitBreaker. Calls that fail to connect, time out or are cut
+/// off by a connection failure count as failures. While the breaker is
+/// open, calls fail immediately with a JSONRPC::UnavailableException
+/// instead of waiting on a stalled backend.
+///
+/// UpstreamConnection is thread-safe.
+class UpstreamConnection
+{
+public:
+    /// \brief Create an UpstreamConnection.
+    /// \param host The backend's host.
+    /// \param port The backend's port.
+    /// \param path The path of the backend's WebSocket route.
+    /// \param timers An optional TimerWheel used to enforce call deadlines.
+    ///        The wheel must outlive this connection.
+    /// \param breakerSettings The settings of the connection's circuit
+    ///        breaker.
+    UpstreamConnection(const std::string& host,
+                       uint16_t port,
+                       const std::string& path = "/",
+                       JSONRPC::TimerWheel* timers = nullptr,
+                       const JSONRPC::CircuitBreakerSettings& breakerSettings = JSONRPC::CircuitBreakerSettings());
+
+    /// \brief Destroy the UpstreamConnection, closing it.
+    ~UpstreamConnection();
+
+    /// \brief Call a method on the backend.
+    ///
+    /// The future holds the backend's whole response object, with the id
+    /// assigned by this connection, so that a remote error can be passed on
+    /// unchanged. The future throws a JSONRPC::CallTimeoutException if the
+    /// backend does not answer in time and a
+    /// JSONRPC::ConnectionClosedException if the connection fails.
+    ///
+    /// \param method The method name.
+    /// \param params The method parameters.
+    /// \param timeout The maximum time to wait for the response.
+    /// \param onComplete An optional function called once the future is
+    ///        ready. It may be called before call() returns.
+    /// \returns a future holding the response.
+    std::future<ofJson> call(const std::string& method,
+                             const ofJson& params,
+                             JSONRPC::TimerWheel::Clock::duration timeout,
+                             std::function<void()> onComplete = nullptr);
+
+    /// \brief Send a notification to the backend.
+    ///
+    /// Notifications are not sent while the circuit breaker is open.
+    ///
+    /// \param method The method name.
+    /// \param params The method parameters.
+    /// \returns true iff the notification was sent.
+    bool notify(const std::string& method, const ofJson& params);
+
+    /// \brief Send a serialized message to the backend as is.
+    ///
+    /// Responses to the message are not matched to a call and are ignored.
+    /// Messages are not sent while the circuit breaker is open.
+    ///
+    /// \param message The serialized message.
+    /// \returns true iff the message was sent.
+    bool send(const std::string& message);
+
+    /// \brief Close the connection.
+    ///
+    /// Calls in flight fail with a JSONRPC::ConnectionClosedException. The
+    /// next call reopens the connection.
+    void close();
+
+    /// \returns true iff the connection is open.
+    bool isConnected() const;
+
+    /// \returns the number of calls awaiting a response.
+    std::size_t pending() const;
+
+    /// \returns the connection's circuit breaker.
+    JSONRPC::CircuitBreaker& breaker();
+
+    /// \returns the backend's host.
+    const std::string& host() const;
+
+    /// \returns the backend's port.
+    uint16_t port() const;
+
+    enum
+    {
+        /// \brief The time allowed to open the connection.
+        CONNECT_TIMEOUT_SECONDS = 5,
+        /// \brief How often the reader checks whether it should stop.
+        READ_POLL_MILLISECONDS = 500
+    };
+
+private:
+    /// \brief A call that has been sent and not yet reported to the breaker.
+    struct InFlight
+    {
+        /// \brief The time the call was made.
+        JSONRPC::TimerWheel::Clock::time_point sent;
+
+        /// \brief The time after which the call has timed out.
+        JSONRPC::TimerWheel::Clock::time_point deadline;
+
+        /// \brief The generation of the connection the call was sent on.
+        uint64_t generation = 0;
+
+        /// \brief The breaker's permission for the call.
+        JSONRPC::CircuitBreaker::Ticket ticket;
+    };
+
+    /// \brief Report a completed call to the breaker.
+    /// \param id The id of the call.
+    /// \param success True iff the call succeeded.
+    void _complete(uint64_t id, bool success);
+
+    /// \brief Stop tracking the calls sent on a connection.
+    /// \param generation The generation of the connection.
+    /// \param failed True iff the calls are reported as failures. Otherwise
+    ///        they are reported without an outcome.
+    void _abandon(uint64_t generation, bool failed);
+
+    /// \brief Report the calls that have passed their deadline as failures.
+    ///
+    /// The calls are checked at most every READ_POLL_MILLISECONDS.
+    void _expire();
+
+    /// \brief Send a message, opening the connection if needed.
+    ///
+    /// The caller must hold _mutex.
+    ///
+    /// \param message The serialized message.
+    /// \returns an empty string on success, or a description of the failure.
+    std::string _send(const std::string& message);
+
+    /// \brief Open the connection and start its reader, unless it is open.
+    ///
+    /// The connection is opened without holding _mutex, so a slow backend
+    /// doesn't stall close() or callers whose connection is already open.
+    /// The caller must not hold _mutex.
+    ///
+    /// \returns an empty string on success, or a description of the failure.
+    std::string _connect();
+
+    /// \brief Close the connection and stop its reader.
+    ///
+    /// The caller must hold _mutex.
+    void _disconnect();
+
+    /// \brief Read frames until the connection fails or is closed.
+    /// \param socket The connection's socket.
+    /// \param generation The connection's generation.
+    void _read(std::shared_ptr<Poco::Net::WebSocket> socket,
+               uint64_t generation);
+
+    /// \brief Resolve the calls answered by a message from the backend.
+    /// \param message The message text.
+    /// \param generation The generation of the connection it arrived on.
+    void _receive(const std::string& message, uint64_t generation);
+
+    /// \brief The backend's host.
+    std::string _host;
+
+    /// \brief The backend's port.
+    uint16_t _port;
+
+    /// \brief The path of the backend's WebSocket route.
+    std::string _path;
+
+    /// \brief The calls awaiting a response, owned by connection generation.
+    JSONRPC::PendingCalls _pendingCalls;
+
+    /// \brief The circuit breaker guarding the backend.
+    JSONRPC::CircuitBreaker _breaker;
+
+    /// \brief The calls not yet reported to the breaker, keyed by id.
+    std::unordered_map<uint64_t, InFlight> _inFlight;
+
+    /// \brief The time the calls in flight are next checked for timeouts.
+    JSONRPC::TimerWheel::Clock::time_point _nextExpiry;
+
+    /// \brief A mutex to protect the calls in flight.
+    std::mutex _inFlightMutex;
+
+    /// \brief The HTTP session the socket was opened on.
+    std::unique_ptr<Poco::Net::HTTPClientSession> _session;
+
+    /// \brief The socket, or nullptr if the connection has not been opened.
+    std::shared_ptr<Poco::Net::WebSocket> _socket;
+
+    /// \brief The thread reading responses from the socket.
+    std::thread _reader;
+
+    /// \brief Incremented each time the connection is opened.
+    uint64_t _generation = 0;
+
+    /// \brief True while the current socket is usable.
+    std::atomic<bool> _connected;
+
+    /// \brief True when the current reader should stop.
+    std::atomic<bool> _stopping;
+
+    /// \brief A mutex to protect the connection state.
+    ///
+    /// The reader never takes this mutex, so it may be held while the
+    /// reader is joined.
+    mutable std::mutex _mutex;
+
+    /// \brief A mutex to serialize writes to the socket.
+    std::mutex _sendMutex;
+
+    /// \brief A mutex to serialize attempts to open the connection.
+    std::mutex _connectMutex;
+
+};
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,814 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/Gateway.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <utility>
+#include <vector>
+#include "ofLog.h"
+#include "ofx/JSONRPC/Error.h"
+#include "ofx/JSONRPC/Errors.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+namespace {
+
+
+/// \brief The parameters of a request without any.
+const ofJson noParams;
+
+
+/// \returns the parameters of a request, without copying them.
+const ofJson& paramsOf(const ofJson& request)
+{
+    auto iter = request.find("params");
+    return iter != request.end() ? *iter : noParams;
+}
+
+
+} // namespace
+
+
+Gateway::Gateway(JSONRPC::TimerWheel& timers):
+    _timers(timers),
+    _callTimeout(DEFAULT_CALL_TIMEOUT_MILLISECONDS)
+{
+}
+
+
+Gateway::~Gateway()
+{
+    _cancelOutlierCheck();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (auto& backend: _backends)
+    {
+        backend.second.connection->close();
+    }
+}
+
+
+void Gateway::addBackend(const std::string& name,
+                         const std::string& host,
+                         uint16_t port,
+                         const std::string& path,
+                         std::size_t weight)
+{
+    std::shared_ptr<UpstreamConnection> replaced;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        Backend backend;
+        backend.connection = std::make_shared<UpstreamConnection>(host, port, path, &_timers, _breakerSettings);
+        backend.weight = weight;
+
+        replaced = _backends[name].connection;
+        _backends[name] = backend;
+        _ring.add(name, weight);
+    }
+
+    if (replaced)
+    {
+        replaced->close();
+    }
+}
+
+
+void Gateway::setCircuitBreakerSettings(const JSONRPC::CircuitBreakerSettings& settings)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _breakerSettings = settings;
+}
+
+
+void Gateway::setOutlierDetection(const OutlierDetectionSettings& settings)
+{
+    _cancelOutlierCheck();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _outlierSettings = settings;
+
+    // A concurrent call may have scheduled a check since it was cancelled.
+    if (_outlierTimer != 0)
+    {
+        _timers.cancel(_outlierTimer);
+        _outlierTimer = 0;
+    }
+
+    if (_outlierSettings.interval.count() > 0)
+    {
+        _scheduleOutlierCheck();
+        return;
+    }
+
+    for (auto& backend: _backends)
+    {
+        if (backend.second.ejected)
+        {
+            backend.second.ejected = false;
+            _ring.add(backend.first, backend.second.weight);
+        }
+    }
+}
+
+
+void Gateway::removeBackend(const std::string& name)
+{
+    std::shared_ptr<UpstreamConnection> removed;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _backends.find(name);
+
+        if (iter == _backends.end())
+        {
+            return;
+        }
+
+        removed = iter->second.connection;
+        _backends.erase(iter);
+        _ring.remove(name);
+    }
+
+    removed->close();
+}
+
+
+void Gateway::routePrefix(const std::string& prefix, const std::string& backend)
+{
+    Route route;
+    route.backend = backend;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _routes[prefix] = route;
+}
+
+
+void Gateway::shardBy(const std::string& prefix, const std::string& paramKey)
+{
+    Route route;
+    route.paramKey = paramKey;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _routes[prefix] = route;
+}
+
+
+void Gateway::fanOutPrefix(const std::string& prefix,
+                           const JSONRPC::Reducer& reducer,
+                           std::chrono::milliseconds deadline)
+{
+    Route route;
+    route.reducer = std::make_shared<const JSONRPC::Reducer>(reducer);
+    route.deadline = deadline;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _routes[prefix] = route;
+}
+
+
+void Gateway::removeRoute(const std::string& prefix)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _routes.erase(prefix);
+}
+
+
+void Gateway::setCallTimeout(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _callTimeout = timeout;
+}
+
+
+std::chrono::milliseconds Gateway::getCallTimeout() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _callTimeout;
+}
+
+
+bool Gateway::forward(const std::string& method, JSONRPC::MethodArgs& args)
+{
+    Route route;
+
+    if (!_findRoute(method, route))
+    {
+        return false;
+    }
+
+    if (route.reducer)
+    {
+        args.result = fanOut(method, args.params, *route.reducer, route.deadline);
+        return true;
+    }
+
+    auto upstream = _select(route, method, args.params);
+
+    if (!upstream)
+    {
+        args.error = JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_CONNECTION_CLOSED,
+                                    "No backend is available for " + method + ".",
+                                    ofJson());
+        return true;
+    }
+
+    try
+    {
+        ofJson response = upstream->call(method, args.params, getCallTimeout()).get();
+
+        auto errorIter = response.find("error");
+
+        if (errorIter != response.end())
+        {
+            args.error = JSONRPC::Error::fromJSON(*errorIter);
+        }
+        else
+        {
+            args.result = std::move(response["result"]);
+        }
+    }
+    catch (const JSONRPC::JSONRPCException& exc)
+    {
+        args.error = JSONRPC::Error(exc.code(), exc.message(), ofJson());
+    }
+
+    return true;
+}
+
+
+ofJson Gateway::forwardBatch(const ofJson& batch)
+{
+    /// \brief A request of the batch that was forwarded.
+    struct Forwarded
+    {
+        /// \brief The request's id.
+        ofJson id;
+
+        /// \brief The backend's response.
+        std::future<ofJson> response;
+    };
+
+    ofJson responses = ofJson::array();
+
+    if (!batch.is_array() || batch.empty())
+    {
+        responses.push_back(_errorResponse(nullptr, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_REQUEST)));
+        return responses;
+    }
+
+    // Split the batch by backend, keeping the position of each request so
+    // that the responses can be merged in order.
+    std::map<std::shared_ptr<UpstreamConnection>, std::vector<std::size_t>> shards;
+    std::vector<ofJson> immediate(batch.size());
+    std::map<std::size_t, Route> fanOuts;
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        const ofJson& request = batch[i];
+
+        ofJson id = request.is_object() ? request.value("id", ofJson()) : ofJson();
+
+        if (!request.is_object() || !request.count("method") || !request["method"].is_string())
+        {
+            immediate[i] = _errorResponse(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_INVALID_REQUEST));
+            continue;
+        }
+
+        const std::string& method = request["method"].get_ref<const std::string&>();
+
+        Route route;
+
+        if (!_findRoute(method, route))
+        {
+            if (request.count("id"))
+            {
+                immediate[i] = _errorResponse(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_METHOD_NOT_FOUND));
+            }
+
+            continue;
+        }
+
+        if (route.reducer)
+        {
+            // Fan-out calls wait for their own backends, so they are made
+            // once the rest of the batch is in flight.
+            fanOuts[i] = route;
+            continue;
+        }
+
+        auto upstream = _select(route, method, paramsOf(request));
+
+        if (upstream)
+        {
+            shards[upstream].push_back(i);
+        }
+        else if (request.count("id"))
+        {
+            immediate[i] = _errorResponse(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_CONNECTION_CLOSED));
+        }
+    }
+
+    auto timeout = getCallTimeout();
+
+    std::vector<Forwarded> forwarded(batch.size());
+
+    // Each shard's requests are written back to back without waiting.
+    for (const auto& shard: shards)
+    {
+        for (std::size_t i: shard.second)
+        {
+            const ofJson& request = batch[i];
+            const std::string& method = request["method"].get_ref<const std::string&>();
+            const ofJson& params = paramsOf(request);
+
+            if (request.count("id"))
+            {
+                forwarded[i].id = request["id"];
+                forwarded[i].response = shard.first->call(method, params, timeout);
+            }
+            else
+            {
+                shard.first->notify(method, params);
+            }
+        }
+    }
+
+    for (const auto& call: fanOuts)
+    {
+        const ofJson& request = batch[call.first];
+
+        ofJson result = fanOut(request["method"].get_ref<const std::string&>(),
+                               paramsOf(request),
+                               *call.second.reducer,
+                               call.second.deadline);
+
+        if (request.count("id"))
+        {
+            immediate[call.first] = {
+                { "jsonrpc", "2.0" },
+                { "id", request["id"] },
+                { "result", std::move(result) }
+            };
+        }
+    }
+
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        if (forwarded[i].response.valid())
+        {
+            try
+            {
+                ofJson response = forwarded[i].response.get();
+
+                // The backend's response is passed on with the caller's id.
+                response["id"] = std::move(forwarded[i].id);
+                responses.push_back(std::move(response));
+            }
+            catch (const JSONRPC::JSONRPCException& exc)
+            {
+                responses.push_back(_errorResponse(forwarded[i].id,
+                                                   JSONRPC::Error(exc.code(), exc.message(), ofJson())));
+            }
+        }
+        else if (!immediate[i].is_null())
+        {
+            responses.push_back(std::move(immediate[i]));
+        }
+    }
+
+    return responses;
+}
+
+
+ofJson Gateway::fanOut(const std::string& method,
+                      const ofJson& params,
+                      const JSONRPC::Reducer& reducer,
+                      std::chrono::milliseconds deadline,
+                      const std::vector<std::string>& backends)
+{
+    /// \brief A call to one backend.
+    struct Scattered
+    {
+        /// \brief The name of the backend.
+        std::string backend;
+
+        /// \brief The backend's response.
+        std::future<ofJson> response;
+    };
+
+    /// \brief The indices of the calls that have completed, in the order
+    ///        they completed.
+    ///
+    /// The arrivals are shared with the calls' completion functions, which
+    /// may run after the fan-out has returned.
+    struct Arrivals
+    {
+        /// \brief A mutex to protect the indices.
+        std::mutex mutex;
+
+        /// \brief Notified when a call completes.
+        std::condition_variable arrived;
+
+        /// \brief The indices of the completed calls.
+        std::deque<std::size_t> ready;
+    };
+
+    if (deadline.count() <= 0)
+    {
+        deadline = getCallTimeout();
+    }
+
+    auto expires = JSONRPC::TimerWheel::Clock::now() + deadline;
+
+    ofJson errors = ofJson::object();
+    std::vector<Scattered> pending;
+    std::shared_ptr<Arrivals> arrivals = std::make_shared<Arrivals>();
+
+    {
+        std::vector<std::pair<std::string, std::shared_ptr<UpstreamConnection>>> targets;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            if (backends.empty())
+            {
+                for (const auto& backend: _backends)
+                {
+                    targets.emplace_back(backend.first, backend.second.connection);
+                }
+            }
+            else
+            {
+                for (const auto& name: backends)
+                {
+                    auto iter = _backends.find(name);
+                    targets.emplace_back(name, iter != _backends.end() ? iter->second.connection : nullptr);
+                }
+            }
+        }
+
+        // Every call is sent before any response is awaited.
+        for (auto& target: targets)
+        {
+            if (target.second)
+            {
+                std::size_t index = pending.size();
+
+                pending.push_back({ target.first, target.second->call(method, params, deadline, [arrivals, index]() {
+                    std::unique_lock<std::mutex> lock(arrivals->mutex);
+                    arrivals->ready.push_back(index);
+                    arrivals->arrived.notify_one();
+                }) });
+            }
+            else
+            {
+                errors[target.first] = JSONRPC::Error::toJSON(JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_METHOD_NOT_FOUND,
+                                                                             "Unknown backend.",
+                                                                             ofJson()));
+            }
+        }
+    }
+
+    ofJson result = reducer.initial();
+    std::size_t responses = 0;
+    std::size_t outstanding = pending.size();
+    bool complete = false;
+
+    // Results are reduced in the order they arrive, which a first-N
+    // reducer depends on.
+    while (outstanding > 0 && !complete)
+    {
+        std::size_t index = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(arrivals->mutex);
+
+            if (!arrivals->arrived.wait_until(lock, expires, [&]() { return !arrivals->ready.empty(); }))
+            {
+                break;
+            }
+
+            index = arrivals->ready.front();
+            arrivals->ready.pop_front();
+        }
+
+        Scattered& scattered = pending[index];
+        --outstanding;
+
+        try
+        {
+            ofJson response = scattered.response.get();
+
+            auto errorIter = response.find("error");
+
+            if (errorIter != response.end())
+            {
+                errors[scattered.backend] = std::move(*errorIter);
+            }
+            else
+            {
+                ++responses;
+                complete = reducer.reduce(result, scattered.backend, response["result"]);
+            }
+        }
+        catch (const JSONRPC::JSONRPCException& exc)
+        {
+            errors[scattered.backend] = JSONRPC::Error::toJSON(JSONRPC::Error(exc.code(), exc.message(), ofJson()));
+        }
+    }
+
+    // Backends still pending missed the deadline, unless the reducer was
+    // satisfied without them. Their futures have not been read.
+    if (!complete)
+    {
+        for (const auto& scattered: pending)
+        {
+            if (scattered.response.valid())
+            {
+                errors[scattered.backend] = JSONRPC::Error::toJSON(JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_TIMEOUT));
+            }
+        }
+    }
+
+    return {
+        { "result", std::move(result) },
+        { "complete", complete || errors.empty() },
+        { "responses", responses },
+        { "errors", std::move(errors) }
+    };
+}
+
+
+std::vector<std::string> Gateway::backends() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::vector<std::string> names;
+
+    for (const auto& backend: _backends)
+    {
+        names.push_back(backend.first);
+    }
+
+    return names;
+}
+
+
+ofJson Gateway::metrics() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    ofJson metrics = ofJson::object();
+
+    for (const auto& backend: _backends)
+    {
+        auto breaker = backend.second.connection->breaker().metrics();
+
+        metrics[backend.first] = {
+            { "state", JSONRPC::CircuitBreaker::toString(breaker.state) },
+            { "ejected", backend.second.ejected },
+            { "pending", backend.second.connection->pending() },
+            { "allowed", breaker.allowed },
+            { "refused", breaker.refused },
+            { "failures", breaker.failures },
+            { "trips", breaker.trips },
+            { "averageLatencyMs", std::chrono::duration<double, std::milli>(breaker.averageLatency).count() }
+        };
+    }
+
+    return metrics;
+}
+
+
+std::shared_ptr<UpstreamConnection> Gateway::backend(const std::string& name) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto iter = _backends.find(name);
+
+    return iter != _backends.end() ? iter->second.connection : nullptr;
+}
+
+
+bool Gateway::_findRoute(const std::string& method, Route& route) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // The longest matching prefix sorts last among the prefixes not after
+    // the method, so the routes are searched backward from there.
+    for (auto iter = _routes.upper_bound(method); iter != _routes.begin();)
+    {
+        --iter;
+
+        const std::string& prefix = iter->first;
+
+        if (prefix.empty()
+        || (method.compare(0, prefix.size(), prefix) == 0
+            && (method.size() == prefix.size() || method[prefix.size()] == '.')))
+        {
+            route = iter->second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+std::shared_ptr<UpstreamConnection> Gateway::_select(const Route& route,
+                                                     const std::string& method,
+                                                     const ofJson& params) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::string backend = route.backend;
+
+    if (backend.empty())
+    {
+        auto keyIter = params.is_object() && !route.paramKey.empty()
+                     ? params.find(route.paramKey)
+                     : params.end();
+
+        if (keyIter == params.end())
+        {
+            backend = _ring.find(method);
+        }
+        else if (keyIter->is_string())
+        {
+            backend = _ring.find(keyIter->get_ref<const std::string&>());
+        }
+        else
+        {
+            backend = _ring.find(keyIter->dump());
+        }
+    }
+
+    auto iter = _backends.find(backend);
+
+    return iter != _backends.end() ? iter->second.connection : nullptr;
+}
+
+
+void Gateway::_scheduleOutlierCheck()
+{
+    uint64_t check = ++_outlierCheck;
+
+    _outlierTimer = _timers.schedule(_outlierSettings.interval, [this, check]() {
+        _checkOutliers(check);
+    });
+}
+
+
+void Gateway::_cancelOutlierCheck()
+{
+    JSONRPC::TimerWheel::TimerId timer = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // A check that is already running sees that it is stale.
+        ++_outlierCheck;
+        timer = _outlierTimer;
+        _outlierTimer = 0;
+    }
+
+    // The check takes _mutex, so it is waited for without holding it.
+    if (timer != 0)
+    {
+        _timers.cancelAndWait(timer);
+    }
+}
+
+
+void Gateway::_checkOutliers(uint64_t check)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (check != _outlierCheck)
+    {
+        return;
+    }
+
+    _outlierTimer = 0;
+
+    if (_outlierSettings.interval.count() <= 0)
+    {
+        return;
+    }
+
+    auto now = JSONRPC::TimerWheel::Clock::now();
+
+    std::size_t ejected = 0;
+    std::vector<JSONRPC::TimerWheel::Clock::duration> latencies;
+
+    for (auto& entry: _backends)
+    {
+        Backend& backend = entry.second;
+
+        if (backend.ejected && now >= backend.ejectedUntil)
+        {
+            // The backend returns with a clean slate. Live traffic is its
+            // probe, and if it is still unhealthy it is soon ejected again,
+            // for longer.
+            backend.ejected = false;
+            backend.admittedAt = now;
+            backend.connection->breaker().reset();
+            _ring.add(entry.first, backend.weight);
+
+            ofLogNotice("Gateway::_checkOutliers") << "Returned backend " << entry.first << " to the ring.";
+        }
+        else if (!backend.ejected
+              && backend.ejections > 0
+              && now - backend.admittedAt >= _outlierSettings.ejectionDuration)
+        {
+            backend.ejections = 0;
+        }
+
+        if (backend.ejected)
+        {
+            ++ejected;
+        }
+        else
+        {
+            auto latency = backend.connection->breaker().averageLatency();
+
+            if (latency > JSONRPC::TimerWheel::Clock::duration::zero())
+            {
+                latencies.push_back(latency);
+            }
+        }
+    }
+
+    auto threshold = JSONRPC::TimerWheel::Clock::duration::max();
+
+    if (!latencies.empty() && latencies.size() >= _outlierSettings.minBackends)
+    {
+        auto median = latencies.begin() + latencies.size() / 2;
+        std::nth_element(latencies.begin(), median, latencies.end());
+
+        threshold = std::max(std::chrono::duration_cast<JSONRPC::TimerWheel::Clock::duration>(*median * _outlierSettings.latencyFactor),
+                             std::chrono::duration_cast<JSONRPC::TimerWheel::Clock::duration>(_outlierSettings.minLatency));
+    }
+
+    std::size_t maxEjected = std::size_t(_backends.size() * _outlierSettings.maxEjectedFraction);
+
+    for (auto& entry: _backends)
+    {
+        Backend& backend = entry.second;
+
+        if (ejected >= maxEjected)
+        {
+            break;
+        }
+
+        if (backend.ejected)
+        {
+            continue;
+        }
+
+        const JSONRPC::CircuitBreaker& breaker = backend.connection->breaker();
+
+        bool isOpen = breaker.state() == JSONRPC::CircuitBreaker::STATE_OPEN;
+
+        if (isOpen || breaker.averageLatency() > threshold)
+        {
+            backend.ejections = std::min<std::size_t>(backend.ejections + 1, MAX_EJECTION_MULTIPLIER);
+            backend.ejected = true;
+            backend.ejectedUntil = now + _outlierSettings.ejectionDuration * backend.ejections;
+            _ring.remove(entry.first);
+            ++ejected;
+
+            ofLogWarning("Gateway::_checkOutliers") << "Ejected backend " << entry.first
+                << (isOpen ? ": its circuit breaker is open." : ": its latency is an outlier.");
+        }
+    }
+
+    _scheduleOutlierCheck();
+}
+
+
+ofJson Gateway::_errorResponse(const ofJson& id, const JSONRPC::Error& error)
+{
+    return {
+        { "jsonrpc", "2.0" },
+        { "id", id },
+        { "error", JSONRPC::Error::toJSON(error) }
+    };
+}
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/GetRoute.h"
+#include "Poco/Net/HTTPResponse.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+GetEventArgs::GetEventArgs(ServerEventArgs& evt):
+    ServerEventArgs(evt.request(), evt.response(), evt.session()),
+    _query(Poco::URI(evt.request().getURI()).getQueryParameters())
+{
+}
+
+
+GetEventArgs::~GetEventArgs()
+{
+}
+
+
+const Poco::URI::QueryParameters& GetEventArgs::query() const
+{
+    return _query;
+}
+
+
+std::string GetEventArgs::get(const std::string& name,
+                              const std::string& defaultValue) const
+{
+    for (const auto& parameter: _query)
+    {
+        if (parameter.first == name)
+        {
+            return parameter.second;
+        }
+    }
+
+    return defaultValue;
+}
+
+
+bool GetEventArgs::has(const std::string& name) const
+{
+    for (const auto& parameter: _query)
+    {
+        if (parameter.first == name)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+const std::string GetRouteSettings::DEFAULT_GET_ROUTE = "/rpc";
+
+
+GetRouteSettings::GetRouteSettings(const std::string& routePathPattern):
+    BaseRouteSettings(routePathPattern)
+{
+}
+
+
+GetRouteSettings::~GetRouteSettings()
+{
+}
+
+
+GetRoute::GetRoute(const Settings& settings):
+    BaseRoute_<GetRouteSettings>(settings)
+{
+}
+
+
+GetRoute::~GetRoute()
+{
+}
+
+
+bool GetRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                bool isSecurePort) const
+{
+    return BaseRoute_<GetRouteSettings>::canHandleRequest(request, isSecurePort)
+        && request.getMethod() == Poco::Net::HTTPRequest::HTTP_GET;
+}
+
+
+void GetRoute::handleRequest(ServerEventArgs& evt)
+{
+    GetEventArgs args(evt);
+
+    if (!ofNotifyEvent(events.onHTTPGetEvent, args, this))
+    {
+        evt.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+        evt.response().setContentLength(0);
+        evt.response().send();
+    }
+}
+
+
+} } // namespace ofx::HTTP
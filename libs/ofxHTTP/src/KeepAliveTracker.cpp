@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/KeepAliveTracker.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+KeepAliveTracker::KeepAliveTracker(JSONRPC::TimerWheel& timers):
+    _timers(timers),
+    _idleTimeout(std::chrono::seconds(15))
+{
+}
+
+
+KeepAliveTracker::~KeepAliveTracker()
+{
+}
+
+
+void KeepAliveTracker::setup(std::size_t maxRequests,
+                             std::chrono::milliseconds idleTimeout)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _maxRequests = maxRequests;
+    _idleTimeout = idleTimeout;
+}
+
+
+void KeepAliveTracker::track(const Poco::Net::HTTPServerRequest& request)
+{
+    std::string key = request.clientAddress().toString();
+    bool isNew = false;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        Use& use = _uses[key];
+        isNew = (use.requests == 0);
+
+        ++use.requests;
+        use.lastRequest = JSONRPC::TimerWheel::Clock::now();
+
+        ++_metrics.requests;
+
+        if (isNew)
+        {
+            ++_metrics.connections;
+        }
+        else
+        {
+            ++_metrics.reusedRequests;
+        }
+
+        // The server closes the connection after this response if the
+        // client asked it to or the connection has reached its limit.
+        bool atLimit = _maxRequests > 0 && use.requests >= _maxRequests;
+
+        if (atLimit || !request.getKeepAlive())
+        {
+            if (atLimit)
+            {
+                ++_metrics.closedAtLimit;
+            }
+
+            _uses.erase(key);
+            return;
+        }
+    }
+
+    if (isNew)
+    {
+        _scheduleExpiry(key);
+    }
+}
+
+
+KeepAliveTracker::Metrics KeepAliveTracker::metrics() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _metrics;
+}
+
+
+void KeepAliveTracker::_scheduleExpiry(const std::string& key)
+{
+    std::chrono::milliseconds idleTimeout;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        idleTimeout = _idleTimeout;
+    }
+
+    _timers.schedule(idleTimeout, [this, key]() {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto use = _uses.find(key);
+
+        if (use == _uses.end())
+        {
+            return;
+        }
+
+        if (JSONRPC::TimerWheel::Clock::now() - use->second.lastRequest >= _idleTimeout)
+        {
+            _uses.erase(use);
+            return;
+        }
+
+        lock.unlock();
+
+        _scheduleExpiry(key);
+    });
+}
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,515 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/PreforkSupervisor.h"
+
+
+#if !defined(TARGET_WIN32)
+
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ofLog.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+namespace {
+
+
+/// \brief Set by SIGINT and SIGTERM in the supervisor and in workers.
+volatile std::sig_atomic_t stopRequested = 0;
+
+
+void onStopSignal(int)
+{
+    stopRequested = 1;
+}
+
+
+void handleStopSignals()
+{
+    struct sigaction action = {};
+    action.sa_handler = onStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+
+} // namespace
+
+
+PreforkWorker::PreforkWorker(std::size_t index,
+                             int reportFd,
+                             std::chrono::milliseconds reportInterval):
+    _index(index),
+    _reportFd(reportFd),
+    _reportInterval(reportInterval)
+{
+}
+
+
+PreforkWorker::~PreforkWorker()
+{
+}
+
+
+std::size_t PreforkWorker::index() const
+{
+    return _index;
+}
+
+
+bool PreforkWorker::isStopping() const
+{
+    return stopRequested != 0;
+}
+
+
+bool PreforkWorker::report(const ofJson& metrics)
+{
+    std::string line = metrics.dump() + "\n";
+    std::size_t written = 0;
+
+    while (written < line.size())
+    {
+        ssize_t result = ::write(_reportFd, line.data() + written, line.size() - written);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        written += std::size_t(result);
+    }
+
+    return true;
+}
+
+
+void PreforkWorker::run(std::function<ofJson()> metrics)
+{
+    auto slice = std::max(std::chrono::milliseconds(1),
+                          std::min(_reportInterval, std::chrono::milliseconds(100)));
+    auto nextReport = std::chrono::steady_clock::now();
+
+    while (!isStopping())
+    {
+        if (std::chrono::steady_clock::now() >= nextReport)
+        {
+            // The supervisor has gone away if its pipe is closed.
+            if (!report(metrics ? metrics() : ofJson::object()))
+            {
+                ofLogError("PreforkWorker::run") << "Supervisor is gone, stopping worker " << _index << ".";
+                return;
+            }
+
+            nextReport += _reportInterval;
+        }
+
+        std::this_thread::sleep_for(slice);
+    }
+}
+
+
+PreforkSupervisor::PreforkSupervisor(const PreforkSettings& settings):
+    _settings(settings),
+    _stopping(false)
+{
+}
+
+
+PreforkSupervisor::~PreforkSupervisor()
+{
+}
+
+
+int PreforkSupervisor::run(WorkerFunction function)
+{
+    stopRequested = 0;
+    handleStopSignals();
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _processes.assign(_settings.workers, Process());
+    }
+
+    for (std::size_t i = 0; i < _settings.workers; ++i)
+    {
+        _spawn(i, function);
+    }
+
+    while (!_stopping && !stopRequested)
+    {
+        _readReports(std::chrono::milliseconds(100));
+        _reap();
+        _checkHealth();
+
+        if (_stopping || stopRequested)
+        {
+            break;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 0; i < _processes.size(); ++i)
+        {
+            if (_processes[i].pid == 0 && now >= _processes[i].restartAt)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    ++_processes[i].restarts;
+                }
+
+                _spawn(i, function);
+            }
+        }
+    }
+
+    _shutdown();
+
+    return 0;
+}
+
+
+void PreforkSupervisor::stop()
+{
+    _stopping = true;
+}
+
+
+ofJson PreforkSupervisor::metrics() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto now = std::chrono::steady_clock::now();
+
+    ofJson totals = ofJson::object();
+    ofJson workers = ofJson::array();
+    std::size_t running = 0;
+    std::size_t healthy = 0;
+    std::size_t restarts = 0;
+
+    for (std::size_t i = 0; i < _processes.size(); ++i)
+    {
+        const Process& process = _processes[i];
+
+        bool isHealthy = process.pid != 0
+                      && (_settings.healthTimeout.count() == 0
+                          || now - process.lastReport < _settings.healthTimeout);
+
+        running += process.pid != 0 ? 1 : 0;
+        healthy += isHealthy ? 1 : 0;
+        restarts += process.restarts;
+
+        if (process.pid != 0 && process.metrics.is_object())
+        {
+            for (auto iter = process.metrics.begin(); iter != process.metrics.end(); ++iter)
+            {
+                if (iter.value().is_number_integer())
+                {
+                    int64_t total = totals.value(iter.key(), int64_t(0));
+                    totals[iter.key()] = total + iter.value().get<int64_t>();
+                }
+                else if (iter.value().is_number())
+                {
+                    double total = totals.value(iter.key(), 0.0);
+                    totals[iter.key()] = total + iter.value().get<double>();
+                }
+            }
+        }
+
+        workers.push_back({
+            { "index", i },
+            { "pid", int64_t(process.pid) },
+            { "healthy", isHealthy },
+            { "restarts", process.restarts },
+            { "metrics", process.metrics }
+        });
+    }
+
+    return {
+        { "running", running },
+        { "healthy", healthy },
+        { "restarts", restarts },
+        { "totals", totals },
+        { "workers", workers }
+    };
+}
+
+
+void PreforkSupervisor::_spawn(std::size_t index, const WorkerFunction& function)
+{
+    int fds[2];
+
+    if (::pipe(fds) != 0)
+    {
+        ofLogError("PreforkSupervisor::_spawn") << "Unable to create a report pipe: " << errno;
+        _processes[index].restartAt = std::chrono::steady_clock::now() + _settings.maxRestartDelay;
+        return;
+    }
+
+    pid_t pid = ::fork();
+
+    if (pid < 0)
+    {
+        ofLogError("PreforkSupervisor::_spawn") << "Unable to fork worker " << index << ": " << errno;
+        ::close(fds[0]);
+        ::close(fds[1]);
+        _processes[index].restartAt = std::chrono::steady_clock::now() + _settings.maxRestartDelay;
+        return;
+    }
+
+    if (pid == 0)
+    {
+        // The worker keeps only its own report pipe.
+        ::close(fds[0]);
+
+        for (const auto& process: _processes)
+        {
+            if (process.reportFd >= 0)
+            {
+                ::close(process.reportFd);
+            }
+        }
+
+        stopRequested = 0;
+        handleStopSignals();
+        std::signal(SIGPIPE, SIG_IGN);
+
+        int status = 1;
+
+        try
+        {
+            PreforkWorker worker(index, fds[1], _settings.reportInterval);
+            status = function(worker);
+        }
+        catch (const std::exception& exc)
+        {
+            ofLogError("PreforkSupervisor::_spawn") << "Worker " << index << " failed: " << exc.what();
+        }
+
+        // The supervisor's exit handlers must not run in the worker.
+        std::fflush(nullptr);
+        ::_exit(status);
+    }
+
+    ::close(fds[1]);
+    ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    auto now = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    Process& process = _processes[index];
+    process.pid = pid;
+    process.reportFd = fds[0];
+    process.buffer.clear();
+    process.metrics = nullptr;
+    process.started = now;
+    process.lastReport = now;
+
+    if (process.restartDelay.count() == 0)
+    {
+        process.restartDelay = _settings.restartDelay;
+    }
+
+    ofLogNotice("PreforkSupervisor::_spawn") << "Started worker " << index << " as process " << pid << ".";
+}
+
+
+void PreforkSupervisor::_readReports(std::chrono::milliseconds timeout)
+{
+    std::vector<pollfd> fds;
+
+    for (const auto& process: _processes)
+    {
+        if (process.reportFd >= 0)
+        {
+            fds.push_back({ process.reportFd, POLLIN, 0 });
+        }
+    }
+
+    if (fds.empty())
+    {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+
+    if (::poll(fds.data(), fds.size(), int(timeout.count())) <= 0)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (auto& process: _processes)
+    {
+        if (process.reportFd < 0)
+        {
+            continue;
+        }
+
+        char buffer[4096];
+        ssize_t size = 0;
+
+        while ((size = ::read(process.reportFd, buffer, sizeof(buffer))) > 0)
+        {
+            process.buffer.append(buffer, std::size_t(size));
+        }
+
+        std::size_t end = 0;
+
+        while ((end = process.buffer.find('\n')) != std::string::npos)
+        {
+            try
+            {
+                process.metrics = ofJson::parse(process.buffer.substr(0, end));
+                process.lastReport = std::chrono::steady_clock::now();
+            }
+            catch (const std::exception& exc)
+            {
+                ofLogWarning("PreforkSupervisor::_readReports") << "Invalid report from process " << process.pid << ": " << exc.what();
+            }
+
+            process.buffer.erase(0, end + 1);
+        }
+    }
+}
+
+
+void PreforkSupervisor::_reap()
+{
+    int status = 0;
+    pid_t pid = 0;
+
+    while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto process = std::find_if(_processes.begin(), _processes.end(), [pid](const Process& process) {
+            return process.pid == pid;
+        });
+
+        if (process == _processes.end())
+        {
+            continue;
+        }
+
+        ofLogWarning("PreforkSupervisor::_reap") << "Worker process " << pid << " exited with "
+            << (WIFSIGNALED(status) ? "signal " : "status ")
+            << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status)) << ".";
+
+        auto now = std::chrono::steady_clock::now();
+
+        // A worker that ran for a while is restarted promptly. One that
+        // keeps crashing backs off.
+        if (now - process->started >= _settings.maxRestartDelay)
+        {
+            process->restartDelay = _settings.restartDelay;
+        }
+
+        process->restartAt = now + process->restartDelay;
+        process->restartDelay = std::min(process->restartDelay * 2, _settings.maxRestartDelay);
+
+        ::close(process->reportFd);
+        process->reportFd = -1;
+        process->pid = 0;
+    }
+}
+
+
+void PreforkSupervisor::_checkHealth()
+{
+    if (_settings.healthTimeout.count() == 0)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto now = std::chrono::steady_clock::now();
+
+    for (const auto& process: _processes)
+    {
+        if (process.pid != 0 && now - process.lastReport >= _settings.healthTimeout)
+        {
+            // The worker is reaped and restarted once it has died.
+            ofLogWarning("PreforkSupervisor::_checkHealth") << "Worker process " << process.pid << " stopped reporting, killing it.";
+            ::kill(process.pid, SIGKILL);
+        }
+    }
+}
+
+
+void PreforkSupervisor::_shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        for (const auto& process: _processes)
+        {
+            if (process.pid != 0)
+            {
+                ::kill(process.pid, SIGTERM);
+            }
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + _settings.shutdownTimeout;
+
+    while (true)
+    {
+        _reap();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        bool running = std::any_of(_processes.begin(), _processes.end(), [](const Process& process) {
+            return process.pid != 0;
+        });
+
+        if (!running)
+        {
+            break;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            for (const auto& process: _processes)
+            {
+                if (process.pid != 0)
+                {
+                    ::kill(process.pid, SIGKILL);
+                }
+            }
+        }
+
+        lock.unlock();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+}
+
+
+} } // namespace ofx::HTTP
+
+
+#endif
@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/ServerSentEventsRoute.h"
+#include <algorithm>
+#include <unordered_set>
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/URI.h"
+#include "ofLog.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+const std::string ServerSentEventsRouteSettings::DEFAULT_EVENTS_ROUTE = "/events";
+
+
+ServerSentEventsRouteSettings::ServerSentEventsRouteSettings(const std::string& routePathPattern):
+    BaseRouteSettings(routePathPattern)
+{
+}
+
+
+ServerSentEventsRouteSettings::~ServerSentEventsRouteSettings()
+{
+}
+
+
+void ServerSentEventsRouteSettings::setBufferSize(std::size_t bufferSize)
+{
+    _bufferSize = bufferSize;
+}
+
+
+std::size_t ServerSentEventsRouteSettings::getBufferSize() const
+{
+    return _bufferSize;
+}
+
+
+void ServerSentEventsRouteSettings::setHeartbeatInterval(std::chrono::milliseconds heartbeatInterval)
+{
+    _heartbeatInterval = heartbeatInterval;
+}
+
+
+std::chrono::milliseconds ServerSentEventsRouteSettings::getHeartbeatInterval() const
+{
+    return _heartbeatInterval;
+}
+
+
+void ServerSentEventsRouteSettings::setRetryInterval(std::chrono::milliseconds retryInterval)
+{
+    _retryInterval = retryInterval;
+}
+
+
+std::chrono::milliseconds ServerSentEventsRouteSettings::getRetryInterval() const
+{
+    return _retryInterval;
+}
+
+
+void ServerSentEventsRouteSettings::setMaxClients(std::size_t maxClients)
+{
+    _maxClients = maxClients;
+}
+
+
+std::size_t ServerSentEventsRouteSettings::getMaxClients() const
+{
+    return _maxClients;
+}
+
+
+const std::string ServerSentEventsRoute::TOPICS_PARAMETER = "topics";
+const std::string ServerSentEventsRoute::LAST_EVENT_ID_PARAMETER = "lastEventId";
+const std::string ServerSentEventsRoute::LAST_EVENT_ID_HEADER = "Last-Event-ID";
+
+
+ServerSentEventsRoute::ServerSentEventsRoute(const Settings& settings):
+    BaseRoute_<ServerSentEventsRouteSettings>(settings),
+    _log(settings.getBufferSize()),
+    _clients(0)
+{
+}
+
+
+ServerSentEventsRoute::~ServerSentEventsRoute()
+{
+    _log.release();
+}
+
+
+void ServerSentEventsRoute::setup(const Settings& settings)
+{
+    BaseRoute_<ServerSentEventsRouteSettings>::setup(settings);
+    _log.setCapacity(settings.getBufferSize());
+}
+
+
+bool ServerSentEventsRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                             bool isSecurePort) const
+{
+    return BaseRoute_<ServerSentEventsRouteSettings>::canHandleRequest(request, isSecurePort)
+        && request.getMethod() == Poco::Net::HTTPRequest::HTTP_GET;
+}
+
+
+void ServerSentEventsRoute::handleRequest(ServerEventArgs& evt)
+{
+    std::unordered_set<std::string> topics;
+    std::string lastEventId = evt.request().get(LAST_EVENT_ID_HEADER, "");
+
+    for (const auto& parameter: Poco::URI(evt.request().getURI()).getQueryParameters())
+    {
+        if (parameter.first == TOPICS_PARAMETER)
+        {
+            std::size_t begin = 0;
+
+            while (begin <= parameter.second.size())
+            {
+                std::size_t end = std::min(parameter.second.find(',', begin),
+                                           parameter.second.size());
+
+                if (end > begin)
+                {
+                    topics.insert(parameter.second.substr(begin, end - begin));
+                }
+
+                begin = end + 1;
+            }
+        }
+        else if (parameter.first == LAST_EVENT_ID_PARAMETER && lastEventId.empty())
+        {
+            lastEventId = parameter.second;
+        }
+    }
+
+    uint64_t epoch = _log.epoch();
+    uint64_t cursor = _log.lastId();
+
+    if (!lastEventId.empty())
+    {
+        try
+        {
+            // An id from before a server restart is newer than the log.
+            cursor = std::min<uint64_t>(std::stoull(lastEventId), cursor);
+        }
+        catch (const std::exception&)
+        {
+            ofLogVerbose("ServerSentEventsRoute::handleRequest") << "Ignoring invalid event id: " << lastEventId;
+        }
+    }
+
+    // The slot is claimed before the check, so concurrent clients can't
+    // overshoot the maximum.
+    if (++_clients > settings().getMaxClients())
+    {
+        --_clients;
+
+        auto retryAfter = std::chrono::duration_cast<std::chrono::seconds>(settings().getRetryInterval() + std::chrono::milliseconds(999));
+
+        ofLogWarning("ServerSentEventsRoute::handleRequest") << "Refusing event stream, " << settings().getMaxClients() << " clients are connected.";
+
+        evt.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+        evt.response().set("Retry-After", std::to_string(std::max<long long>(retryAfter.count(), 1)));
+        evt.response().setContentLength(0);
+        evt.response().send();
+        return;
+    }
+
+    evt.response().setContentType("text/event-stream");
+    evt.response().set("Cache-Control", "no-cache");
+    evt.response().setChunkedTransferEncoding(true);
+
+    try
+    {
+        std::ostream& stream = evt.response().send();
+
+        stream << "retry: " << settings().getRetryInterval().count() << "\n\n";
+        stream.flush();
+
+        while (stream.good() && _log.epoch() == epoch)
+        {
+            uint64_t lastId = _log.lastId();
+
+            for (const auto& entry: _log.since(cursor))
+            {
+                if (entry.topic.empty() || topics.find(entry.topic) != topics.end())
+                {
+                    stream << "id: " << entry.id << "\ndata: " << *entry.message << "\n\n";
+                }
+
+                lastId = std::max(lastId, entry.id);
+            }
+
+            cursor = lastId;
+            stream.flush();
+
+            if (!_log.wait(cursor, epoch, settings().getHeartbeatInterval()))
+            {
+                stream << ":\n\n";
+                stream.flush();
+            }
+        }
+    }
+    catch (const std::exception& exc)
+    {
+        // Writes fail once the client has gone away.
+        ofLogVerbose("ServerSentEventsRoute::handleRequest") << "Event stream closed: " << exc.what();
+    }
+
+    --_clients;
+}
+
+
+void ServerSentEventsRoute::stop()
+{
+    _log.release();
+    BaseRoute_<ServerSentEventsRouteSettings>::stop();
+}
+
+
+uint64_t ServerSentEventsRoute::publish(const std::string& topic,
+                                        JSONRPC::NotificationLog::Message message)
+{
+    return _log.publish(topic, std::move(message));
+}
+
+
+std::size_t ServerSentEventsRoute::clients() const
+{
+    return _clients;
+}
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/HTTP/ShardedSessionStore.h"
+#include <algorithm>
+#include "Poco/UUIDGenerator.h"
+#include "Poco/Net/HTTPCookie.h"
+#include "Poco/Net/NameValueCollection.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+ShardedSession::ShardedSession(const std::string& id):
+    _id(id),
+    _lastAccess(JSONRPC::TimerWheel::Clock::now().time_since_epoch().count())
+{
+}
+
+
+ShardedSession::~ShardedSession()
+{
+}
+
+
+std::string ShardedSession::getId() const
+{
+    return _id;
+}
+
+
+bool ShardedSession::has(const std::string& key) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _data.find(key) != _data.end();
+}
+
+
+std::string ShardedSession::get(const std::string& key,
+                                const std::string& defaultValue) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto iter = _data.find(key);
+    return iter != _data.end() ? iter->second : defaultValue;
+}
+
+
+void ShardedSession::put(const std::string& key, const std::string& value)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _data[key] = value;
+}
+
+
+void ShardedSession::remove(const std::string& key)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _data.erase(key);
+}
+
+
+void ShardedSession::clear()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _data.clear();
+}
+
+
+void ShardedSession::touch()
+{
+    _lastAccess.store(JSONRPC::TimerWheel::Clock::now().time_since_epoch().count(),
+                      std::memory_order_relaxed);
+}
+
+
+JSONRPC::TimerWheel::Clock::time_point ShardedSession::lastAccess() const
+{
+    return JSONRPC::TimerWheel::Clock::time_point(JSONRPC::TimerWheel::Clock::duration(_lastAccess.load(std::memory_order_relaxed)));
+}
+
+
+ShardedSessionStore::ShardedSessionStore(std::chrono::seconds sessionTimeout,
+                                         std::size_t shardCount,
+                                         const std::string& sessionKeyName):
+    BaseSessionStore(sessionKeyName),
+    _sessionTimeout(sessionTimeout),
+    _wheel(std::chrono::seconds(1))
+{
+    shardCount = std::max<std::size_t>(1, shardCount);
+
+    for (std::size_t i = 0; i < shardCount; ++i)
+    {
+        _shards.push_back(std::unique_ptr<Shard>(new Shard()));
+    }
+}
+
+
+ShardedSessionStore::~ShardedSessionStore()
+{
+}
+
+
+AbstractSession& ShardedSessionStore::getSession(Poco::Net::HTTPServerRequest& request,
+                                                 Poco::Net::HTTPServerResponse& response)
+{
+    expire();
+
+    std::string id = _sessionId(request);
+
+    if (!id.empty())
+    {
+        Shard& shard = _shardFor(id);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+
+        auto iter = shard.sessions.find(id);
+
+        if (iter != shard.sessions.end())
+        {
+            iter->second->touch();
+            return *iter->second;
+        }
+    }
+
+    id = Poco::UUIDGenerator::defaultGenerator().createRandom().toString();
+
+    std::shared_ptr<ShardedSession> session = std::make_shared<ShardedSession>(id);
+
+    {
+        Shard& shard = _shardFor(id);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.sessions[id] = session;
+    }
+
+    _scheduleExpiry(id, _sessionTimeout);
+
+    Poco::Net::HTTPCookie cookie(getSessionKeyName(), id);
+    cookie.setPath("/");
+    cookie.setHttpOnly(true);
+    response.addCookie(cookie);
+
+    return *session;
+}
+
+
+void ShardedSessionStore::destroySession(Poco::Net::HTTPServerRequest& request,
+                                         Poco::Net::HTTPServerResponse& response)
+{
+    std::string id = _sessionId(request);
+
+    if (!id.empty())
+    {
+        Shard& shard = _shardFor(id);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.sessions.erase(id);
+    }
+
+    // The expiry timer will find the session missing and do nothing.
+
+    Poco::Net::HTTPCookie cookie(getSessionKeyName(), "");
+    cookie.setPath("/");
+    cookie.setMaxAge(0);
+    response.addCookie(cookie);
+}
+
+
+void ShardedSessionStore::expire()
+{
+    _wheel.advance();
+}
+
+
+std::size_t ShardedSessionStore::size() const
+{
+    std::size_t count = 0;
+
+    for (const auto& shard: _shards)
+    {
+        std::unique_lock<std::mutex> lock(shard->mutex);
+        count += shard->sessions.size();
+    }
+
+    return count;
+}
+
+
+ShardedSessionStore::Shard& ShardedSessionStore::_shardFor(const std::string& id)
+{
+    return *_shards[std::hash<std::string>()(id) % _shards.size()];
+}
+
+
+std::string ShardedSessionStore::_sessionId(const Poco::Net::HTTPServerRequest& request) const
+{
+    Poco::Net::NameValueCollection cookies;
+    request.getCookies(cookies);
+    return cookies.get(getSessionKeyName(), "");
+}
+
+
+void ShardedSessionStore::_scheduleExpiry(const std::string& id,
+                                          JSONRPC::TimerWheel::Clock::duration delay)
+{
+    _wheel.schedule(delay, [this, id]() { _onExpiry(id); });
+}
+
+
+void ShardedSessionStore::_onExpiry(const std::string& id)
+{
+    Shard& shard = _shardFor(id);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+
+    auto iter = shard.sessions.find(id);
+
+    if (iter == shard.sessions.end())
+    {
+        return;
+    }
+
+    auto idle = JSONRPC::TimerWheel::Clock::now() - iter->second->lastAccess();
+
+    if (idle >= _sessionTimeout)
+    {
+        shard.sessions.erase(iter);
+    }
+    else
+    {
+        // The session was used since the timer was set; check again later.
+        lock.unlock();
+        _scheduleExpiry(id, _sessionTimeout - idle);
+    }
+}
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/StreamingPostRoute.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/MediaType.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+StreamingPostEventArgs::StreamingPostEventArgs(ServerEventArgs& evt):
+    ServerEventArgs(evt.request(), evt.response(), evt.session())
+{
+}
+
+
+StreamingPostEventArgs::~StreamingPostEventArgs()
+{
+}
+
+
+std::istream& StreamingPostEventArgs::stream()
+{
+    return request().stream();
+}
+
+
+const std::string StreamingPostRouteSettings::DEFAULT_POST_ROUTE = "/post";
+
+
+StreamingPostRouteSettings::StreamingPostRouteSettings(const std::string& routePathPattern):
+    BaseRouteSettings(routePathPattern)
+{
+}
+
+
+StreamingPostRouteSettings::~StreamingPostRouteSettings()
+{
+}
+
+
+StreamingPostRoute::StreamingPostRoute(const Settings& settings):
+    BaseRoute_<StreamingPostRouteSettings>(settings)
+{
+}
+
+
+StreamingPostRoute::~StreamingPostRoute()
+{
+}
+
+
+bool StreamingPostRoute::canHandleRequest(const Poco::Net::HTTPServerRequest& request,
+                                          bool isSecurePort) const
+{
+    return BaseRoute_<StreamingPostRouteSettings>::canHandleRequest(request, isSecurePort)
+        && request.getMethod() == Poco::Net::HTTPRequest::HTTP_POST
+        && Poco::Net::MediaType(request.getContentType()).matches("application", "json");
+}
+
+
+void StreamingPostRoute::handleRequest(ServerEventArgs& evt)
+{
+    StreamingPostEventArgs args(evt);
+
+    if (!ofNotifyEvent(events.onHTTPStreamingPostEvent, args, this))
+    {
+        evt.response().setStatusAndReason(Poco::Net::HTTPResponse::HTTP_BAD_REQUEST);
+        evt.response().setContentLength(0);
+        evt.response().send();
+    }
+}
+
+
+} } // namespace ofx::HTTP
@@ -0,0 +1,312 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/TrafficReplayer.h"
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include "Poco/Net/HTTPClientSession.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/HTTPServerParams.h"
+#include "Poco/Net/HTTPServerRequest.h"
+#include "Poco/Net/HTTPServerResponse.h"
+#include "Poco/Net/SocketAddress.h"
+#include "ofLog.h"
+#include "ofx/HTTP/ShardedSessionStore.h"
+#include "ofx/HTTP/UpstreamConnection.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+namespace {
+
+
+/// \brief A response that discards everything sent on it.
+class ReplayResponse: public Poco::Net::HTTPServerResponse
+{
+public:
+    ReplayResponse(): _stream(nullptr)
+    {
+    }
+
+    void sendContinue() override
+    {
+    }
+
+    std::ostream& send() override
+    {
+        _sent = true;
+        return _stream;
+    }
+
+    void sendFile(const std::string&, const std::string&) override
+    {
+        _sent = true;
+    }
+
+    void sendBuffer(const void*, std::size_t) override
+    {
+        _sent = true;
+    }
+
+    void redirect(const std::string&, HTTPStatus) override
+    {
+        _sent = true;
+    }
+
+    void requireAuthentication(const std::string&) override
+    {
+        _sent = true;
+    }
+
+    bool sent() const override
+    {
+        return _sent;
+    }
+
+private:
+    /// \brief A stream without a buffer, which drops its output.
+    std::ostream _stream;
+
+    bool _sent = false;
+
+};
+
+
+/// \brief A request without a client or a body.
+class ReplayRequest: public Poco::Net::HTTPServerRequest
+{
+public:
+    ReplayRequest(ReplayResponse& response):
+        _response(response),
+        _stream(nullptr),
+        _params(new Poco::Net::HTTPServerParams)
+    {
+    }
+
+    std::istream& stream() override
+    {
+        return _stream;
+    }
+
+    const Poco::Net::SocketAddress& clientAddress() const override
+    {
+        return _address;
+    }
+
+    const Poco::Net::SocketAddress& serverAddress() const override
+    {
+        return _address;
+    }
+
+    const Poco::Net::HTTPServerParams& serverParams() const override
+    {
+        return *_params;
+    }
+
+    Poco::Net::HTTPServerResponse& response() const override
+    {
+        return _response;
+    }
+
+    // Not virtual in every Poco release.
+    bool secure() const
+    {
+        return false;
+    }
+
+private:
+    ReplayResponse& _response;
+
+    /// \brief A stream without a buffer, which is always at its end.
+    std::istream _stream;
+
+    Poco::Net::SocketAddress _address;
+
+    Poco::Net::HTTPServerParams::Ptr _params;
+
+};
+
+
+/// \brief Send a captured POST body and wait for the response.
+/// \param session The session to send on.
+/// \param path The path of the POST route.
+/// \param body The captured body.
+void post(Poco::Net::HTTPClientSession& session,
+          const std::string& path,
+          const std::string& body)
+{
+    Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST,
+                                   path,
+                                   Poco::Net::HTTPMessage::HTTP_1_1);
+    request.setContentType("application/json");
+    request.setContentLength(std::streamsize(body.size()));
+    request.setKeepAlive(true);
+
+    session.sendRequest(request) << body;
+
+    // The response is read to its end so that the session can be reused.
+    Poco::Net::HTTPResponse response;
+    session.receiveResponse(response).ignore(std::numeric_limits<std::streamsize>::max());
+}
+
+
+} // namespace
+
+
+struct TrafficReplayer::Context
+{
+    Context():
+        request(response),
+        session("replay"),
+        event(request, response, session)
+    {
+    }
+
+    ReplayResponse response;
+    ReplayRequest request;
+    ShardedSession session;
+    ServerEventArgs event;
+};
+
+
+TrafficReplayer::TrafficReplayer(const std::string& path):
+    _path(path),
+    _speed(1),
+    _stopping(false),
+    _context(new Context())
+{
+}
+
+
+TrafficReplayer::~TrafficReplayer()
+{
+}
+
+
+void TrafficReplayer::setSpeed(double speed)
+{
+    _speed = std::max(0.0, speed);
+}
+
+
+double TrafficReplayer::getSpeed() const
+{
+    return _speed;
+}
+
+
+TrafficReplayer::Result TrafficReplayer::replay(Sink sink)
+{
+    JSONRPC::TrafficReader reader(_path);
+
+    _stopping = false;
+
+    Result result;
+    JSONRPC::TrafficRecord record;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!_stopping && reader.next(record))
+    {
+        double speed = _speed;
+
+        if (speed > 0)
+        {
+            auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(record.time / speed);
+            auto now = std::chrono::steady_clock::now();
+
+            // Sleep in slices so that a long gap doesn't delay stop().
+            while (!_stopping && now < due)
+            {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, std::chrono::milliseconds(SLEEP_SLICE_MILLISECONDS)));
+                now = std::chrono::steady_clock::now();
+            }
+
+            if (_stopping)
+            {
+                break;
+            }
+
+            result.maxLag = std::max(result.maxLag, now - due);
+        }
+
+        bool delivered = false;
+
+        try
+        {
+            delivered = sink(record);
+        }
+        catch (const std::exception& exc)
+        {
+            ofLogWarning("TrafficReplayer::replay") << "Unable to replay message from connection " << record.connectionId << ": " << exc.what();
+        }
+
+        if (delivered)
+        {
+            ++result.replayed;
+        }
+        else
+        {
+            ++result.skipped;
+        }
+    }
+
+    result.elapsed = std::chrono::steady_clock::now() - start;
+
+    return result;
+}
+
+
+void TrafficReplayer::stop()
+{
+    _stopping = true;
+}
+
+
+TrafficReplayer::Sink TrafficReplayer::toServer(const std::string& host,
+                                                uint16_t port,
+                                                const std::string& path,
+                                                const std::string& postPath)
+{
+    typedef std::map<uint64_t, std::shared_ptr<UpstreamConnection>> Connections;
+
+    auto connections = std::make_shared<Connections>();
+    auto session = std::make_shared<Poco::Net::HTTPClientSession>(host, port);
+
+    return [connections, session, host, port, path, postPath](const JSONRPC::TrafficRecord& record) {
+        if (record.source == JSONRPC::TrafficRecord::SOURCE_POST)
+        {
+            post(*session, postPath, record.message);
+            return true;
+        }
+
+        auto& connection = (*connections)[record.connectionId];
+
+        if (!connection)
+        {
+            connection = std::make_shared<UpstreamConnection>(host, port, path);
+        }
+
+        return connection->send(record.message);
+    };
+}
+
+
+ServerEventArgs& TrafficReplayer::_event()
+{
+    return _context->event;
+}
+
+
+} } // namespace ofx::HTTP
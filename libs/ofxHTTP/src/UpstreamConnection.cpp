@@ -0,0 +1,489 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+#include "ofx/HTTP/UpstreamConnection.h"
+#include <vector>
+#include "Poco/Buffer.h"
+#include "Poco/Net/HTTPRequest.h"
+#include "Poco/Net/HTTPResponse.h"
+#include "Poco/Net/NetException.h"
+#include "ofLog.h"
+#include "ofx/JSONRPC/Request.h"
+
+
+namespace ofx {
+namespace HTTP {
+
+
+UpstreamConnection::UpstreamConnection(const std::string& host,
+                                       uint16_t port,
+                                       const std::string& path,
+                                       JSONRPC::TimerWheel* timers,
+                                       const JSONRPC::CircuitBreakerSettings& breakerSettings):
+    _host(host),
+    _port(port),
+    _path(path),
+    _pendingCalls(timers),
+    _breaker(breakerSettings),
+    _connected(false),
+    _stopping(false)
+{
+}
+
+
+UpstreamConnection::~UpstreamConnection()
+{
+    close();
+}
+
+
+std::future<ofJson> UpstreamConnection::call(const std::string& method,
+                                             const ofJson& params,
+                                             JSONRPC::TimerWheel::Clock::duration timeout,
+                                             std::function<void()> onComplete)
+{
+    uint64_t id = _pendingCalls.nextId();
+
+    std::string message = JSONRPC::Request::toJSON(id, method, params).dump();
+
+    _expire();
+
+    auto start = JSONRPC::TimerWheel::Clock::now();
+
+    JSONRPC::CircuitBreaker::Ticket ticket = _breaker.allow();
+
+    if (!ticket)
+    {
+        std::future<ofJson> result = _pendingCalls.add(id, 0, timeout, std::move(onComplete));
+        _pendingCalls.fail(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_UNAVAILABLE,
+                                              _host + ":" + std::to_string(_port) + ": The circuit breaker is open.",
+                                              ofJson()));
+        return result;
+    }
+
+    std::string failure = _connect();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (failure.empty() && !_connected)
+    {
+        failure = "The connection was closed.";
+    }
+
+    // The call is tracked before it is sent so that a fast response can't
+    // arrive before it.
+    std::future<ofJson> result = _pendingCalls.add(id, _generation, timeout, std::move(onComplete));
+
+    if (failure.empty())
+    {
+        {
+            std::unique_lock<std::mutex> inFlightLock(_inFlightMutex);
+            _inFlight[id] = { start, start + timeout, _generation, ticket };
+        }
+
+        failure = _send(message);
+    }
+    else
+    {
+        _breaker.record(ticket, false, JSONRPC::TimerWheel::Clock::now() - start);
+    }
+
+    if (!failure.empty())
+    {
+        _pendingCalls.fail(id, JSONRPC::Error(JSONRPC::Errors::RPC_ERROR_CONNECTION_CLOSED,
+                                              _host + ":" + std::to_string(_port) + ": " + failure,
+                                              ofJson()));
+    }
+
+    return result;
+}
+
+
+bool UpstreamConnection::notify(const std::string& method, const ofJson& params)
+{
+    return send(JSONRPC::Request::toJSON(nullptr, method, params).dump());
+}
+
+
+bool UpstreamConnection::send(const std::string& message)
+{
+    if (_breaker.state() == JSONRPC::CircuitBreaker::STATE_OPEN)
+    {
+        return false;
+    }
+
+    std::string failure = _connect();
+
+    if (!failure.empty())
+    {
+        ofLogWarning("UpstreamConnection::send") << _host << ":" << _port << ": " << failure;
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    return _connected && _send(message).empty();
+}
+
+
+void UpstreamConnection::close()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _disconnect();
+}
+
+
+bool UpstreamConnection::isConnected() const
+{
+    return _connected;
+}
+
+
+std::size_t UpstreamConnection::pending() const
+{
+    return _pendingCalls.size();
+}
+
+
+JSONRPC::CircuitBreaker& UpstreamConnection::breaker()
+{
+    return _breaker;
+}
+
+
+const std::string& UpstreamConnection::host() const
+{
+    return _host;
+}
+
+
+uint16_t UpstreamConnection::port() const
+{
+    return _port;
+}
+
+
+std::string UpstreamConnection::_send(const std::string& message)
+{
+    try
+    {
+        std::unique_lock<std::mutex> lock(_sendMutex);
+        _socket->sendFrame(message.data(), int(message.size()), Poco::Net::WebSocket::FRAME_TEXT);
+        return std::string();
+    }
+    catch (const Poco::Exception& exc)
+    {
+        // The reader notices the failure too, but calls made until it does
+        // should not be sent to a broken socket.
+        _connected = false;
+        _abandon(_generation, true);
+        _pendingCalls.cancel(_generation);
+        return exc.displayText();
+    }
+}
+
+
+std::string UpstreamConnection::_connect()
+{
+    if (_connected)
+    {
+        return std::string();
+    }
+
+    std::unique_lock<std::mutex> connectLock(_connectMutex);
+
+    // Another caller may have connected while this one waited.
+    if (_connected)
+    {
+        return std::string();
+    }
+
+    std::unique_ptr<Poco::Net::HTTPClientSession> session;
+    std::shared_ptr<Poco::Net::WebSocket> socket;
+
+    try
+    {
+        session.reset(new Poco::Net::HTTPClientSession(_host, _port));
+        session->setTimeout(Poco::Timespan(CONNECT_TIMEOUT_SECONDS, 0));
+
+        Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET,
+                                       _path,
+                                       Poco::Net::HTTPMessage::HTTP_1_1);
+        Poco::Net::HTTPResponse response;
+
+        socket = std::make_shared<Poco::Net::WebSocket>(*session, request, response);
+        socket->setReceiveTimeout(Poco::Timespan(READ_POLL_MILLISECONDS * 1000));
+    }
+    catch (const Poco::Exception& exc)
+    {
+        return exc.displayText();
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _disconnect();
+
+    _session = std::move(session);
+    _socket = socket;
+    ++_generation;
+    _stopping = false;
+    _connected = true;
+    _reader = std::thread(&UpstreamConnection::_read, this, socket, _generation);
+
+    return std::string();
+}
+
+
+void UpstreamConnection::_disconnect()
+{
+    _stopping = true;
+    _connected = false;
+
+    if (_socket)
+    {
+        try
+        {
+            std::unique_lock<std::mutex> lock(_sendMutex);
+            _socket->shutdown();
+        }
+        catch (const Poco::Exception&)
+        {
+            // The socket is already broken.
+        }
+    }
+
+    if (_reader.joinable())
+    {
+        _reader.join();
+    }
+
+    if (_socket)
+    {
+        try
+        {
+            _socket->close();
+        }
+        catch (const Poco::Exception&)
+        {
+        }
+    }
+
+    _socket.reset();
+    _session.reset();
+    _abandon(_generation, false);
+    _pendingCalls.cancel(_generation);
+}
+
+
+void UpstreamConnection::_read(std::shared_ptr<Poco::Net::WebSocket> socket,
+                               uint64_t generation)
+{
+    // Frames of a fragmented message are appended to the buffer until the
+    // final fragment arrives.
+    Poco::Buffer<char> buffer(0);
+
+    try
+    {
+        while (!_stopping)
+        {
+            std::size_t start = buffer.size();
+            int flags = 0;
+            int size = 0;
+
+            try
+            {
+                size = socket->receiveFrame(buffer, flags);
+            }
+            catch (const Poco::TimeoutException&)
+            {
+                _expire();
+                continue;
+            }
+
+            int opcode = flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
+
+            if ((size == 0 && flags == 0) || opcode == Poco::Net::WebSocket::FRAME_OP_CLOSE)
+            {
+                break;
+            }
+            else if (opcode == Poco::Net::WebSocket::FRAME_OP_PING)
+            {
+                std::unique_lock<std::mutex> lock(_sendMutex);
+                socket->sendFrame(buffer.begin() + start,
+                                  size,
+                                  Poco::Net::WebSocket::FRAME_FLAG_FIN | Poco::Net::WebSocket::FRAME_OP_PONG);
+                buffer.resize(start);
+            }
+            else if (opcode == Poco::Net::WebSocket::FRAME_OP_PONG)
+            {
+                buffer.resize(start);
+            }
+            else if (flags & Poco::Net::WebSocket::FRAME_FLAG_FIN)
+            {
+                _receive(std::string(buffer.begin(), buffer.size()), generation);
+                buffer.resize(0);
+            }
+        }
+    }
+    catch (const Poco::Exception& exc)
+    {
+        if (!_stopping)
+        {
+            ofLogWarning("UpstreamConnection::_read") << _host << ":" << _port << ": " << exc.displayText();
+        }
+    }
+
+    // Only the current connection's reader may mark it as failed.
+    bool failed = !_stopping;
+
+    if (failed)
+    {
+        _connected = false;
+    }
+
+    _abandon(generation, failed);
+    _pendingCalls.cancel(generation);
+}
+
+
+void UpstreamConnection::_complete(uint64_t id, bool success)
+{
+    InFlight call;
+
+    {
+        std::unique_lock<std::mutex> lock(_inFlightMutex);
+
+        auto iter = _inFlight.find(id);
+
+        if (iter == _inFlight.end())
+        {
+            return;
+        }
+
+        call = iter->second;
+        _inFlight.erase(iter);
+    }
+
+    _breaker.record(call.ticket, success, JSONRPC::TimerWheel::Clock::now() - call.sent);
+}
+
+
+void UpstreamConnection::_abandon(uint64_t generation, bool failed)
+{
+    std::vector<InFlight> abandoned;
+
+    {
+        std::unique_lock<std::mutex> lock(_inFlightMutex);
+
+        auto iter = _inFlight.begin();
+
+        while (iter != _inFlight.end())
+        {
+            if (iter->second.generation == generation)
+            {
+                abandoned.push_back(iter->second);
+                iter = _inFlight.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    auto now = JSONRPC::TimerWheel::Clock::now();
+
+    for (const auto& call: abandoned)
+    {
+        if (failed)
+        {
+            _breaker.record(call.ticket, false, now - call.sent);
+        }
+        else
+        {
+            _breaker.cancel(call.ticket);
+        }
+    }
+}
+
+
+void UpstreamConnection::_expire()
+{
+    std::vector<InFlight> expired;
+
+    auto now = JSONRPC::TimerWheel::Clock::now();
+
+    {
+        std::unique_lock<std::mutex> lock(_inFlightMutex);
+
+        if (now < _nextExpiry)
+        {
+            return;
+        }
+
+        _nextExpiry = now + std::chrono::milliseconds(READ_POLL_MILLISECONDS);
+
+        auto iter = _inFlight.begin();
+
+        while (iter != _inFlight.end())
+        {
+            if (iter->second.deadline <= now)
+            {
+                expired.push_back(iter->second);
+                iter = _inFlight.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    for (const auto& call: expired)
+    {
+        _breaker.record(call.ticket, false, now - call.sent);
+    }
+}
+
+
+void UpstreamConnection::_receive(const std::string& message, uint64_t generation)
+{
+    ofJson json;
+
+    try
+    {
+        json = ofJson::parse(message);
+    }
+    catch (const std::exception& exc)
+    {
+        ofLogWarning("UpstreamConnection::_receive") << _host << ":" << _port << ": Invalid response: " << exc.what();
+        return;
+    }
+
+    ofJson responses = json.is_array() ? std::move(json) : ofJson::array({ std::move(json) });
+
+    for (auto& response: responses)
+    {
+        if (JSONRPC::PendingCalls::isResponse(response) && response["id"].is_number_unsigned())
+        {
+            uint64_t id = response["id"].get<uint64_t>();
+
+            // A remote error still shows the backend is responsive.
+            _complete(id, true);
+
+            // The whole response is the call's result, so remote errors
+            // reach the caller intact.
+            _pendingCalls.resolve({ { "id", id }, { "result", std::move(response) } }, generation);
+        }
+        else
+        {
+            ofLogVerbose("UpstreamConnection::_receive") << _host << ":" << _port << ": Ignoring " << response.dump();
+        }
+    }
+}
+
+
+} } // namespace ofx::HTTP
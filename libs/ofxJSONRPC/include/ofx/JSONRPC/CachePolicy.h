@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <string>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief The caching policy of a method, read from its description.
+///
+/// A method is idempotent if its description is an object with a true
+/// `x-idempotent` member. Idempotent methods must be free of side effects,
+/// since their calls may be answered from caches or repeated by clients.
+/// Their results must also depend only on the method and its parameters,
+/// never on the caller's session or connection. A result is cached for
+/// every caller and served with `Cache-Control: public`, so a result that
+/// differs per session would be shown to other users. The optional `x-max-age` member gives the number of seconds a result
+/// remains fresh.
+///
+/// ~~~{.json}
+///     {
+///         "description": "Get the text.",
+///         "x-idempotent": true,
+///         "x-max-age": 60
+///     }
+/// ~~~
+///
+/// The members are OpenRPC specification extensions, so they are also
+/// advertised by `rpc.discover`.
+class CachePolicy
+{
+public:
+    /// \brief Create a policy for a method that is not idempotent.
+    CachePolicy();
+
+    /// \brief Read a policy from a method description.
+    /// \param description The method description.
+    explicit CachePolicy(const ofJson& description);
+
+    /// \brief Destroy the CachePolicy.
+    ~CachePolicy();
+
+    /// \returns true iff the method is idempotent.
+    bool isIdempotent() const;
+
+    /// \returns the time a result remains fresh, or zero if results must be
+    ///          revalidated.
+    std::chrono::seconds maxAge() const;
+
+    /// \brief The description member flagging a method as idempotent.
+    static const std::string IDEMPOTENT_KEY;
+
+    /// \brief The description member giving the freshness of results.
+    static const std::string MAX_AGE_KEY;
+
+private:
+    /// \brief True iff the method is idempotent.
+    bool _isIdempotent = false;
+
+    /// \brief The time a result remains fresh.
+    std::chrono::seconds _maxAge;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,226 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Settings for a CircuitBreaker.
+class CircuitBreakerSettings
+{
+public:
+    /// \brief Trip after this many consecutive failed calls.
+    ///
+    /// Zero disables the condition.
+    std::size_t failureThreshold = 5;
+
+    /// \brief Calls that take at least this long are slow.
+    std::chrono::milliseconds slowCallDuration = std::chrono::seconds(2);
+
+    /// \brief Trip after this many consecutive slow calls.
+    ///
+    /// Zero disables the condition.
+    std::size_t slowCallThreshold = 5;
+
+    /// \brief How long a tripped breaker refuses calls before probing.
+    std::chrono::milliseconds openDuration = std::chrono::seconds(5);
+
+    /// \brief The number of probe calls allowed at once while half-open.
+    std::size_t halfOpenProbes = 1;
+
+    /// \brief The number of successful probes needed to close the breaker.
+    std::size_t halfOpenSuccesses = 1;
+
+    /// \brief The weight of each call in the average latency, from 0 to 1.
+    double latencyWeight = 0.2;
+};
+
+
+/// \brief Stops calls to an endpoint that is failing or stalled.
+///
+/// A closed breaker allows every call. It trips open after a number of
+/// consecutive failures, or of consecutive calls slower than a threshold.
+/// An open breaker refuses calls, so callers fail fast instead of piling up
+/// behind a stalled endpoint. After a while the breaker becomes half-open
+/// and allows a few probe calls: if they succeed it closes, and if one
+/// fails it opens again.
+///
+/// Callers ask allow() before each call and report each allowed call's
+/// outcome with record(), passing back the Ticket that allow() returned:
+///
+/// ~~~{.cpp}
+///     CircuitBreaker::Ticket ticket = breaker.allow();
+///
+///     if (ticket)
+///     {
+///         auto start = CircuitBreaker::Clock::now();
+///         bool success = send();
+///         breaker.record(ticket, success, CircuitBreaker::Clock::now() - start);
+///     }
+/// ~~~
+///
+/// Each change of state starts a new epoch. Outcomes of calls allowed in an
+/// earlier epoch are ignored, so a call that was allowed before the breaker
+/// tripped and completes late can't close or re-trip it.
+///
+/// CircuitBreaker is thread-safe.
+class CircuitBreaker
+{
+public:
+    /// \brief The clock used to measure calls.
+    typedef TimerWheel::Clock Clock;
+
+    /// \brief The states of a breaker.
+    enum State
+    {
+        /// \brief Calls are allowed.
+        STATE_CLOSED,
+        /// \brief Calls are refused.
+        STATE_OPEN,
+        /// \brief A few probe calls are allowed.
+        STATE_HALF_OPEN
+    };
+
+    /// \brief The permission to make one call.
+    struct Ticket
+    {
+        /// \brief The epoch the call was allowed in, or zero if it was
+        ///        refused.
+        uint64_t epoch = 0;
+
+        /// \brief True iff the call is a half-open probe.
+        bool probe = false;
+
+        /// \returns true iff the call was allowed.
+        explicit operator bool() const
+        {
+            return epoch != 0;
+        }
+    };
+
+    /// \brief A snapshot of a breaker's counters.
+    struct Metrics
+    {
+        /// \brief The current state.
+        State state = STATE_CLOSED;
+
+        /// \brief The number of calls allowed.
+        uint64_t allowed = 0;
+
+        /// \brief The number of calls refused.
+        uint64_t refused = 0;
+
+        /// \brief The number of failed calls.
+        uint64_t failures = 0;
+
+        /// \brief The number of times the breaker tripped.
+        uint64_t trips = 0;
+
+        /// \brief The moving average latency of completed calls.
+        Clock::duration averageLatency = Clock::duration::zero();
+    };
+
+    /// \brief Create a closed CircuitBreaker.
+    /// \param settings The breaker settings.
+    CircuitBreaker(const CircuitBreakerSettings& settings = CircuitBreakerSettings());
+
+    /// \brief Destroy the CircuitBreaker.
+    ~CircuitBreaker();
+
+    /// \brief Ask to make a call.
+    ///
+    /// A call that is allowed must be reported with record() or cancel().
+    ///
+    /// \returns a ticket that converts to true iff the call may be made.
+    Ticket allow();
+
+    /// \brief Report the outcome of an allowed call.
+    /// \param ticket The ticket returned by allow().
+    /// \param success True iff the call succeeded.
+    /// \param latency The time the call took.
+    void record(const Ticket& ticket, bool success, Clock::duration latency);
+
+    /// \brief Report that an allowed call ended without an outcome.
+    ///
+    /// A probe that is cancelled lets another probe through.
+    ///
+    /// \param ticket The ticket returned by allow().
+    void cancel(const Ticket& ticket);
+
+    /// \brief Close the breaker and clear its failure counts and average
+    ///        latency.
+    void reset();
+
+    /// \returns the current state.
+    State state() const;
+
+    /// \returns the moving average latency of completed calls.
+    Clock::duration averageLatency() const;
+
+    /// \returns a snapshot of the breaker's counters.
+    Metrics metrics() const;
+
+    /// \param state The state.
+    /// \returns the name of the state.
+    static std::string toString(State state);
+
+private:
+    /// \brief Open the breaker.
+    ///
+    /// The caller must hold _mutex.
+    ///
+    /// \param now The current time.
+    void _trip(Clock::time_point now);
+
+    /// \brief Change the state and start a new epoch.
+    ///
+    /// The caller must hold _mutex.
+    ///
+    /// \param state The new state.
+    void _enter(State state);
+
+    /// \brief The breaker settings.
+    CircuitBreakerSettings _settings;
+
+    /// \brief The counters and the current state.
+    Metrics _metrics;
+
+    /// \brief The number of consecutive failed calls.
+    std::size_t _consecutiveFailures = 0;
+
+    /// \brief The number of consecutive slow calls.
+    std::size_t _consecutiveSlowCalls = 0;
+
+    /// \brief The current epoch, advanced on every change of state.
+    uint64_t _epoch = 1;
+
+    /// \brief The number of probe calls in flight while half-open.
+    std::size_t _probes = 0;
+
+    /// \brief The number of successful probes while half-open.
+    std::size_t _probeSuccesses = 0;
+
+    /// \brief The time an open breaker becomes half-open.
+    Clock::time_point _openUntil;
+
+    /// \brief A mutex to protect the state.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,308 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "json.hpp"
+#include "ofx/HTTP/WebSocketConnection.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A lightweight, reference-counted handle to a client connection.
+///
+/// Connection handles are cheap to copy and are safe to keep after the method
+/// call that produced them has returned, e.g. to push notifications to the
+/// client later. Once the underlying connection closes, isOpen() returns
+/// false and any attempt to send is ignored.
+///
+/// A default constructed Connection is empty. Calls that arrive via a POST
+/// request have an empty Connection, since there is no persistent connection
+/// to address.
+///
+/// Each connection may have an outbound budget limiting the number of bytes
+/// queued for sending. A send that would exceed the budget is dropped and the
+/// client is asked to close the connection, so a slow or stalled client can't
+/// exhaust the server's memory.
+class Connection
+{
+public:
+    /// \brief A base for state attached to a connection, e.g. by a registry.
+    class Attachment
+    {
+    public:
+        virtual ~Attachment()
+        {
+        }
+    };
+
+    /// \brief Create an empty Connection.
+    Connection();
+
+    /// \brief Create a Connection for a WebSocket.
+    /// \param id A unique id for this connection.
+    /// \param connection The WebSocket connection to wrap.
+    Connection(uint64_t id, HTTP::WebSocketConnection& connection);
+
+    /// \brief Destroy the Connection handle.
+    ~Connection();
+
+    /// \returns the unique id of this connection, or 0 if empty.
+    uint64_t id() const;
+
+    /// \returns true iff the underlying connection is still open.
+    bool isOpen() const;
+
+    /// \brief Send a text frame to the client.
+    /// \param text The text to send.
+    /// \returns true iff the connection is open and the frame was queued.
+    bool send(const std::string& text) const;
+
+    /// \brief Send a pre-encoded frame to the client.
+    /// \param frame The frame to send.
+    /// \returns true iff the connection is open and the frame was queued.
+    bool send(const HTTP::WebSocketFrame& frame) const;
+
+    /// \brief Send a JSONRPC notification to the client.
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns true iff the connection is open and the frame was queued.
+    bool notify(const std::string& method, const ofJson& params = nullptr) const;
+
+    /// \brief Send a WebSocket ping to the client.
+    /// \returns true iff the connection is open and the ping was queued.
+    bool ping() const;
+
+    /// \brief Ask the client to close the connection.
+    ///
+    /// A WebSocket close frame is sent. The handle is detached when the
+    /// server receives the close event.
+    ///
+    /// \returns true iff the connection is open and the frame was queued.
+    bool disconnect() const;
+
+    /// \brief Set the maximum number of bytes that may be queued for sending.
+    /// \param bytes The budget in bytes, or zero for no limit.
+    void setOutboundBudget(std::size_t bytes) const;
+
+    /// \returns the outbound budget in bytes, or zero if unlimited.
+    std::size_t outboundBudget() const;
+
+    /// \returns the number of bytes queued for sending.
+    std::size_t queuedBytes() const;
+
+    /// \brief Record that queued bytes have been sent.
+    ///
+    /// This is called by the server for every frame sent on the connection.
+    ///
+    /// \param bytes The number of bytes sent.
+    void sent(std::size_t bytes) const;
+
+    /// \brief Record activity on the connection.
+    ///
+    /// This is a single atomic store and is called by the server for every
+    /// frame received from the client.
+    void touch() const;
+
+    /// \returns the time of the last recorded activity.
+    std::chrono::steady_clock::time_point lastActivity() const;
+
+    /// \brief Attach state to the connection, replacing any previous state.
+    ///
+    /// The attachment is shared by all copies of this handle and can be read
+    /// without locking. Attaching to an empty handle has no effect.
+    ///
+    /// \param attachment The state to attach, or nullptr to clear it.
+    void attach(std::shared_ptr<const Attachment> attachment) const;
+
+    /// \returns the attached state, or nullptr if none.
+    std::shared_ptr<const Attachment> attachment() const;
+
+    /// \brief Detach the handle from the underlying connection.
+    ///
+    /// This is called by the server when the connection closes. All copies
+    /// of this handle will report isOpen() == false afterwards and the
+    /// attached state is released.
+    void close();
+
+    /// \returns true iff this handle refers to a connection.
+    explicit operator bool() const;
+
+    bool operator == (const Connection& other) const;
+    bool operator != (const Connection& other) const;
+
+private:
+    /// \brief The state shared between all copies of a handle.
+    struct State
+    {
+        State(uint64_t id, HTTP::WebSocketConnection* connection);
+
+        /// \brief The unique connection id.
+        const uint64_t id;
+
+        /// \brief True while the connection is open.
+        std::atomic<bool> open;
+
+        /// \brief The WebSocket, or nullptr once closed.
+        HTTP::WebSocketConnection* connection;
+
+        /// \brief The time of the last activity, in clock ticks.
+        std::atomic<std::chrono::steady_clock::rep> lastActivity;
+
+        /// \brief A mutex to protect the connection pointer while sending.
+        std::mutex mutex;
+
+        /// \brief The attached state, accessed atomically.
+        std::shared_ptr<const Attachment> attachment;
+
+        /// \brief The maximum number of queued bytes, or zero if unlimited.
+        std::atomic<std::size_t> outboundBudget;
+
+        /// \brief The number of bytes queued for sending.
+        std::atomic<std::size_t> queuedBytes;
+    };
+
+    /// \brief Queue a frame, enforcing the outbound budget.
+    /// \param frame The frame to send.
+    /// \param size The number of bytes to account for.
+    /// \returns true iff the connection is open and the frame was queued.
+    bool _send(const HTTP::WebSocketFrame& frame, std::size_t size) const;
+
+    /// \brief The shared state, or nullptr if empty.
+    std::shared_ptr<State> _state;
+
+};
+
+
+/// \brief A thread-safe index of open connections.
+///
+/// Connections can be found by id or by their underlying WebSocket in
+/// constant time. Connections may also join any number of named groups
+/// (e.g. all screens in one gallery room). Joining and leaving a group are
+/// constant time operations, and a connection leaves all of its groups when
+/// it is removed.
+///
+/// Broadcasts serialize their message once and send the same encoded frame
+/// to every recipient.
+class ConnectionRegistry
+{
+public:
+    /// \brief Create an empty ConnectionRegistry.
+    ConnectionRegistry();
+
+    /// \brief Destroy the ConnectionRegistry, closing all handles.
+    ~ConnectionRegistry();
+
+    /// \brief Add a WebSocket to the registry.
+    ///
+    /// If the WebSocket is already registered, its existing handle is
+    /// returned.
+    ///
+    /// \param connection The WebSocket to add.
+    /// \returns the handle for the WebSocket.
+    Connection add(HTTP::WebSocketConnection& connection);
+
+    /// \brief Remove a WebSocket from the registry and close its handle.
+    /// \param connection The WebSocket to remove.
+    /// \returns the closed handle, or an empty handle if not found.
+    Connection remove(const HTTP::WebSocketConnection& connection);
+
+    /// \brief Find the handle for a WebSocket.
+    /// \param connection The WebSocket to find.
+    /// \returns the handle, or an empty handle if not found.
+    Connection find(const HTTP::WebSocketConnection& connection) const;
+
+    /// \brief Find a handle by connection id.
+    /// \param id The connection id to find.
+    /// \returns the handle, or an empty handle if not found.
+    Connection find(uint64_t id) const;
+
+    /// \returns a snapshot of all open connections.
+    std::vector<Connection> connections() const;
+
+    /// \returns the number of open connections.
+    std::size_t size() const;
+
+    /// \brief Add a connection to a named group.
+    /// \param group The name of the group.
+    /// \param connection The connection to add.
+    /// \returns true iff the connection is registered and was not already
+    ///          a member of the group.
+    bool join(const std::string& group, const Connection& connection);
+
+    /// \brief Remove a connection from a named group.
+    /// \param group The name of the group.
+    /// \param connection The connection to remove.
+    /// \returns true iff the connection was a member of the group.
+    bool leave(const std::string& group, const Connection& connection);
+
+    /// \brief Get a snapshot of the members of a group.
+    /// \param group The name of the group.
+    /// \returns the connections in the group.
+    std::vector<Connection> members(const std::string& group) const;
+
+    /// \brief Send a notification to every open connection.
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns the number of connections the notification was queued on.
+    std::size_t broadcast(const std::string& method,
+                          const ofJson& params = nullptr) const;
+
+    /// \brief Send a notification to every member of a group.
+    /// \param group The name of the group.
+    /// \param method The name of the client method.
+    /// \param params The parameters to pass to the client method.
+    /// \returns the number of connections the notification was queued on.
+    std::size_t broadcast(const std::string& group,
+                          const std::string& method,
+                          const ofJson& params) const;
+
+    /// \brief Send a pre-encoded frame to a set of connections.
+    /// \param connections The recipients.
+    /// \param frame The encoded frame to send to each recipient.
+    /// \returns the number of connections the frame was queued on.
+    static std::size_t broadcast(const std::vector<Connection>& connections,
+                                 const HTTP::WebSocketFrame& frame);
+
+private:
+    /// \brief A group of connections keyed by id.
+    typedef std::unordered_map<uint64_t, Connection> Group;
+
+    /// \brief The last connection id issued.
+    uint64_t _lastId = 0;
+
+    /// \brief Connections keyed by their WebSocket.
+    std::unordered_map<const HTTP::WebSocketConnection*, Connection> _bySocket;
+
+    /// \brief Connections keyed by id.
+    std::unordered_map<uint64_t, Connection> _byId;
+
+    /// \brief Groups keyed by name.
+    std::unordered_map<std::string, Group> _groups;
+
+    /// \brief The names of the groups each connection id belongs to.
+    std::unordered_map<uint64_t, std::unordered_set<std::string>> _memberships;
+
+    /// \brief A mutex to protect the indices.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -48,6 +48,18 @@ public:
     /// \brief Parse Error.
     static const int RPC_ERROR_PARSE;
 
+    /// \brief A remote call did not receive a response before its deadline.
+    static const int RPC_ERROR_TIMEOUT;
+
+    /// \brief A remote call was abandoned because its connection closed.
+    static const int RPC_ERROR_CONNECTION_CLOSED;
+
+    /// \brief A message exceeded a configured size or complexity limit.
+    static const int RPC_ERROR_LIMIT_EXCEEDED;
+
+    /// \brief A call was refused because its endpoint is unavailable.
+    static const int RPC_ERROR_UNAVAILABLE;
+
 };
 
 
@@ -80,6 +92,26 @@ POCO_DECLARE_EXCEPTION_CODE(,
                             ParseException,
                             JSONRPCException,
                             Errors::RPC_ERROR_PARSE)
+
+POCO_DECLARE_EXCEPTION_CODE(,
+                            CallTimeoutException,
+                            JSONRPCException,
+                            Errors::RPC_ERROR_TIMEOUT)
+
+POCO_DECLARE_EXCEPTION_CODE(,
+                            ConnectionClosedException,
+                            JSONRPCException,
+                            Errors::RPC_ERROR_CONNECTION_CLOSED)
+
+POCO_DECLARE_EXCEPTION_CODE(,
+                            LimitExceededException,
+                            JSONRPCException,
+                            Errors::RPC_ERROR_LIMIT_EXCEEDED)
+
+POCO_DECLARE_EXCEPTION_CODE(,
+                            UnavailableException,
+                            JSONRPCException,
+                            Errors::RPC_ERROR_UNAVAILABLE)
     
 
 } } // namespace ofx::JSONRPC
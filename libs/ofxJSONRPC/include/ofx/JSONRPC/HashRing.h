@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A consistent hash ring mapping keys to named nodes.
+///
+/// Each node is placed on the ring at a number of pseudo-random points
+/// proportional to its weight. A key belongs to the first node point at or
+/// after the key's hash. Adding or removing a node only moves the keys that
+/// hash next to its points, so most keys keep their node.
+///
+/// HashRing is not thread-safe.
+class HashRing
+{
+public:
+    /// \brief Create an empty HashRing.
+    /// \param replicas The number of points per unit of node weight.
+    HashRing(std::size_t replicas = DEFAULT_REPLICAS);
+
+    /// \brief Destroy the HashRing.
+    ~HashRing();
+
+    /// \brief Add a node, replacing any node of the same name.
+    /// \param node The name of the node.
+    /// \param weight The relative share of keys the node receives.
+    void add(const std::string& node, std::size_t weight = 1);
+
+    /// \brief Remove a node.
+    /// \param node The name of the node.
+    void remove(const std::string& node);
+
+    /// \brief Find the node a key belongs to.
+    /// \param key The key.
+    /// \returns the name of the node, or an empty string if the ring is
+    ///          empty.
+    std::string find(const std::string& key) const;
+
+    /// \param node The name of the node.
+    /// \returns true iff the node is on the ring.
+    bool has(const std::string& node) const;
+
+    /// \returns the names of the nodes on the ring.
+    std::vector<std::string> nodes() const;
+
+    /// \returns true iff the ring has no nodes.
+    bool empty() const;
+
+    enum
+    {
+        /// \brief The default number of points per unit of node weight.
+        DEFAULT_REPLICAS = 160
+    };
+
+private:
+    /// \brief Hash a string to a point on the ring.
+    /// \param value The string to hash.
+    /// \returns the point.
+    static uint64_t _point(const std::string& value);
+
+    /// \brief The number of points per unit of node weight.
+    std::size_t _replicas;
+
+    /// \brief Maps points to node names.
+    std::map<uint64_t, std::string> _ring;
+
+    /// \brief Maps node names to their weights.
+    std::map<std::string, std::size_t> _weights;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A locking policy that performs no synchronization.
+///
+/// Use this policy when all access happens on a single thread, e.g. an
+/// application that only dispatches from the main thread or from a single
+/// reactor thread. Reads and writes compile to direct access.
+class NullLockingPolicy
+{
+public:
+    /// \brief A value guarded by this policy.
+    template <typename ValueType>
+    class Guarded
+    {
+    public:
+        /// \brief Invoke a function with read access to the value.
+        /// \param function A function taking a const ValueType&.
+        /// \returns the result of the function.
+        template <typename Function>
+        auto read(Function&& function) const -> decltype(function(std::declval<const ValueType&>()))
+        {
+            return function(_value);
+        }
+
+        /// \brief Invoke a function with write access to the value.
+        /// \param function A function taking a ValueType&.
+        template <typename Function>
+        void write(Function&& function)
+        {
+            function(_value);
+        }
+
+    private:
+        /// \brief The guarded value.
+        ValueType _value;
+
+    };
+
+};
+
+
+/// \brief A locking policy that guards all access with a mutex.
+///
+/// Readers hold the mutex for the duration of the read function, so work done
+/// inside a read is serialized with all other reads and writes.
+class MutexLockingPolicy
+{
+public:
+    /// \brief A value guarded by this policy.
+    template <typename ValueType>
+    class Guarded
+    {
+    public:
+        /// \brief Invoke a function with read access to the value.
+        /// \param function A function taking a const ValueType&.
+        /// \returns the result of the function.
+        template <typename Function>
+        auto read(Function&& function) const -> decltype(function(std::declval<const ValueType&>()))
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return function(_value);
+        }
+
+        /// \brief Invoke a function with write access to the value.
+        /// \param function A function taking a ValueType&.
+        template <typename Function>
+        void write(Function&& function)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            function(_value);
+        }
+
+    private:
+        /// \brief The guarded value.
+        ValueType _value;
+
+        /// \brief A mutex to protect the value.
+        mutable std::mutex _mutex;
+
+    };
+
+};
+
+
+/// \brief A read-copy-update locking policy.
+///
+/// Readers take an immutable snapshot of the value with std::atomic_load and
+/// then run without any lock, so calls may run concurrently with each other
+/// and with writers. The load itself is not lock-free: libstdc++ implements
+/// the shared_ptr atomics with a small pool of spinlocks, held only for the
+/// pointer copy. Writers are serialized, copy the current value, modify the
+/// copy and atomically publish it. A snapshot remains valid for as long as a
+/// reader holds it.
+///
+/// This policy suits values that are read far more often than they are
+/// written, such as a method registry after startup.
+class RCULockingPolicy
+{
+public:
+    /// \brief A value guarded by this policy.
+    template <typename ValueType>
+    class Guarded
+    {
+    public:
+        Guarded(): _value(std::make_shared<const ValueType>())
+        {
+        }
+
+        /// \brief Invoke a function with read access to a snapshot.
+        /// \param function A function taking a const ValueType&.
+        /// \returns the result of the function.
+        template <typename Function>
+        auto read(Function&& function) const -> decltype(function(std::declval<const ValueType&>()))
+        {
+            std::shared_ptr<const ValueType> snapshot = std::atomic_load(&_value);
+            return function(*snapshot);
+        }
+
+        /// \brief Invoke a function with write access to a copy of the value.
+        ///
+        /// The modified copy is published when the function returns.
+        ///
+        /// \param function A function taking a ValueType&.
+        template <typename Function>
+        void write(Function&& function)
+        {
+            std::unique_lock<std::mutex> lock(_writeMutex);
+            std::shared_ptr<ValueType> copy = std::make_shared<ValueType>(*std::atomic_load(&_value));
+            function(*copy);
+            std::atomic_store(&_value, std::shared_ptr<const ValueType>(std::move(copy)));
+        }
+
+    private:
+        /// \brief The current snapshot.
+        std::shared_ptr<const ValueType> _value;
+
+        /// \brief A mutex to serialize writers.
+        std::mutex _writeMutex;
+
+    };
+
+};
+
+
+} } // namespace ofx::JSONRPC
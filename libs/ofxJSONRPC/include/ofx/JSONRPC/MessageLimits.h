@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <string>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Size and complexity limits for incoming messages.
+///
+/// Limits are enforced while the message is parsed, so a message that
+/// exceeds a limit is rejected as soon as the limit is reached rather than
+/// after the entire document has been built. A limit of zero disables that
+/// check.
+class MessageLimits
+{
+public:
+    /// \brief The maximum size of a message in bytes.
+    std::size_t maxMessageSize = DEFAULT_MAX_MESSAGE_SIZE;
+
+    /// \brief The maximum nesting depth of arrays and objects.
+    std::size_t maxDepth = DEFAULT_MAX_DEPTH;
+
+    /// \brief The maximum number of values and keys in a message.
+    std::size_t maxElements = DEFAULT_MAX_ELEMENTS;
+
+    /// \brief The maximum length of a string or key in bytes.
+    std::size_t maxStringLength = DEFAULT_MAX_STRING_LENGTH;
+
+    /// \brief Check the size of a message before reading it.
+    /// \param size The size of the message in bytes.
+    /// \throws LimitExceededException if the message is too large.
+    void checkSize(std::size_t size) const;
+
+    /// \brief Parse a message, enforcing all limits.
+    /// \param text The message to parse.
+    /// \returns the parsed message.
+    /// \throws LimitExceededException if a limit is exceeded.
+    /// \throws std::invalid_argument if the message is not valid JSON.
+    ofJson parse(const std::string& text) const;
+
+    /// \brief Check a single parser event against the depth, element and
+    ///        string length limits.
+    ///
+    /// This allows the limits to be enforced by parsers that supply their
+    /// own callback.
+    ///
+    /// \param depth The depth reported by the parser.
+    /// \param event The parser event.
+    /// \param parsed The parsed value.
+    /// \param elements The running element count, incremented for each key
+    ///        and value.
+    /// \throws LimitExceededException if a limit is exceeded.
+    void check(int depth,
+               ofJson::parse_event_t event,
+               const ofJson& parsed,
+               std::size_t& elements) const;
+
+    enum
+    {
+        /// \brief The default maximum message size, 4 MB.
+        DEFAULT_MAX_MESSAGE_SIZE = 4 * 1024 * 1024,
+
+        /// \brief The default maximum nesting depth.
+        DEFAULT_MAX_DEPTH = 64,
+
+        /// \brief The default maximum number of values and keys.
+        DEFAULT_MAX_ELEMENTS = 1024 * 1024,
+
+        /// \brief The default maximum string length, 1 MB.
+        DEFAULT_MAX_STRING_LENGTH = 1024 * 1024
+    };
+
+};
+
+
+} } // namespace ofx::JSONRPC
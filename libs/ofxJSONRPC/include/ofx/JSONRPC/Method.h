@@ -10,22 +10,34 @@
 
 #include "json.hpp"
 #include "Poco/Exception.h"
+#include "ofx/JSONRPC/CachePolicy.h"
 #include "ofx/JSONRPC/Error.h"
 #include "ofx/JSONRPC/MethodArgs.h"
+#include "ofx/JSONRPC/ParameterValidator.h"
 
 
 namespace ofx {
 namespace JSONRPC {
 
 
+template <typename LockingPolicy>
+class MethodRegistry_;
+
+
 /// \brief A method callback class for registering JSONRPC methods.
 template<typename EventType>
 class Method_
 {
 public:
     /// \brief Create a Method Callback
+    ///
+    /// If the description declares OpenRPC style `params` with schemas, they
+    /// are compiled into the method's validator.
+    ///
     /// \param name The method's name.
     /// \param description A description of the method's functionality.
+    /// \throws Poco::InvalidArgumentException if a parameter schema is
+    ///         malformed.
     Method_(const std::string& name,
             const ofJson& description = nullptr);
 
@@ -42,6 +54,16 @@ public:
     const ofJson& description() const;
     OF_DEPRECATED_MSG("Use description() instead.", ofJson getDescription() const);
 
+    /// \returns the validator compiled from the method's description.
+    const ParameterValidator& validator() const;
+
+    /// \returns the caching policy read from the method's description.
+    const CachePolicy& cachePolicy() const;
+
+    /// \returns the permission bit assigned by the registry that the method
+    ///          is registered with.
+    std::size_t permission() const;
+
     /// \brief The public event available for subscription.
     EventType event;
 
@@ -52,6 +74,18 @@ private:
     /// \brief A description of the method's functionality.
     ofJson _description;
 
+    /// \brief The parameter validator compiled from the description.
+    ParameterValidator _validator;
+
+    /// \brief The caching policy read from the description.
+    CachePolicy _cachePolicy;
+
+    /// \brief The permission bit, assigned when the method is registered.
+    std::size_t _permission = 0;
+
+    template <typename LockingPolicy>
+    friend class MethodRegistry_;
+
 };
 
 
@@ -63,7 +97,9 @@ template<typename ArgType>
 Method_<ArgType>::Method_(const std::string& name,
                           const ofJson& description):
     _name(name),
-    _description(description)
+    _description(description),
+    _validator(description),
+    _cachePolicy(description)
 {
 }
 
@@ -102,4 +138,25 @@ inline ofJson Method_<ArgType>::getDescription() const
 }
 
 
+template<typename ArgType>
+inline const ParameterValidator& Method_<ArgType>::validator() const
+{
+    return _validator;
+}
+
+
+template<typename ArgType>
+inline const CachePolicy& Method_<ArgType>::cachePolicy() const
+{
+    return _cachePolicy;
+}
+
+
+template<typename ArgType>
+inline std::size_t Method_<ArgType>::permission() const
+{
+    return _permission;
+}
+
+
 } } // namespace ofx::JSONRPC
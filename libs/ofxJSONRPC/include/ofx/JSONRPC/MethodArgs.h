@@ -10,7 +10,9 @@
 
 #include <string>
 #include "ofx/HTTP/ServerEvents.h"
+#include "ofx/JSONRPC/Connection.h"
 #include "ofx/JSONRPC/JSONRPCUtils.h"
+#include "ofx/JSONRPC/ResultWriter.h"
 
 
 namespace ofx {
@@ -37,8 +39,10 @@ public:
     /// \brief Create a MethodArgs with the given parameters.
     /// \param params The JSON contents of the JSONRPC request params.
     ///        If there are no arguments provided, the params are null.
+    /// \param connection The connection that the call arrived on.
     MethodArgs(HTTP::ServerEventArgs&,
-               const ofJson& params);
+               const ofJson& params,
+               const Connection& connection = Connection());
 
     /// \brief Destroy the MethodArgs.
     virtual ~MethodArgs();
@@ -46,9 +50,23 @@ public:
     /// \brief The JSON contents of the JSONRPC request params.
     const ofJson params;
 
+    /// \brief The connection that the call arrived on.
+    ///
+    /// The handle may be copied and kept after the call returns in order to
+    /// push notifications to the caller. It is empty for POST requests.
+    const Connection connection;
+
     /// \brief The result to be returned, if required.
     ofJson result;
 
+    /// \brief A producer of an array result, used instead of result.
+    ///
+    /// If set, the producer writes the elements of the result array after
+    /// the method returns, and POST responses are sent as they are written.
+    ///
+    /// \sa ResultWriter
+    ResultWriter::Producer resultProducer;
+
     /// \brief The error to be returned, if required.
     ///
     /// If the Error object is set to an error code other than RPC_ERROR_NONE,
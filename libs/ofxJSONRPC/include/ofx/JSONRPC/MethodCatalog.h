@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A cached, pre-serialized OpenRPC description of a method registry.
+///
+/// The catalog is built from the registry's method descriptions and is
+/// serialized once per registry generation. Until the registry changes,
+/// serving the document is a copy of the cached bytes.
+///
+/// A method description that is a string becomes the OpenRPC method's
+/// `description`. A description that is an object is used as the OpenRPC
+/// method object, so it may contain `summary`, `params`, `result`, etc.
+///
+/// MethodCatalog is thread-safe.
+class MethodCatalog
+{
+public:
+    /// \brief A function that returns method names and their descriptions.
+    typedef std::function<std::map<std::string, ofJson>()> MethodSource;
+
+    /// \brief Create a MethodCatalog.
+    MethodCatalog();
+
+    /// \brief Destroy the MethodCatalog.
+    ~MethodCatalog();
+
+    /// \brief Set the OpenRPC info object.
+    /// \param info The info object, e.g. {"title": "My API", "version": "1.0.0"}.
+    void setInfo(const ofJson& info);
+
+    /// \returns the OpenRPC info object.
+    ofJson info() const;
+
+    /// \brief Get the serialized OpenRPC document.
+    ///
+    /// The document is rebuilt only if the generation differs from the
+    /// generation of the cached document.
+    ///
+    /// \param generation The current generation of the method registry.
+    /// \param source The source of method descriptions, called on rebuild.
+    /// \returns the serialized document.
+    std::shared_ptr<const std::string> document(uint64_t generation,
+                                                const MethodSource& source) const;
+
+    /// \brief Get a serialized OpenRPC document using another catalog's info.
+    ///
+    /// This caches a view of a registry, e.g. the methods one connection may
+    /// call, while the info object stays with the registry's catalog. The
+    /// document is rebuilt if the generation or the other catalog's info
+    /// changes.
+    ///
+    /// \param generation The current generation of the method registry.
+    /// \param source The source of method descriptions, called on rebuild.
+    /// \param infoSource The catalog providing the info object.
+    /// \returns the serialized document.
+    std::shared_ptr<const std::string> document(uint64_t generation,
+                                                const MethodSource& source,
+                                                const MethodCatalog& infoSource) const;
+
+    /// \brief Build an OpenRPC document.
+    /// \param info The OpenRPC info object.
+    /// \param methods The method names and their descriptions.
+    /// \returns the OpenRPC document.
+    static ofJson toOpenRPC(const ofJson& info,
+                            const std::map<std::string, ofJson>& methods);
+
+    /// \brief Build a serialized JSONRPC response around a serialized result.
+    ///
+    /// The result bytes are spliced into the response without parsing.
+    ///
+    /// \param id The id of the request being answered.
+    /// \param result The serialized result.
+    /// \returns the serialized response.
+    static std::string toResponse(const ofJson& id, const std::string& result);
+
+    /// \brief The name of the discovery method.
+    static const std::string DISCOVER_METHOD;
+
+    /// \brief The OpenRPC specification version of the document.
+    static const std::string OPENRPC_VERSION;
+
+private:
+    /// \brief A serialized document and the generation it was built for.
+    struct Document
+    {
+        /// \brief The registry generation the document was built for.
+        uint64_t generation;
+
+        /// \brief The info generation the document was built for.
+        uint64_t infoGeneration;
+
+        /// \brief The serialized document.
+        std::shared_ptr<const std::string> text;
+    };
+
+    /// \brief The OpenRPC info object.
+    ofJson _info;
+
+    /// \brief Incremented each time the info object changes.
+    std::atomic<uint64_t> _infoGeneration;
+
+    /// \brief The cached document, accessed atomically.
+    mutable std::shared_ptr<const Document> _document;
+
+    /// \brief A mutex to protect the info object and serialize rebuilds.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::JSONRPC
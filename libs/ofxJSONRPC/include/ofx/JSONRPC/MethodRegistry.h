@@ -8,36 +8,104 @@
 #pragma once
 
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "json.hpp"
 #include "ofEvents.h"
 #include "ofLog.h"
+#include "ofx/JSONRPC/LockingPolicy.h"
 #include "ofx/JSONRPC/Method.h"
+#include "ofx/JSONRPC/MethodCatalog.h"
 #include "ofx/JSONRPC/MethodArgs.h"
+#include "ofx/JSONRPC/ParamsStream.h"
 #include "ofx/JSONRPC/Response.h"
 #include "ofx/JSONRPC/Request.h"
+#include "ofx/JSONRPC/StaticMethodTable.h"
+#include "ofx/JSONRPC/UploadStream.h"
 
 
 namespace ofx {
 namespace JSONRPC {
 
 
-/// \brief A MethodRegistry is a thread-safe method callback manager.
+/// \brief A MethodRegistry is a method callback manager.
 ///
 /// Additionally, a MethodRegistry is in charge of invoking methods by
 /// name using the method signature defined in Method.
-class MethodRegistry
+///
+/// The LockingPolicy determines how the registry is synchronized:
+///
+/// - NullLockingPolicy performs no synchronization. Use it when methods are
+///   registered and dispatched from a single thread.
+/// - MutexLockingPolicy guards all access with a mutex. Method callbacks are
+///   invoked while the mutex is held, so calls are serialized. Calls passed
+///   to mounted registries or to the fallback are made after it is released.
+/// - RCULockingPolicy lets calls dispatch concurrently from an immutable
+///   snapshot without locking, at the cost of copying the method table on
+///   each registration.
+///
+/// Methods that are known at compile time can additionally be served from a
+/// StaticMethodTable attached with setStaticMethods(). Static methods are
+/// found before dynamically registered methods of the same name.
+///
+/// Whole registries can be mounted under dotted prefixes with mount(). A call
+/// to `render.scene.draw` on a registry with a registry mounted at `render` is
+/// dispatched to the mounted registry as `scene.draw`.
+///
+/// Individual connections can be restricted to a subset of methods and given
+/// their own overlay registry with bind().
+///
+/// Methods registered with `"x-idempotent": true` in their description are
+/// flagged as idempotent, and their results may be cached. See CachePolicy.
+///
+/// If a method's description declares parameter schemas, calls with invalid
+/// parameters are rejected with Errors::RPC_ERROR_INVALID_PARAMETERS before
+/// the method callback is invoked.
+///
+/// Calls to names that match no method or mount are passed to the fallback
+/// set with setFallback(), if any. A gateway uses it to forward calls it
+/// can't answer itself. The fallback is invoked after the registry's lock is
+/// released, so a fallback waiting on a remote backend doesn't hold up other
+/// calls.
+///
+/// Unless a method of the same name is registered, every registry answers
+/// `rpc.discover` with a cached OpenRPC document describing its methods.
+/// A connection restricted by bind() is described only the methods it may
+/// call.
+///
+/// \tparam LockingPolicy The synchronization policy.
+template <typename LockingPolicy>
+class MethodRegistry_
 {
 public:
     /// \brief A typedef mapping method names to method descriptions.
     typedef std::map<std::string, ofJson> MethodDescriptionMap;
 
+    /// \brief A function handling calls to unregistered methods.
+    ///
+    /// The function fills in the args' result or error as a method callback
+    /// would.
+    ///
+    /// \returns true iff the function handled the call.
+    typedef std::function<bool(const void* pSender,
+                               const std::string& method,
+                               MethodArgs& args)> FallbackMethod;
+
+    class Registration;
+
+    class Capabilities;
+
     /// \brief Create a MethodRegistry.
-    MethodRegistry();
+    MethodRegistry_();
 
     /// \brief Destroy the MethodRegistry.
-    virtual ~MethodRegistry();
+    virtual ~MethodRegistry_();
 
     /// \brief Register a method callback.
     ///
@@ -135,12 +203,141 @@ public:
                         void (ListenerClass::*listenerMethod)(void),
                         int priority = OF_EVENT_ORDER_AFTER_APP);
 
+    /// \brief Register a method that receives its array parameters as a
+    ///        stream.
+    ///
+    /// The factory is called once per call to create a ParamsStream. When a
+    /// call arrives in a streamed POST body, the elements of its array
+    /// parameters are passed to the stream as they are parsed. Calls that
+    /// arrive in a single message are replayed to the stream. Parameters
+    /// that are streamed are not validated against the description.
+    ///
+    /// ~~~{.cpp}
+    ///     server.registerStreamingMethod("upload-points", "Upload points.", []() {
+    ///         return std::make_shared<PointReader>();
+    ///     });
+    /// ~~~
+    ///
+    /// \param name The name of the method.
+    /// \param description A JSON description of the method.
+    /// \param factory The function creating a ParamsStream for each call.
+    void registerStreamingMethod(const std::string& name,
+                                 const ofJson& description,
+                                 StreamingMethod::Factory factory);
+
+    /// \brief Register a method that receives multipart file uploads.
+    ///
+    /// The factory is called once per call to create an UploadStream.
+    /// Upload methods are streaming methods whose streams also receive the
+    /// progress of uploaded files.
+    ///
+    /// \param name The name of the method, which is also the name of the
+    ///        form's file input.
+    /// \param description A JSON description of the method.
+    /// \param factory The function creating an UploadStream for each call.
+    /// \sa UploadStream
+    void registerUploadMethod(const std::string& name,
+                              const ofJson& description,
+                              std::function<std::shared_ptr<UploadStream>()> factory);
+
     /// \brief Unregister a method by name.
     /// \param method is the name of the method callback to be removed.
     /// \note If the given method does not exist, the unregister
     ///        request will be ignored.
     void unregisterMethod(const std::string& method);
 
+    /// \brief Begin registering many methods at once.
+    ///
+    /// Methods registered with the returned Registration are collected
+    /// without locking and are added to the registry by a single update when
+    /// Registration::commit() is called.
+    ///
+    /// ~~~{.cpp}
+    ///     auto registration = server.beginRegistration();
+    ///     registration.registerMethod("get-text", "Get text.", this, &ofApp::getText);
+    ///     registration.registerMethod("set-text", "Set text.", this, &ofApp::setText);
+    ///     registration.commit();
+    /// ~~~
+    ///
+    /// \returns a Registration for this registry.
+    Registration beginRegistration();
+
+    /// \brief Mount a registry under a method name prefix.
+    ///
+    /// Calls whose method names begin with the prefix followed by a `.` are
+    /// dispatched to the mounted registry with the prefix removed. When
+    /// mounts are nested, the longest matching prefix wins. Mounted
+    /// namespaces take precedence over methods registered directly with
+    /// this registry. Mounting at an existing prefix atomically replaces the
+    /// mounted registry.
+    ///
+    /// Mounts must not form cycles.
+    ///
+    /// \param prefix The method name prefix, e.g. `render` or
+    ///        `render.scene`.
+    /// \param registry The registry to mount.
+    /// \throws Poco::InvalidArgumentException if the prefix is empty or
+    ///         begins or ends with a `.`.
+    void mount(const std::string& prefix,
+               std::shared_ptr<MethodRegistry_> registry);
+
+    /// \brief Unmount the registry mounted under a prefix.
+    /// \param prefix The method name prefix.
+    /// \note If no registry is mounted under the prefix, the request will be
+    ///       ignored.
+    void unmount(const std::string& prefix);
+
+    /// \brief Restrict the methods a connection may call.
+    ///
+    /// The allowed names are resolved to permission bits when the connection
+    /// is bound, and each method carries its own bit, so authorizing a call
+    /// is a single bit test. A name may be a method name or a mount prefix,
+    /// which allows every method beneath the prefix, including the methods
+    /// of registries mounted under longer prefixes. Calls to other methods fail with
+    /// Errors::RPC_ERROR_METHOD_NOT_FOUND. Names that are not registered
+    /// when the connection is bound are ignored.
+    ///
+    /// Binding a connection replaces its previous binding.
+    ///
+    /// \param connection The connection to bind.
+    /// \param allowedMethods The names the connection may call.
+    /// \param overlay An optional registry of methods that only this
+    ///        connection may call. Overlay methods are found before the
+    ///        methods of this registry and are not subject to the allowed
+    ///        names.
+    void bind(const Connection& connection,
+              const std::vector<std::string>& allowedMethods,
+              std::shared_ptr<MethodRegistry_> overlay = nullptr);
+
+    /// \brief Give a connection an overlay registry without restricting it.
+    /// \param connection The connection to bind.
+    /// \param overlay The registry of methods that only this connection may
+    ///        call.
+    void bindOverlay(const Connection& connection,
+                     std::shared_ptr<MethodRegistry_> overlay);
+
+    /// \brief Remove a connection's restrictions and overlay.
+    /// \param connection The connection to unbind.
+    void unbind(const Connection& connection);
+
+    /// \brief Attach a table of methods that are fixed at compile time.
+    ///
+    /// The static table is searched before the dynamically registered
+    /// methods. Methods may continue to be registered dynamically.
+    ///
+    /// \param staticMethods The static method table, or nullptr to detach
+    ///        the current table.
+    void setStaticMethods(std::shared_ptr<const AbstractStaticMethodTable> staticMethods);
+
+    /// \brief Set the handler for calls to unregistered methods.
+    ///
+    /// The fallback is consulted after static methods, registered methods
+    /// and mounts. If it declines a call, the call fails with
+    /// Errors::RPC_ERROR_METHOD_NOT_FOUND.
+    ///
+    /// \param fallback The fallback, or nullptr to remove the current one.
+    void setFallback(FallbackMethod fallback);
+
     /// \brief Process a Request.
     /// \param pSender A pointer to the sender.  This might be a pointer
     ///        to a session cookie or WebSocket connection.  While not
@@ -153,6 +350,17 @@ public:
     /// \returns A success or error Response.
     Response processCall(const void* pSender, Request& request);
 
+    /// \brief Process a Request that arrived on a connection.
+    /// \param pSender A pointer to the sender. Servers pass a pointer to the
+    ///        calling Connection handle.
+    /// \param request The incoming Request from a client.
+    /// \param connection The connection the Request arrived on. It is made
+    ///        available to the method callback via MethodArgs::connection.
+    /// \returns A success or error Response.
+    Response processCall(const void* pSender,
+                         Request& request,
+                         const Connection& connection);
+
     /// \brief Process a Request.
     /// \param pSender A pointer to the sender.  This might be a pointer
     ///        to a session cookie or WebSocket connection.  While not
@@ -164,17 +372,75 @@ public:
     /// \param request The incoming Request from a client.
     void processNotification(const void* pSender, Request& request);
 
+    /// \brief Open a stream for the parameters of a streaming method.
+    /// \param method The name of the method.
+    /// \returns a new ParamsStream, or nullptr if the method is not a
+    ///          streaming method.
+    std::shared_ptr<ParamsStream> openStream(const std::string& method) const;
+
+    /// \brief Open a stream for the uploads of an upload method.
+    /// \param method The name of the method.
+    /// \returns a new UploadStream, or nullptr if the method is not an
+    ///          upload method.
+    std::shared_ptr<UploadStream> openUpload(const std::string& method) const;
+
+    /// \brief Complete a call whose parameters were streamed.
+    /// \param pSender A pointer to the sender.
+    /// \param request The incoming Request, with its streamed arrays
+    ///        emptied.
+    /// \param stream The stream that received the parameters.
+    /// \returns A success or error Response.
+    Response processStreamedCall(const void* pSender,
+                                 Request& request,
+                                 ParamsStream& stream);
+
     /// \brief Query the registry for the given method.
     /// \param method the name of the method to find.
     /// \returns true iff the given method is in the registry.
     bool hasMethod(const std::string& method) const;
 
+    /// \brief Get the caching policy of a method.
+    /// \param method The name of the method.
+    /// \returns the method's policy, or a policy that is not idempotent if
+    ///          the method is not registered. Static methods are never
+    ///          idempotent.
+    CachePolicy cachePolicy(const std::string& method) const;
+
     /// \brief Get a list of all method names and their descriptions.
     /// \returns a MethodDescriptionMap containting a map of the
     ///        method names and the method descriptions.
     MethodDescriptionMap methods() const;
     OF_DEPRECATED_MSG("Use methods() instead.", MethodDescriptionMap getMethods() const);
 
+    /// \brief Get the registry generation.
+    ///
+    /// The generation increases whenever this registry or a registry mounted
+    /// in it changes, including when a mount is replaced or removed.
+    ///
+    /// \returns the current generation.
+    uint64_t generation() const;
+
+    /// \brief Get the serialized OpenRPC document for this registry.
+    ///
+    /// The document is cached and rebuilt only after the registry changes.
+    ///
+    /// \returns the serialized OpenRPC document.
+    std::shared_ptr<const std::string> discover() const;
+
+    /// \brief Get the serialized OpenRPC document for a connection.
+    ///
+    /// A connection bound by bind() is told only the methods it may call,
+    /// and a connection with an overlay is also told the overlay's methods.
+    /// Such documents are cached with the connection's capabilities. Other
+    /// connections receive the shared document returned by discover().
+    ///
+    /// \param connection The connection asking.
+    /// \returns the serialized OpenRPC document.
+    std::shared_ptr<const std::string> discover(const Connection& connection) const;
+
+    /// \returns the catalog used to build the OpenRPC document.
+    MethodCatalog& catalog();
+
 protected:
     /// \brief A shared pointer typedef for methods;
     typedef std::shared_ptr<Method> SharedMethodPtr;
@@ -194,72 +460,1350 @@ protected:
     /// \brief A no argument method map iterator.
     typedef NoArgMethodMap::iterator NoArgMethodMapIter;
 
-    /// \brief Maps method names to their method pointers.
-    MethodMap _methodMap;
+    /// \brief A non-owning view of a dotted method name prefix.
+    struct Prefix
+    {
+        /// \brief The first character of the prefix.
+        const char* data;
+
+        /// \brief The number of characters in the prefix.
+        std::size_t size;
+    };
+
+    /// \brief Compares mount prefixes to strings and Prefix views.
+    struct PrefixLess
+    {
+        typedef void is_transparent;
+
+        bool operator () (const std::string& lhs, const std::string& rhs) const
+        {
+            return lhs < rhs;
+        }
+
+        bool operator () (const std::string& lhs, const Prefix& rhs) const
+        {
+            return lhs.compare(0, lhs.size(), rhs.data, rhs.size) < 0;
+        }
+
+        bool operator () (const Prefix& lhs, const std::string& rhs) const
+        {
+            return rhs.compare(0, rhs.size(), lhs.data, lhs.size) > 0;
+        }
+    };
+
+    /// \brief A mounted registry.
+    struct Mount
+    {
+        /// \brief The mounted registry.
+        std::shared_ptr<MethodRegistry_> registry;
+
+        /// \brief The permission bit of the mount prefix.
+        std::size_t permission;
+    };
+
+    /// \brief Maps mount prefixes to mounted registries.
+    typedef std::map<std::string, Mount, PrefixLess> MountMap;
+
+    /// \brief Maps method names to streaming methods.
+    typedef std::map<std::string, std::shared_ptr<StreamingMethod>> StreamingMethodMap;
+
+    /// \brief The registered methods.
+    struct MethodTable
+    {
+        /// \brief Maps method names to their method pointers.
+        MethodMap methods;
+
+        /// \brief Maps no argument method names to their method pointers.
+        NoArgMethodMap noArgMethods;
 
-    /// \brief Maps no argument method names to their method pointers.
-    NoArgMethodMap _noArgMethodMap;
+        /// \brief Maps streaming method names to the streaming methods that
+        ///        their entries in methods invoke.
+        StreamingMethodMap streamingMethods;
 
-    /// \brief A mutext to ensure method map validity.
-    mutable std::mutex _mutex;
+        /// \brief The methods fixed at compile time, if any.
+        std::shared_ptr<const AbstractStaticMethodTable> staticMethods;
+
+        /// \brief The permission bits of the static methods, by position.
+        std::vector<std::size_t> staticPermissions;
+
+        /// \brief Maps mount prefixes to mounted registries.
+        MountMap mounts;
+
+        /// \brief The handler for calls to unregistered methods, if any.
+        FallbackMethod fallback;
+
+        /// \brief Maps method names and mount prefixes to permission bits.
+        ///
+        /// Bits are assigned on first registration and never reused. The map
+        /// resolves names when a connection is bound; calls test the bit
+        /// stored with the method or mount.
+        std::unordered_map<std::string, std::size_t> permissionIndices;
+    };
+
+    /// \brief Assign a permission bit to a name if it has none.
+    /// \param table The method table to update.
+    /// \param name The method name or mount prefix.
+    /// \returns the name's permission bit.
+    static std::size_t _index(MethodTable& table, const std::string& name);
+
+    /// \brief Determine whether capabilities allow a mounted method.
+    /// \param table The method table to search.
+    /// \param capabilities The capabilities of the caller.
+    /// \param method The method name.
+    /// \returns true iff any mount prefix enclosing the method is allowed.
+    static bool _isAllowed(const MethodTable& table,
+                           const Capabilities& capabilities,
+                           const std::string& method);
+
+    /// \brief Get the methods that capabilities allow and their overlay.
+    /// \param capabilities The capabilities of the caller.
+    /// \returns the method names and descriptions.
+    MethodDescriptionMap _methods(const Capabilities& capabilities) const;
+
+    /// \brief Run a call, converting exceptions to error responses.
+    /// \param request The incoming Request.
+    /// \param function A function returning the Response.
+    /// \returns the Response, or an error Response if the function threw.
+    template <typename Function>
+    static Response _respond(Request& request, Function&& function);
+
+    /// \brief Update the method table and advance the generation.
+    /// \param function A function taking a MethodTable&.
+    template <typename Function>
+    void _update(Function&& function);
+
+    /// \brief Issue a generation for a change to any registry.
+    ///
+    /// Generations are drawn from one counter, so a change anywhere yields
+    /// a generation greater than that of every earlier change.
+    ///
+    /// \returns the new generation.
+    static uint64_t _nextGeneration();
+
+    /// \brief Add methods to the method table.
+    ///
+    /// Methods replace any existing method of the same name.
+    ///
+    /// \param table The method table to update.
+    /// \param methods The methods to add. The map is consumed.
+    /// \param noArgMethods The no argument methods to add. The map is
+    ///        consumed.
+    static void _merge(MethodTable& table,
+                       MethodMap& methods,
+                       NoArgMethodMap& noArgMethods);
+
+    /// \brief Find the mounted registry with the longest matching prefix.
+    /// \param table The method table to search.
+    /// \param method The method name.
+    /// \returns the matching mount, or table.mounts.end() if none matches.
+    static typename MountMap::const_iterator _findMount(const MethodTable& table,
+                                                        const std::string& method);
+
+    /// \brief Invoke a method by name.
+    /// \param pSender A pointer to the sender.
+    /// \param request The incoming Request.
+    /// \param connection The connection the Request arrived on.
+    /// \param method The method name relative to this registry.
+    /// \param capabilities The caller's capabilities, or nullptr if
+    ///        unrestricted.
+    /// \returns A success or error Response.
+    Response _call(const void* pSender,
+                   Request& request,
+                   const Connection& connection,
+                   const std::string& method,
+                   const Capabilities* capabilities);
+
+    /// \brief Invoke a method from the method table.
+    /// \param table The method table to search.
+    /// \param pSender A pointer to the sender.
+    /// \param request The incoming Request.
+    /// \param connection The connection the Request arrived on.
+    /// \param method The method name relative to this registry.
+    /// \param capabilities The caller's capabilities, or nullptr if
+    ///        unrestricted.
+    /// \param fallback Set to the table's fallback if no method matches.
+    /// \returns A success or error Response.
+    static Response _dispatch(const MethodTable& table,
+                              const void* pSender,
+                              Request& request,
+                              const Connection& connection,
+                              const std::string& method,
+                              const Capabilities* capabilities,
+                              FallbackMethod& fallback);
+
+    /// \brief The method table, guarded by the locking policy.
+    typename LockingPolicy::template Guarded<MethodTable> _table;
+
+    /// \brief The generation of the latest change to the method table.
+    std::atomic<uint64_t> _generation;
+
+    /// \brief The cached OpenRPC document.
+    MethodCatalog _catalog;
 
 };
 
 
+/// \brief Collects method registrations and adds them to a registry at once.
+///
+/// A Registration is not thread-safe and must not outlive its registry.
+/// Registrations that have not been committed when the Registration is
+/// destroyed are discarded.
+template <typename LockingPolicy>
+class MethodRegistry_<LockingPolicy>::Registration
+{
+public:
+    /// \brief Create a Registration.
+    /// \param registry The registry to add the methods to.
+    Registration(MethodRegistry_& registry): _registry(&registry)
+    {
+    }
+
+    /// \brief Register a method callback.
+    /// \sa MethodRegistry_::registerMethod()
+    template <class ListenerClass>
+    Registration& registerMethod(const std::string& name,
+                                 const ofJson& description,
+                                 ListenerClass* listener,
+                                 void (ListenerClass::*listenerMethod)(const void*, MethodArgs&),
+                                 int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        SharedMethodPtr method = std::make_shared<Method>(name, description);
+        method->event.add(listener, listenerMethod, priority);
+        return _add(name, method);
+    }
+
+    /// \brief Register a method callback.
+    /// \sa MethodRegistry_::registerMethod()
+    template <class ListenerClass>
+    Registration& registerMethod(const std::string& name,
+                                 const ofJson& description,
+                                 ListenerClass* listener,
+                                 void (ListenerClass::*listenerMethod)(MethodArgs&),
+                                 int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        SharedMethodPtr method = std::make_shared<Method>(name, description);
+        method->event.add(listener, listenerMethod, priority);
+        return _add(name, method);
+    }
+
+    /// \brief Register a no argument method callback.
+    /// \sa MethodRegistry_::registerMethod()
+    template <class ListenerClass>
+    Registration& registerMethod(const std::string& name,
+                                 const ofJson& description,
+                                 ListenerClass* listener,
+                                 void (ListenerClass::*listenerMethod)(const void*),
+                                 int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        SharedNoArgMethodPtr method = std::make_shared<NoArgMethod>(name, description);
+        method->event.add(listener, listenerMethod, priority);
+        return _add(name, method);
+    }
+
+    /// \brief Register a no argument method callback.
+    /// \sa MethodRegistry_::registerMethod()
+    template <class ListenerClass>
+    Registration& registerMethod(const std::string& name,
+                                 const ofJson& description,
+                                 ListenerClass* listener,
+                                 void (ListenerClass::*listenerMethod)(void),
+                                 int priority = OF_EVENT_ORDER_AFTER_APP)
+    {
+        SharedNoArgMethodPtr method = std::make_shared<NoArgMethod>(name, description);
+        method->event.add(listener, listenerMethod, priority);
+        return _add(name, method);
+    }
+
+    /// \returns the number of methods waiting to be committed.
+    std::size_t size() const
+    {
+        return _methods.size() + _noArgMethods.size();
+    }
+
+    /// \brief Add the collected methods to the registry.
+    ///
+    /// The registry is updated once, regardless of the number of methods.
+    /// The Registration is empty afterwards and may be reused.
+    void commit()
+    {
+        if (size() == 0)
+        {
+            return;
+        }
+
+        _registry->_update([&](MethodTable& table) {
+            _merge(table, _methods, _noArgMethods);
+        });
+
+        _methods.clear();
+        _noArgMethods.clear();
+    }
+
+private:
+    /// \brief Add a method, replacing any collected method of the same name.
+    Registration& _add(const std::string& name, SharedMethodPtr method)
+    {
+        _noArgMethods.erase(name);
+        _methods[name] = method;
+        return *this;
+    }
+
+    /// \brief Add a no argument method, replacing any collected method of
+    ///        the same name.
+    Registration& _add(const std::string& name, SharedNoArgMethodPtr method)
+    {
+        _methods.erase(name);
+        _noArgMethods[name] = method;
+        return *this;
+    }
+
+    /// \brief The registry to commit to.
+    MethodRegistry_* _registry = nullptr;
+
+    /// \brief The collected methods.
+    MethodMap _methods;
+
+    /// \brief The collected no argument methods.
+    NoArgMethodMap _noArgMethods;
+
+};
+
+
+/// \brief The methods a bound connection may call.
+///
+/// Capabilities are attached to a Connection by MethodRegistry_::bind() and
+/// apply only to calls dispatched by the registry that bound them.
+template <typename LockingPolicy>
+class MethodRegistry_<LockingPolicy>::Capabilities: public Connection::Attachment
+{
+public:
+    /// \brief Create Capabilities.
+    /// \param registry The registry that bound the capabilities.
+    /// \param restricted True iff only the allowed bits may be called.
+    /// \param allowed The allowed permission bits.
+    /// \param overlay The connection's overlay registry, if any.
+    Capabilities(const MethodRegistry_* registry,
+                 bool restricted,
+                 std::vector<uint64_t> allowed,
+                 std::shared_ptr<MethodRegistry_> overlay):
+        _registry(registry),
+        _restricted(restricted),
+        _allowed(std::move(allowed)),
+        _overlay(overlay)
+    {
+    }
+
+    /// \brief Destroy the Capabilities.
+    virtual ~Capabilities()
+    {
+    }
+
+    /// \returns the registry that bound the capabilities.
+    const MethodRegistry_* registry() const
+    {
+        return _registry;
+    }
+
+    /// \returns true iff only the allowed bits may be called.
+    bool isRestricted() const
+    {
+        return _restricted;
+    }
+
+    /// \brief Test a permission bit.
+    /// \param index The permission bit index.
+    /// \returns true iff the bit is allowed.
+    bool allows(std::size_t index) const
+    {
+        return !_restricted
+            || (index / 64 < _allowed.size() && ((_allowed[index / 64] >> (index % 64)) & 1) != 0);
+    }
+
+    /// \returns the connection's overlay registry, or nullptr if none.
+    const std::shared_ptr<MethodRegistry_>& overlay() const
+    {
+        return _overlay;
+    }
+
+    /// \returns the catalog caching the methods these capabilities allow.
+    const MethodCatalog& catalog() const
+    {
+        return _catalog;
+    }
+
+private:
+    /// \brief The registry that bound the capabilities.
+    const MethodRegistry_* _registry = nullptr;
+
+    /// \brief True iff only the allowed bits may be called.
+    bool _restricted = false;
+
+    /// \brief The allowed permission bits.
+    std::vector<uint64_t> _allowed;
+
+    /// \brief The connection's overlay registry.
+    std::shared_ptr<MethodRegistry_> _overlay;
+
+    /// \brief The cached OpenRPC document for these capabilities.
+    MethodCatalog _catalog;
+
+};
+
+
+/// \brief A thread-safe MethodRegistry.
+typedef MethodRegistry_<MutexLockingPolicy> MethodRegistry;
+
+
+template <typename LockingPolicy>
+MethodRegistry_<LockingPolicy>::MethodRegistry_(): _generation(0)
+{
+}
+
+
+template <typename LockingPolicy>
+MethodRegistry_<LockingPolicy>::~MethodRegistry_()
+{
+}
+
+
+template <typename LockingPolicy>
 template <class ListenerClass>
-void MethodRegistry::registerMethod(const std::string& name,
-                                    const ofJson& description,
-                                    ListenerClass* listener,
-                                    void (ListenerClass::*listenerMethod)(const void*, MethodArgs&),
-                                    int priority)
+void MethodRegistry_<LockingPolicy>::registerMethod(const std::string& name,
+                                                    const ofJson& description,
+                                                    ListenerClass* listener,
+                                                    void (ListenerClass::*listenerMethod)(const void*, MethodArgs&),
+                                                    int priority)
 {
-    unregisterMethod(name);
+    SharedMethodPtr method = std::make_shared<Method>(name, description);
+    method->event.add(listener, listenerMethod, priority);
 
-    std::unique_lock<std::mutex> lock(_mutex);
-    _methodMap[name] = SharedMethodPtr(new Method(name, description));
-    _methodMap[name]->event.add(listener, listenerMethod, priority);
+    _update([&](MethodTable& table) {
+        table.noArgMethods.erase(name);
+        table.streamingMethods.erase(name);
+        method->_permission = _index(table, name);
+        table.methods[name] = method;
+    });
 }
 
+
+template <typename LockingPolicy>
 template <class ListenerClass>
-void MethodRegistry::registerMethod(const std::string& name,
-                                    const ofJson& description,
-                                    ListenerClass* listener,
-                                    void (ListenerClass::*listenerMethod)(MethodArgs&),
-                                    int priority)
+void MethodRegistry_<LockingPolicy>::registerMethod(const std::string& name,
+                                                    const ofJson& description,
+                                                    ListenerClass* listener,
+                                                    void (ListenerClass::*listenerMethod)(MethodArgs&),
+                                                    int priority)
 {
-    unregisterMethod(name);
+    SharedMethodPtr method = std::make_shared<Method>(name, description);
+    method->event.add(listener, listenerMethod, priority);
 
-    std::unique_lock<std::mutex> lock(_mutex);
-    _methodMap[name] = SharedMethodPtr(new Method(name, description));
-    _methodMap[name]->event.add(listener, listenerMethod, priority);
+    _update([&](MethodTable& table) {
+        table.noArgMethods.erase(name);
+        table.streamingMethods.erase(name);
+        method->_permission = _index(table, name);
+        table.methods[name] = method;
+    });
 }
 
+
+template <typename LockingPolicy>
 template <class ListenerClass>
-void MethodRegistry::registerMethod(const std::string& name,
-                                    const ofJson& description,
-                                    ListenerClass* listener,
-                                    void (ListenerClass::*listenerMethod)(const void*),
-                                    int priority)
+void MethodRegistry_<LockingPolicy>::registerMethod(const std::string& name,
+                                                    const ofJson& description,
+                                                    ListenerClass* listener,
+                                                    void (ListenerClass::*listenerMethod)(const void*),
+                                                    int priority)
 {
-    unregisterMethod(name);
+    SharedNoArgMethodPtr method = std::make_shared<NoArgMethod>(name, description);
+    method->event.add(listener, listenerMethod, priority);
 
-    std::unique_lock<std::mutex> lock(_mutex);
-    _noArgMethodMap[name] = SharedNoArgMethodPtr(new NoArgMethod(name, description));
-    _noArgMethodMap[name]->event.add(listener, listenerMethod, priority);
+    _update([&](MethodTable& table) {
+        table.methods.erase(name);
+        table.streamingMethods.erase(name);
+        method->_permission = _index(table, name);
+        table.noArgMethods[name] = method;
+    });
 }
 
+
+template <typename LockingPolicy>
 template <class ListenerClass>
-void MethodRegistry::registerMethod(const std::string& name,
-                                    const ofJson& description,
-                                    ListenerClass* listener,
-                                    void (ListenerClass::*listenerMethod)(void),
-                                    int priority)
+void MethodRegistry_<LockingPolicy>::registerMethod(const std::string& name,
+                                                    const ofJson& description,
+                                                    ListenerClass* listener,
+                                                    void (ListenerClass::*listenerMethod)(void),
+                                                    int priority)
+{
+    SharedNoArgMethodPtr method = std::make_shared<NoArgMethod>(name, description);
+    method->event.add(listener, listenerMethod, priority);
+
+    _update([&](MethodTable& table) {
+        table.methods.erase(name);
+        table.streamingMethods.erase(name);
+        method->_permission = _index(table, name);
+        table.noArgMethods[name] = method;
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::registerStreamingMethod(const std::string& name,
+                                                             const ofJson& description,
+                                                             StreamingMethod::Factory factory)
+{
+    std::shared_ptr<StreamingMethod> streamingMethod = std::make_shared<StreamingMethod>(factory);
+
+    // The method entry keeps calls that arrive in one message working.
+    SharedMethodPtr method = std::make_shared<Method>(name, description);
+    method->event.add(streamingMethod.get(), &StreamingMethod::invoke, OF_EVENT_ORDER_AFTER_APP);
+
+    _update([&](MethodTable& table) {
+        table.noArgMethods.erase(name);
+        method->_permission = _index(table, name);
+        table.methods[name] = method;
+        table.streamingMethods[name] = streamingMethod;
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::registerUploadMethod(const std::string& name,
+                                                          const ofJson& description,
+                                                          std::function<std::shared_ptr<UploadStream>()> factory)
+{
+    if (!factory)
+    {
+        throw Poco::InvalidArgumentException("An upload method requires a factory.");
+    }
+
+    registerStreamingMethod(name, description, [factory]() -> std::shared_ptr<ParamsStream> {
+        return factory();
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::unregisterMethod(const std::string& method)
+{
+    _update([&](MethodTable& table) {
+        table.streamingMethods.erase(method);
+
+        if (table.methods.erase(method) == 0)
+        {
+            table.noArgMethods.erase(method);
+        }
+    });
+}
+
+
+template <typename LockingPolicy>
+typename MethodRegistry_<LockingPolicy>::Registration MethodRegistry_<LockingPolicy>::beginRegistration()
+{
+    return Registration(*this);
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::mount(const std::string& prefix,
+                                           std::shared_ptr<MethodRegistry_> registry)
+{
+    if (prefix.empty() || prefix.front() == '.' || prefix.back() == '.')
+    {
+        throw Poco::InvalidArgumentException("Invalid mount prefix: \"" + prefix + "\"");
+    }
+
+    if (!registry)
+    {
+        unmount(prefix);
+        return;
+    }
+
+    _update([&](MethodTable& table) {
+        table.mounts[prefix] = Mount { registry, _index(table, prefix) };
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::unmount(const std::string& prefix)
+{
+    _update([&](MethodTable& table) {
+        table.mounts.erase(prefix);
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::bind(const Connection& connection,
+                                          const std::vector<std::string>& allowedMethods,
+                                          std::shared_ptr<MethodRegistry_> overlay)
+{
+    std::vector<uint64_t> allowed;
+
+    _table.read([&](const MethodTable& table) {
+        for (const auto& name: allowedMethods)
+        {
+            auto index = table.permissionIndices.find(name);
+
+            if (index != table.permissionIndices.end())
+            {
+                std::size_t word = index->second / 64;
+
+                if (allowed.size() <= word)
+                {
+                    allowed.resize(word + 1, 0);
+                }
+
+                allowed[word] |= uint64_t(1) << (index->second % 64);
+            }
+        }
+    });
+
+    connection.attach(std::make_shared<Capabilities>(this, true, std::move(allowed), overlay));
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::bindOverlay(const Connection& connection,
+                                                 std::shared_ptr<MethodRegistry_> overlay)
+{
+    connection.attach(std::make_shared<Capabilities>(this, false, std::vector<uint64_t>(), overlay));
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::unbind(const Connection& connection)
+{
+    connection.attach(nullptr);
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::setStaticMethods(std::shared_ptr<const AbstractStaticMethodTable> staticMethods)
+{
+    _update([&](MethodTable& table) {
+        table.staticMethods = staticMethods;
+        table.staticPermissions.clear();
+
+        if (staticMethods)
+        {
+            MethodDescriptionMap methods = staticMethods->methods();
+            table.staticPermissions.resize(methods.size(), 0);
+
+            for (const auto& method: methods)
+            {
+                std::size_t position = 0;
+
+                if (staticMethods->find(method.first, position))
+                {
+                    table.staticPermissions[position] = _index(table, method.first);
+                }
+            }
+        }
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::setFallback(FallbackMethod fallback)
 {
-    unregisterMethod(name);
+    _update([&](MethodTable& table) {
+        table.fallback = std::move(fallback);
+    });
+}
+
+
+template <typename LockingPolicy>
+Response MethodRegistry_<LockingPolicy>::processCall(const void* pSender,
+                                                     Request& request)
+{
+    return processCall(pSender, request, Connection());
+}
+
+
+template <typename LockingPolicy>
+Response MethodRegistry_<LockingPolicy>::processCall(const void* pSender,
+                                                     Request& request,
+                                                     const Connection& connection)
+{
+    return _respond(request, [&]() {
+        if (request.method() == MethodCatalog::DISCOVER_METHOD && !hasMethod(request.method()))
+        {
+            return Response(request, request.id(), ofJson::parse(*discover(connection)));
+        }
+
+        std::shared_ptr<const Connection::Attachment> attachment = connection.attachment();
+        const Capabilities* capabilities = dynamic_cast<const Capabilities*>(attachment.get());
+
+        if (capabilities == nullptr || capabilities->registry() != this)
+        {
+            return _call(pSender, request, connection, request.method(), nullptr);
+        }
+
+        const std::shared_ptr<MethodRegistry_>& overlay = capabilities->overlay();
+
+        if (overlay && overlay->hasMethod(request.method()))
+        {
+            return overlay->processCall(pSender, request, connection);
+        }
+
+        return _call(pSender, request, connection, request.method(), capabilities);
+    });
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::processNotification(const void* pSender,
+                                                         Request& request)
+{
+    processCall(pSender, request); // return nothing
+}
+
+
+template <typename LockingPolicy>
+std::shared_ptr<ParamsStream> MethodRegistry_<LockingPolicy>::openStream(const std::string& method) const
+{
+    std::shared_ptr<MethodRegistry_> mounted;
+    std::string mountedMethod;
+    std::shared_ptr<StreamingMethod> streamingMethod;
+
+    // The stream is opened outside of the lock, since it calls user code.
+    _table.read([&](const MethodTable& table) {
+        auto mount = _findMount(table, method);
+
+        if (mount != table.mounts.end())
+        {
+            mounted = mount->second.registry;
+            mountedMethod = method.substr(mount->first.size() + 1);
+            return;
+        }
+
+        auto iter = table.streamingMethods.find(method);
+
+        if (iter != table.streamingMethods.end())
+        {
+            streamingMethod = iter->second;
+        }
+    });
+
+    if (mounted)
+    {
+        return mounted->openStream(mountedMethod);
+    }
+
+    return streamingMethod ? streamingMethod->open() : nullptr;
+}
+
+
+template <typename LockingPolicy>
+std::shared_ptr<UploadStream> MethodRegistry_<LockingPolicy>::openUpload(const std::string& method) const
+{
+    return std::dynamic_pointer_cast<UploadStream>(openStream(method));
+}
+
+
+template <typename LockingPolicy>
+Response MethodRegistry_<LockingPolicy>::processStreamedCall(const void* pSender,
+                                                             Request& request,
+                                                             ParamsStream& stream)
+{
+    return _respond(request, [&]() {
+        MethodArgs args(request, request.parameters());
+
+        stream.complete(args);
+
+        if (Errors::RPC_ERROR_NONE == args.error.code())
+        {
+            Response response(request, request.id(), args.result);
+            response.setResultProducer(args.resultProducer);
+            return response;
+        }
+
+        return Response(request, request.id(), args.error);
+    });
+}
+
+
+template <typename LockingPolicy>
+bool MethodRegistry_<LockingPolicy>::hasMethod(const std::string& method) const
+{
+    return _table.read([&](const MethodTable& table) {
+        auto mount = _findMount(table, method);
+
+        if (mount != table.mounts.end())
+        {
+            return mount->second.registry->hasMethod(method.substr(mount->first.size() + 1));
+        }
+
+        return table.methods.find(method) != table.methods.end()
+            || table.noArgMethods.find(method) != table.noArgMethods.end()
+            || (table.staticMethods && table.staticMethods->find(method) != nullptr);
+    });
+}
+
+
+template <typename LockingPolicy>
+CachePolicy MethodRegistry_<LockingPolicy>::cachePolicy(const std::string& method) const
+{
+    return _table.read([&](const MethodTable& table) {
+        auto mount = _findMount(table, method);
+
+        if (mount != table.mounts.end())
+        {
+            return mount->second.registry->cachePolicy(method.substr(mount->first.size() + 1));
+        }
+
+        auto iter = table.methods.find(method);
+
+        if (iter != table.methods.end())
+        {
+            return iter->second->cachePolicy();
+        }
+
+        auto noArgIter = table.noArgMethods.find(method);
+
+        if (noArgIter != table.noArgMethods.end())
+        {
+            return noArgIter->second->cachePolicy();
+        }
+
+        return CachePolicy();
+    });
+}
+
+
+template <typename LockingPolicy>
+typename MethodRegistry_<LockingPolicy>::MethodDescriptionMap MethodRegistry_<LockingPolicy>::methods() const
+{
+    return _table.read([](const MethodTable& table) {
+        MethodDescriptionMap methods;
+
+        if (table.staticMethods)
+        {
+            methods = table.staticMethods->methods();
+        }
+
+        for (const auto& method: table.methods)
+        {
+            methods.insert(std::make_pair(method.first, method.second->description()));
+        }
+
+        for (const auto& mount: table.mounts)
+        {
+            // Remove methods shadowed by the mounted namespace.
+            auto first = methods.lower_bound(mount.first + ".");
+            auto last = first;
+
+            while (last != methods.end() && last->first.compare(0, mount.first.size() + 1, mount.first + ".") == 0)
+            {
+                ++last;
+            }
+
+            methods.erase(first, last);
+
+            for (const auto& method: mount.second.registry->methods())
+            {
+                methods[mount.first + "." + method.first] = method.second;
+            }
+        }
+
+        return methods;
+    });
+}
+
+
+template <typename LockingPolicy>
+typename MethodRegistry_<LockingPolicy>::MethodDescriptionMap MethodRegistry_<LockingPolicy>::getMethods() const
+{
+    return methods();
+}
+
+
+template <typename LockingPolicy>
+void MethodRegistry_<LockingPolicy>::_merge(MethodTable& table,
+                                            MethodMap& methods,
+                                            NoArgMethodMap& noArgMethods)
+{
+    if (table.methods.empty() && table.noArgMethods.empty())
+    {
+        // The common startup case: adopt the collected maps as-is.
+        table.methods.swap(methods);
+        table.noArgMethods.swap(noArgMethods);
+
+        for (auto& method: table.methods)
+        {
+            method.second->_permission = _index(table, method.first);
+        }
+
+        for (auto& method: table.noArgMethods)
+        {
+            method.second->_permission = _index(table, method.first);
+        }
+
+        return;
+    }
+
+    for (auto& method: methods)
+    {
+        table.noArgMethods.erase(method.first);
+        table.streamingMethods.erase(method.first);
+        method.second->_permission = _index(table, method.first);
+        table.methods[method.first] = std::move(method.second);
+    }
+
+    for (auto& method: noArgMethods)
+    {
+        table.methods.erase(method.first);
+        table.streamingMethods.erase(method.first);
+        method.second->_permission = _index(table, method.first);
+        table.noArgMethods[method.first] = std::move(method.second);
+    }
+}
+
+
+template <typename LockingPolicy>
+std::size_t MethodRegistry_<LockingPolicy>::_index(MethodTable& table,
+                                                   const std::string& name)
+{
+    return table.permissionIndices.emplace(name, table.permissionIndices.size()).first->second;
+}
+
+
+template <typename LockingPolicy>
+bool MethodRegistry_<LockingPolicy>::_isAllowed(const MethodTable& table,
+                                                const Capabilities& capabilities,
+                                                const std::string& method)
+{
+    if (!capabilities.isRestricted())
+    {
+        return true;
+    }
+
+    // Allowing a prefix allows the registries mounted under longer prefixes,
+    // so every enclosing mount is tried, not just the one that is called.
+    std::size_t position = method.rfind('.');
+
+    while (position != std::string::npos && position > 0)
+    {
+        auto mount = table.mounts.find(Prefix { method.data(), position });
+
+        if (mount != table.mounts.end() && capabilities.allows(mount->second.permission))
+        {
+            return true;
+        }
+
+        position = method.rfind('.', position - 1);
+    }
+
+    return false;
+}
+
+
+template <typename LockingPolicy>
+typename MethodRegistry_<LockingPolicy>::MethodDescriptionMap MethodRegistry_<LockingPolicy>::_methods(const Capabilities& capabilities) const
+{
+    MethodDescriptionMap methods = _table.read([&](const MethodTable& table) {
+        MethodDescriptionMap allowed;
+
+        if (table.staticMethods)
+        {
+            for (const auto& method: table.staticMethods->methods())
+            {
+                std::size_t position = 0;
+
+                if (table.staticMethods->find(method.first, position)
+                && capabilities.allows(table.staticPermissions[position]))
+                {
+                    allowed.insert(method);
+                }
+            }
+        }
+
+        for (const auto& method: table.methods)
+        {
+            if (capabilities.allows(method.second->permission()))
+            {
+                allowed.insert(std::make_pair(method.first, method.second->description()));
+            }
+        }
+
+        for (const auto& mount: table.mounts)
+        {
+            // Remove methods shadowed by the mounted namespace.
+            auto first = allowed.lower_bound(mount.first + ".");
+            auto last = first;
+
+            while (last != allowed.end() && last->first.compare(0, mount.first.size() + 1, mount.first + ".") == 0)
+            {
+                ++last;
+            }
+
+            allowed.erase(first, last);
+
+            if (_isAllowed(table, capabilities, mount.first + "."))
+            {
+                for (const auto& method: mount.second.registry->methods())
+                {
+                    allowed[mount.first + "." + method.first] = method.second;
+                }
+            }
+        }
+
+        return allowed;
+    });
+
+    // Overlay methods are called in preference to the registry's.
+    if (capabilities.overlay())
+    {
+        for (const auto& method: capabilities.overlay()->methods())
+        {
+            methods[method.first] = method.second;
+        }
+    }
+
+    return methods;
+}
+
+
+template <typename LockingPolicy>
+uint64_t MethodRegistry_<LockingPolicy>::generation() const
+{
+    return _table.read([&](const MethodTable& table) {
+        uint64_t generation = _generation.load();
+
+        // Every change issues a generation greater than all earlier ones,
+        // so the greatest generation changes whenever any registry does.
+        // Replacing or removing a mount is a change to this registry.
+        for (const auto& mount: table.mounts)
+        {
+            generation = std::max(generation, mount.second.registry->generation());
+        }
+
+        return generation;
+    });
+}
+
+
+template <typename LockingPolicy>
+std::shared_ptr<const std::string> MethodRegistry_<LockingPolicy>::discover() const
+{
+    return _catalog.document(generation(), [this]() { return methods(); });
+}
+
+
+template <typename LockingPolicy>
+std::shared_ptr<const std::string> MethodRegistry_<LockingPolicy>::discover(const Connection& connection) const
+{
+    std::shared_ptr<const Connection::Attachment> attachment = connection.attachment();
+    const Capabilities* capabilities = dynamic_cast<const Capabilities*>(attachment.get());
+
+    if (capabilities == nullptr
+    || capabilities->registry() != this
+    || (!capabilities->isRestricted() && !capabilities->overlay()))
+    {
+        return discover();
+    }
+
+    // Generations are drawn from one counter, so the greater of the two
+    // changes whenever either registry does.
+    uint64_t documentGeneration = generation();
+
+    if (capabilities->overlay())
+    {
+        documentGeneration = std::max(documentGeneration, capabilities->overlay()->generation());
+    }
+
+    return capabilities->catalog().document(documentGeneration, [&]() {
+        return _methods(*capabilities);
+    }, _catalog);
+}
+
+
+template <typename LockingPolicy>
+MethodCatalog& MethodRegistry_<LockingPolicy>::catalog()
+{
+    return _catalog;
+}
+
+
+template <typename LockingPolicy>
+template <typename Function>
+Response MethodRegistry_<LockingPolicy>::_respond(Request& request, Function&& function)
+{
+    try
+    {
+        return function();
+    }
+    catch (const JSONRPCException& exc)
+    {
+        return Response(request,
+                        request.id(),
+                        Error(exc.code(),
+                              exc.message()));
+    }
+    catch (const Poco::InvalidArgumentException& exc)
+    {
+        // The message says which parameter was rejected and why.
+        return Response(request,
+                        request.id(),
+                        Error(Errors::RPC_ERROR_INVALID_PARAMETERS,
+                              exc.message(),
+                              Request::toJSON(request)));
+    }
+    catch (const Poco::Exception& exc)
+    {
+        return Response(request,
+                        request.id(),
+                        Error(Errors::RPC_ERROR_INTERNAL_ERROR,
+                              exc.displayText(),
+                              Request::toJSON(request)));
+    }
+    catch (const std::exception& exc)
+    {
+        return Response(request,
+                        request.id(),
+                        Error(Errors::RPC_ERROR_INTERNAL_ERROR,
+                              exc.what(),
+                              Request::toJSON(request)));
+    }
+    catch ( ... )
+    {
+        return Response(request,
+                        request.id(),
+                        Error(Errors::RPC_ERROR_INTERNAL_ERROR,
+                              "Unknown Exception",
+                              Request::toJSON(request)));
+    }
+}
+
+
+template <typename LockingPolicy>
+template <typename Function>
+void MethodRegistry_<LockingPolicy>::_update(Function&& function)
+{
+    _table.write(std::forward<Function>(function));
+
+    // The generation advances after the change is visible, and never moves
+    // back if concurrent updates store their generations out of order.
+    uint64_t generation = _nextGeneration();
+    uint64_t current = _generation.load();
+
+    while (current < generation && !_generation.compare_exchange_weak(current, generation))
+    {
+    }
+}
+
+
+template <typename LockingPolicy>
+uint64_t MethodRegistry_<LockingPolicy>::_nextGeneration()
+{
+    static std::atomic<uint64_t> generation(0);
+    return ++generation;
+}
+
+
+template <typename LockingPolicy>
+typename MethodRegistry_<LockingPolicy>::MountMap::const_iterator MethodRegistry_<LockingPolicy>::_findMount(const MethodTable& table,
+                                                                                                            const std::string& method)
+{
+    if (table.mounts.empty())
+    {
+        return table.mounts.end();
+    }
+
+    // Try each dotted prefix of the name, longest first.
+    std::size_t position = method.rfind('.');
+
+    while (position != std::string::npos && position > 0)
+    {
+        auto mount = table.mounts.find(Prefix { method.data(), position });
+
+        if (mount != table.mounts.end())
+        {
+            return mount;
+        }
+
+        position = method.rfind('.', position - 1);
+    }
+
+    return table.mounts.end();
+}
+
+
+template <typename LockingPolicy>
+Response MethodRegistry_<LockingPolicy>::_call(const void* pSender,
+                                               Request& request,
+                                               const Connection& connection,
+                                               const std::string& method,
+                                               const Capabilities* capabilities)
+{
+    // Mounted registries and the fallback are called once the method table
+    // is released, so that a slow call doesn't hold up every other caller.
+    std::shared_ptr<MethodRegistry_> mounted;
+    std::string mountedMethod;
+    FallbackMethod fallback;
+
+    Response response = _table.read([&](const MethodTable& table) {
+        auto mount = _findMount(table, method);
+
+        if (mount != table.mounts.end())
+        {
+            if (capabilities && !_isAllowed(table, *capabilities, method))
+            {
+                return Response(request,
+                                request.id(),
+                                Error(Errors::RPC_ERROR_METHOD_NOT_FOUND,
+                                      Request::toJSON(request)));
+            }
+
+            mounted = mount->second.registry;
+            mountedMethod = method.substr(mount->first.size() + 1);
+            return Response(request);
+        }
+
+        return _dispatch(table, pSender, request, connection, method, capabilities, fallback);
+    });
+
+    if (mounted)
+    {
+        return mounted->_call(pSender, request, connection, mountedMethod, nullptr);
+    }
+
+    if (fallback)
+    {
+        MethodArgs args(request, request.parameters(), connection);
+
+        if (fallback(pSender, method, args))
+        {
+            if (Errors::RPC_ERROR_NONE == args.error.code())
+            {
+                return Response(request, request.id(), args.result);
+            }
+
+            return Response(request, request.id(), args.error);
+        }
+    }
+
+    return response;
+}
+
+
+template <typename LockingPolicy>
+Response MethodRegistry_<LockingPolicy>::_dispatch(const MethodTable& table,
+                                                   const void* pSender,
+                                                   Request& request,
+                                                   const Connection& connection,
+                                                   const std::string& method,
+                                                   const Capabilities* capabilities,
+                                                   FallbackMethod& fallback)
+{
+    auto notFound = [&]() {
+        return Response(request,
+                        request.id(),
+                        Error(Errors::RPC_ERROR_METHOD_NOT_FOUND,
+                              Request::toJSON(request)));
+    };
+
+    AbstractStaticMethodTable::Invoker invoker = nullptr;
+
+    if (table.staticMethods)
+    {
+        std::size_t position = 0;
+        invoker = table.staticMethods->find(method, position);
+
+        if (invoker && capabilities && !capabilities->allows(table.staticPermissions[position]))
+        {
+            return notFound();
+        }
+    }
+
+    auto methodIter = invoker ? table.methods.end() : table.methods.find(method);
+
+    if (methodIter != table.methods.end())
+    {
+        if (capabilities && !capabilities->allows(methodIter->second->permission()))
+        {
+            return notFound();
+        }
+
+        ofJson data;
+
+        // Reject invalid parameters before the callback sees them.
+        if (!methodIter->second->validator().validate(request.parameters(), data))
+        {
+            return Response(request,
+                            request.id(),
+                            Error(Errors::RPC_ERROR_INVALID_PARAMETERS, data));
+        }
+    }
+
+    if (invoker || methodIter != table.methods.end())
+    {
+        MethodArgs args(request, request.parameters(), connection);
+
+        // Argument result is filled in the method callback.
+        if (invoker)
+        {
+            invoker(*table.staticMethods, args);
+        }
+        else
+        {
+            ofNotifyEvent(methodIter->second->event, args, pSender);
+        }
+
+        // If an error is present, then ignore any args.results
+        // and return the error response.
+        if (Errors::RPC_ERROR_NONE == args.error.code())
+        {
+            Response response(request,
+                              request.id(),
+                              args.result);
+
+            response.setResultProducer(args.resultProducer);
+
+            return response;
+        }
+        else
+        {
+            // Return the error.
+            return Response(request,
+                            request.id(),
+                            args.error);
+        }
+    }
+
+    auto noArgMethodIter = table.noArgMethods.find(method);
+
+    if (noArgMethodIter != table.noArgMethods.end())
+    {
+        if (capabilities && !capabilities->allows(noArgMethodIter->second->permission()))
+        {
+            return notFound();
+        }
+
+        if (request.parameters().is_null())
+        {
+            ofNotifyEvent(noArgMethodIter->second->event, pSender);
+
+            return Response(request, request.id(), nullptr);
+        }
+        else
+        {
+            return Response(request,
+                            request.id(),
+                            Error(Errors::RPC_ERROR_INVALID_REQUEST,
+                                  "This method does not support parameters.",
+                                  Request::toJSON(request)));
+        }
+    }
+
+    // A restricted connection may only call the names it was allowed.
+    if (!capabilities || !capabilities->isRestricted())
+    {
+        fallback = table.fallback;
+    }
 
-    std::unique_lock<std::mutex> lock(_mutex);
-    _noArgMethodMap[name] = SharedNoArgMethodPtr(new NoArgMethod(name, description));
-    _noArgMethodMap[name]->event.add(listener, listenerMethod, priority);
+    return notFound();
 }
 
 
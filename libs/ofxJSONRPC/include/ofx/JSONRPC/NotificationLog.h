@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A bounded log of serialized notifications.
+///
+/// Each published notification is assigned the next sequence number and
+/// retained until the log is full, when the oldest notification is dropped.
+/// Readers follow the log by sequence number, so a reader that disconnects
+/// can resume where it left off as long as the notifications it missed are
+/// still retained.
+///
+/// Notifications are stored as shared, immutable strings, so a message
+/// serialized once for a broadcast is shared by every reader.
+///
+/// NotificationLog is thread-safe.
+class NotificationLog
+{
+public:
+    /// \brief A serialized notification.
+    typedef std::shared_ptr<const std::string> Message;
+
+    /// \brief A notification in the log.
+    struct Entry
+    {
+        /// \brief The sequence number of the notification.
+        uint64_t id = 0;
+
+        /// \brief The topic the notification was published to.
+        ///
+        /// Notifications published to all readers have an empty topic.
+        std::string topic;
+
+        /// \brief The serialized notification.
+        Message message;
+    };
+
+    /// \brief Create an empty NotificationLog.
+    /// \param capacity The maximum number of notifications retained.
+    NotificationLog(std::size_t capacity = DEFAULT_CAPACITY);
+
+    /// \brief Destroy the NotificationLog.
+    ~NotificationLog();
+
+    /// \brief Set the maximum number of notifications retained.
+    ///
+    /// The oldest notifications are dropped if the log is already larger.
+    ///
+    /// \param capacity The maximum number of notifications retained.
+    void setCapacity(std::size_t capacity);
+
+    /// \brief Append a notification and wake waiting readers.
+    /// \param topic The topic, or an empty string for all readers.
+    /// \param message The serialized notification.
+    /// \returns the sequence number of the notification.
+    uint64_t publish(const std::string& topic, Message message);
+
+    /// \brief Get the retained notifications after a sequence number.
+    /// \param id The last sequence number the reader has seen.
+    /// \returns the retained notifications newer than id, oldest first.
+    std::vector<Entry> since(uint64_t id) const;
+
+    /// \returns the sequence number of the newest notification, or zero if
+    ///          none have been published.
+    uint64_t lastId() const;
+
+    /// \brief Wait for a notification newer than a sequence number.
+    /// \param id The last sequence number the reader has seen.
+    /// \param epoch The epoch the reader started in.
+    /// \param timeout The maximum time to wait.
+    /// \returns true iff a newer notification is available or the readers of
+    ///          the epoch were released.
+    bool wait(uint64_t id,
+              uint64_t epoch,
+              std::chrono::milliseconds timeout) const;
+
+    /// \returns the current epoch.
+    uint64_t epoch() const;
+
+    /// \brief Release every waiting reader by starting a new epoch.
+    ///
+    /// Readers should stop following the log once its epoch differs from
+    /// the one they started in, e.g. when a server stops.
+    void release();
+
+    enum
+    {
+        /// \brief The default number of notifications retained.
+        DEFAULT_CAPACITY = 1024
+    };
+
+private:
+    /// \brief The maximum number of notifications retained.
+    std::size_t _capacity;
+
+    /// \brief The retained notifications, oldest first.
+    std::deque<Entry> _entries;
+
+    /// \brief The sequence number of the newest notification.
+    uint64_t _lastId = 0;
+
+    /// \brief The current epoch.
+    uint64_t _epoch = 0;
+
+    /// \brief A mutex to protect the log.
+    mutable std::mutex _mutex;
+
+    /// \brief Signalled when a notification is published or readers are
+    ///        released.
+    mutable std::condition_variable _condition;
+
+};
+
+
+} } // namespace ofx::JSONRPC
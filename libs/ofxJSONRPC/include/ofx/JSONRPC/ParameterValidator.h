@@ -0,0 +1,185 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A parameter validator compiled from a method description.
+///
+/// If a method description is an object with an OpenRPC style `params` array,
+/// each parameter's JSON Schema is compiled once into a tree of flat nodes.
+/// Validation then walks the tree, testing each value's type against a bit
+/// mask and checking only the constraints that were present in the schema.
+/// The schema is not interpreted during validation.
+///
+/// ~~~{.json}
+///     {
+///         "description": "Set the text.",
+///         "params": [
+///             { "name": "text", "required": true, "schema": { "type": "string", "maxLength": 256 } },
+///             { "name": "size", "schema": { "type": "integer", "minimum": 1 } }
+///         ]
+///     }
+/// ~~~
+///
+/// Parameters may be passed by name (an object) or by position (an array).
+///
+/// The supported schema keywords are `type`, `enum`, `const`, `minimum`,
+/// `maximum`, `exclusiveMinimum`, `exclusiveMaximum`, `minLength`,
+/// `maxLength`, `minItems`, `maxItems`, `items`, `properties`, `required` and
+/// `additionalProperties` (as a boolean). Annotations such as `title`,
+/// `description` and `default` are accepted and ignored. Any other keyword
+/// (e.g. `pattern`, `format`, `oneOf` or `$ref`) is rejected when the schema
+/// is compiled, rather than silently accepting values it would forbid.
+class ParameterValidator
+{
+public:
+    /// \brief Create a validator that accepts all parameters.
+    ParameterValidator();
+
+    /// \brief Compile a validator from a method description.
+    /// \param description The method description.
+    /// \throws Poco::InvalidArgumentException if a schema is malformed or
+    ///         uses an unsupported keyword.
+    explicit ParameterValidator(const ofJson& description);
+
+    /// \brief Destroy the ParameterValidator.
+    ~ParameterValidator();
+
+    /// \returns true iff the description declared any parameters.
+    bool isEmpty() const;
+
+    /// \brief Validate parameters.
+    /// \param params The parameters of a call.
+    /// \param error Filled with a description of the first violation, with
+    ///        the JSON pointer of the offending value in `path`.
+    /// \returns true iff the parameters are valid.
+    bool validate(const ofJson& params, ofJson& error) const;
+
+private:
+    /// \brief Type bits, one per JSON Schema type.
+    enum Type
+    {
+        TYPE_NULL = 1 << 0,
+        TYPE_BOOLEAN = 1 << 1,
+        TYPE_INTEGER = 1 << 2,
+        TYPE_NUMBER = 1 << 3,
+        TYPE_STRING = 1 << 4,
+        TYPE_ARRAY = 1 << 5,
+        TYPE_OBJECT = 1 << 6,
+        TYPE_ANY = (1 << 7) - 1
+    };
+
+    /// \brief Constraint bits, one per constraint present in the schema.
+    enum Constraint
+    {
+        HAS_ENUM = 1 << 0,
+        HAS_MINIMUM = 1 << 1,
+        HAS_MAXIMUM = 1 << 2,
+        HAS_EXCLUSIVE_MINIMUM = 1 << 3,
+        HAS_EXCLUSIVE_MAXIMUM = 1 << 4,
+        HAS_MIN_LENGTH = 1 << 5,
+        HAS_MAX_LENGTH = 1 << 6,
+        HAS_MIN_ITEMS = 1 << 7,
+        HAS_MAX_ITEMS = 1 << 8,
+        HAS_ITEMS = 1 << 9,
+        HAS_PROPERTIES = 1 << 10,
+        HAS_REQUIRED = 1 << 11,
+        NO_ADDITIONAL_PROPERTIES = 1 << 12
+    };
+
+    /// \brief A compiled schema.
+    struct Node
+    {
+        /// \brief The allowed type bits.
+        uint8_t types = TYPE_ANY;
+
+        /// \brief The constraint bits.
+        uint16_t constraints = 0;
+
+        /// \brief Numeric bounds.
+        double minimum = 0;
+        double maximum = 0;
+        double exclusiveMinimum = 0;
+        double exclusiveMaximum = 0;
+
+        /// \brief String length bounds.
+        std::size_t minLength = 0;
+        std::size_t maxLength = 0;
+
+        /// \brief Array size bounds.
+        std::size_t minItems = 0;
+        std::size_t maxItems = 0;
+
+        /// \brief The node index of the array item schema.
+        std::size_t items = 0;
+
+        /// \brief The allowed values.
+        std::vector<ofJson> values;
+
+        /// \brief Property names and their node indices, sorted by name.
+        std::vector<std::pair<std::string, std::size_t>> properties;
+
+        /// \brief The required property names.
+        std::vector<std::string> required;
+    };
+
+    /// \brief A compiled parameter.
+    struct Parameter
+    {
+        /// \brief The parameter name.
+        std::string name;
+
+        /// \brief True iff the parameter must be present.
+        bool required;
+
+        /// \brief The node index of the parameter schema.
+        std::size_t node;
+    };
+
+    /// \brief Compile a schema.
+    /// \param schema The schema to compile.
+    /// \returns the index of the compiled node.
+    /// \throws Poco::InvalidArgumentException if the schema is malformed or
+    ///         uses an unsupported keyword.
+    std::size_t _compile(const ofJson& schema);
+
+    /// \brief Validate a value against a compiled node.
+    bool _validate(std::size_t node,
+                   const ofJson& value,
+                   const std::string& path,
+                   ofJson& error) const;
+
+    /// \returns the type bit for a value.
+    static uint8_t _typeOf(const ofJson& value);
+
+    /// \returns the type bit for a JSON Schema type name.
+    static uint8_t _typeNamed(const std::string& name);
+
+    /// \returns an error description.
+    static ofJson _error(const std::string& path, const std::string& message);
+
+    /// \brief The compiled parameters, in declaration order.
+    std::vector<Parameter> _parameters;
+
+    /// \brief The compiled schema nodes.
+    std::vector<Node> _nodes;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "json.hpp"
+#include "ofx/JSONRPC/MethodArgs.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Receives the array parameters of a call one element at a time.
+///
+/// A streaming method is given a new ParamsStream for each call. When a call
+/// arrives in a streamed POST body, each element of an array-valued parameter
+/// is passed to element() as soon as it has been parsed and is then
+/// discarded, so large arrays are never held in memory. Calls that arrive in
+/// a single message are replayed through the same interface.
+///
+/// ~~~{.cpp}
+///     class PointReader: public ofx::JSONRPC::ParamsStream
+///     {
+///     public:
+///         void element(const std::string& parameter, const ofJson& value) override
+///         {
+///             mesh.addVertex(glm::vec3(value[0], value[1], value[2]));
+///         }
+///
+///         void complete(ofx::JSONRPC::MethodArgs& args) override
+///         {
+///             args.result = mesh.getNumVertices();
+///         }
+///
+///         ofMesh mesh;
+///     };
+/// ~~~
+class ParamsStream
+{
+public:
+    /// \brief Destroy the ParamsStream.
+    virtual ~ParamsStream();
+
+    /// \brief Receive one element of an array-valued parameter.
+    /// \param parameter The parameter name, or its index if the parameters
+    ///        were passed by position.
+    /// \param value The element.
+    virtual void element(const std::string& parameter, const ofJson& value) = 0;
+
+    /// \brief Complete the call after all elements have been received.
+    ///
+    /// Parameters that are not arrays are available in MethodArgs::params.
+    /// Array parameters that were streamed are left empty.
+    ///
+    /// \param args The method arguments, to be filled with a result or error.
+    virtual void complete(MethodArgs& args) = 0;
+
+    /// \brief Pass the elements of every array-valued parameter to a stream.
+    /// \param stream The stream to receive the elements.
+    /// \param params The call parameters.
+    static void replay(ParamsStream& stream, const ofJson& params);
+
+};
+
+
+/// \brief A method whose array parameters are received as a stream.
+///
+/// Streaming methods are registered with
+/// MethodRegistry_::registerStreamingMethod().
+class StreamingMethod
+{
+public:
+    /// \brief A function creating a ParamsStream for a single call.
+    typedef std::function<std::shared_ptr<ParamsStream>()> Factory;
+
+    /// \brief Create a StreamingMethod.
+    /// \param factory The function creating a ParamsStream for each call.
+    StreamingMethod(Factory factory);
+
+    /// \brief Destroy the StreamingMethod.
+    ~StreamingMethod();
+
+    /// \returns a new ParamsStream for a call.
+    std::shared_ptr<ParamsStream> open() const;
+
+    /// \brief Invoke the method with parameters that were parsed at once.
+    ///
+    /// The array parameters are replayed to a new stream before the call is
+    /// completed.
+    ///
+    /// \param args The method arguments.
+    void invoke(MethodArgs& args);
+
+private:
+    /// \brief The function creating a ParamsStream for each call.
+    Factory _factory;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "json.hpp"
+#include "ofx/JSONRPC/Error.h"
+#include "ofx/JSONRPC/Errors.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A collection of outgoing calls that are awaiting a response.
+///
+/// When a server calls a method on a remote peer, the outgoing request is
+/// assigned a unique id and registered here. When the peer's response
+/// arrives it is matched to the outstanding call by id and the call's future
+/// is fulfilled with the result.
+///
+/// If the peer responds with an error, the future will throw a
+/// JSONRPCException carrying the remote error code and message. Calls that
+/// are not answered before their deadline throw a CallTimeoutException and
+/// calls abandoned by their owner throw a ConnectionClosedException.
+///
+/// Deadlines are enforced by a TimerWheel if one is provided. Otherwise the
+/// owner must call expire() periodically.
+///
+/// PendingCalls is thread-safe.
+class PendingCalls
+{
+public:
+    /// \brief The clock used for call deadlines.
+    typedef TimerWheel::Clock Clock;
+
+    /// \brief Create an empty PendingCalls.
+    /// \param wheel An optional TimerWheel used to enforce call deadlines.
+    ///        The wheel must outlive this PendingCalls.
+    PendingCalls(TimerWheel* wheel = nullptr);
+
+    /// \brief Destroy the PendingCalls.
+    ///
+    /// Any outstanding calls are failed with RPC_ERROR_CONNECTION_CLOSED.
+    ~PendingCalls();
+
+    /// \brief Reserve a unique id for an outgoing call.
+    /// \returns a new call id.
+    uint64_t nextId();
+
+    /// \brief Begin tracking an outgoing call.
+    /// \param id The id of the outgoing call, usually from nextId().
+    /// \param owner The id of the connection that the request was sent on.
+    /// \param timeout The maximum time to wait for a response.
+    /// \param onComplete An optional function called, without any lock
+    ///        held, once the future is ready.
+    /// \returns a future that will hold the result of the call.
+    std::future<ofJson> add(uint64_t id,
+                            uint64_t owner,
+                            Clock::duration timeout,
+                            std::function<void()> onComplete = nullptr);
+
+    /// \brief Complete an outstanding call with a response.
+    ///
+    /// Call ids are predictable, so a response only completes a call that
+    /// was sent on the connection it arrived on.
+    ///
+    /// \param json A JSONRPC response object.
+    /// \param owner The id of the connection the response arrived on.
+    /// \returns true iff the response matched an outstanding call owned by
+    ///          the connection.
+    bool resolve(const ofJson& json, uint64_t owner);
+
+    /// \brief Fail an outstanding call with the given error.
+    /// \param id The id of the outstanding call.
+    /// \param error The error to deliver to the caller.
+    /// \returns true iff the id matched an outstanding call.
+    bool fail(uint64_t id, const Error& error);
+
+    /// \brief Fail all calls whose deadline has passed.
+    /// \param now The current time.
+    /// \returns the number of calls that expired.
+    std::size_t expire(Clock::time_point now = Clock::now());
+
+    /// \brief Fail all outstanding calls belonging to a connection.
+    /// \param owner The connection id passed to add().
+    /// \returns the number of calls that were cancelled.
+    std::size_t cancel(uint64_t owner);
+
+    /// \returns the number of outstanding calls.
+    std::size_t size() const;
+
+    /// \brief Determine whether the given JSON is a JSONRPC response.
+    ///
+    /// A response has an id and either a result or an error, but no method.
+    ///
+    /// \param json The JSON to test.
+    /// \returns true iff the JSON is shaped like a response.
+    static bool isResponse(const ofJson& json);
+
+private:
+    /// \brief The state of a single outstanding call.
+    struct Call
+    {
+        /// \brief The promise fulfilled when the call completes.
+        std::promise<ofJson> promise;
+
+        /// \brief The id of the connection that owns the call.
+        uint64_t owner = 0;
+
+        /// \brief The time after which the call will be failed.
+        Clock::time_point deadline;
+
+        /// \brief The deadline timer, if a wheel is in use.
+        TimerWheel::TimerId timer = 0;
+
+        /// \brief The function called once the promise is fulfilled.
+        std::function<void()> onComplete;
+    };
+
+    /// \brief Fail a call's promise with the given error.
+    ///
+    /// The call's completion function is called afterwards.
+    ///
+    /// \param call The call to fail.
+    /// \param error The error to deliver.
+    static void _fail(Call& call, const Error& error);
+
+    /// \brief Cancel a call's deadline timer, if any.
+    ///
+    /// A deadline callback that is already running is waited for, so that
+    /// it can't outlive this PendingCalls. The caller must not hold _mutex.
+    ///
+    /// \param call The call whose timer to cancel.
+    void _cancelTimer(const Call& call);
+
+    /// \brief The wheel enforcing deadlines, or nullptr.
+    TimerWheel* _wheel = nullptr;
+
+    /// \brief The last id that was issued.
+    uint64_t _lastId = 0;
+
+    /// \brief Outstanding calls keyed by id.
+    std::unordered_map<uint64_t, Call> _calls;
+
+    /// \brief A mutex to protect the outstanding calls.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::JSONRPC
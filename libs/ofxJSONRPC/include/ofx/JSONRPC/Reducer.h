@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <functional>
+#include <string>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Combines the results of one call made to several backends.
+///
+/// A reducer starts from an initial value, the accumulator, and folds each
+/// backend's result into it as the result arrives. The reducer may declare
+/// the reduction complete early, in which case the remaining results are
+/// not waited for.
+///
+/// Custom reducers are made from a function:
+///
+/// ~~~{.cpp}
+///     Reducer max(nullptr, [](ofJson& accumulator, const std::string&, ofJson& result) {
+///         if (accumulator.is_null() || result > accumulator) accumulator = std::move(result);
+///         return false;
+///     });
+/// ~~~
+class Reducer
+{
+public:
+    /// \brief A function folding a result into the accumulator.
+    ///
+    /// The function may move from the result.
+    ///
+    /// \returns true iff the reduction is complete.
+    typedef std::function<bool(ofJson& accumulator,
+                               const std::string& backend,
+                               ofJson& result)> Function;
+
+    /// \brief Create a Reducer.
+    /// \param initial The initial value of the accumulator.
+    /// \param function The function folding results into the accumulator.
+    Reducer(const ofJson& initial, Function function);
+
+    /// \brief Destroy the Reducer.
+    ~Reducer();
+
+    /// \returns the initial value of the accumulator.
+    const ofJson& initial() const;
+
+    /// \brief Fold a result into the accumulator.
+    /// \param accumulator The accumulator.
+    /// \param backend The name of the backend the result came from.
+    /// \param result The result. It may be moved from.
+    /// \returns true iff the reduction is complete.
+    bool reduce(ofJson& accumulator,
+                const std::string& backend,
+                ofJson& result) const;
+
+    /// \brief Concatenate the results into an array.
+    ///
+    /// The elements of array results are appended individually.
+    ///
+    /// \returns the reducer.
+    static Reducer concat();
+
+    /// \brief Add the results.
+    ///
+    /// Numeric results are added. Object results are added member by member
+    /// for their numeric members. Other results are ignored.
+    ///
+    /// \returns the reducer.
+    static Reducer sum();
+
+    /// \brief Collect the first results to arrive into an array.
+    ///
+    /// With a count of zero the reduction is complete, with an empty array,
+    /// at the first result.
+    ///
+    /// \param count The number of results to wait for.
+    /// \returns the reducer.
+    static Reducer firstN(std::size_t count);
+
+    /// \brief Collect the results into an object keyed by backend name.
+    /// \returns the reducer.
+    static Reducer byBackend();
+
+private:
+    /// \brief The initial value of the accumulator.
+    ofJson _initial;
+
+    /// \brief The function folding results into the accumulator.
+    Function _function;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -96,6 +96,20 @@ public:
     /// \returns JSONRPC compatible JSON.
     static ofJson toJSON(const Request& request);
 
+    /// \brief Serialize a Request from its parts.
+    ///
+    /// This is used to compose outgoing requests and notifications that do
+    /// not originate from a server event.
+    ///
+    /// \param id The request id. If null, the id is omitted and the request
+    ///        is serialized as a notification.
+    /// \param method The method's name.
+    /// \param parameters The parameters to pass to the method.
+    /// \returns JSONRPC compatible JSON.
+    static ofJson toJSON(const ofJson& id,
+                         const std::string& method,
+                         const ofJson& parameters);
+
     /// \brief Deserialize the JSON to a Request object.
     /// \param json JSONRPC compatible JSON to deserialize.
     /// \returns deserialized Request.
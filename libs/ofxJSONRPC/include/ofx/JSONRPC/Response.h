@@ -13,6 +13,7 @@
 #include "json.hpp"
 #include "ofx/JSONRPC/Error.h"
 #include "ofx/JSONRPC/BaseMessage.h"
+#include "ofx/JSONRPC/ResultWriter.h"
 
 
 namespace ofx {
@@ -62,6 +63,14 @@ public:
     const ofJson& result() const;
     OF_DEPRECATED_MSG("Use result() instead.", const ofJson& getResult() const);
 
+    /// \brief Set a producer that writes the result incrementally.
+    /// \param producer The producer, or nullptr to use result().
+    void setResultProducer(ResultWriter::Producer producer);
+
+    /// \returns the producer of the result, which is empty unless the result
+    ///          is written incrementally.
+    const ResultWriter::Producer& resultProducer() const;
+
     /// \brief Get the Error if available.
     ///
     /// The Error code will be NO_ERROR if the call was successful.
@@ -97,6 +106,9 @@ protected:
     /// \brief An Error object.  Will be empty if there is no error.
     Error _error;
 
+    /// \brief The producer of an incrementally written result, if any.
+    ResultWriter::Producer _resultProducer;
+
     /// \brief Error tag.
     static const std::string ERROR_TAG;
 
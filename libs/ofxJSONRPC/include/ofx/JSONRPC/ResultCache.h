@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "json.hpp"
+#include "ofx/JSONRPC/TimerWheel.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A cache of serialized results of idempotent methods.
+///
+/// Results are keyed by method name and parameters. Object parameters are
+/// serialized with sorted keys, so equal parameters share an entry
+/// regardless of member order. Each result is stored serialized, with an
+/// entity tag derived from its bytes, so cached results are spliced into
+/// responses without serializing them again.
+///
+/// Entries expire after their time to live. Expiry is driven by a
+/// TimerWheel. The cache is cleared whenever the generation of the method
+/// registry changes, since a re-registered method may return different
+/// results.
+///
+/// ResultCache is thread-safe.
+class ResultCache
+{
+public:
+    /// \brief A cached result.
+    struct Entry
+    {
+        /// \brief The serialized result.
+        std::shared_ptr<const std::string> result;
+
+        /// \brief The quoted entity tag of the result.
+        std::string etag;
+
+        /// \brief The time the result expires.
+        TimerWheel::Clock::time_point expires;
+    };
+
+    /// \brief Create an empty ResultCache.
+    /// \param timers The wheel that expires entries. The wheel must outlive
+    ///        the cache.
+    /// \param capacity The maximum number of entries.
+    ResultCache(TimerWheel& timers, std::size_t capacity = DEFAULT_CAPACITY);
+
+    /// \brief Destroy the ResultCache.
+    ~ResultCache();
+
+    /// \brief Set the maximum number of entries.
+    ///
+    /// Results are not cached while the cache is full. Zero disables the
+    /// cache.
+    ///
+    /// \param capacity The maximum number of entries.
+    void setCapacity(std::size_t capacity);
+
+    /// \brief Clear the cache if the registry generation has changed.
+    /// \param generation The current generation of the method registry.
+    void validate(uint64_t generation);
+
+    /// \brief Find a fresh cached result.
+    /// \param method The name of the method.
+    /// \param params The parameters of the call.
+    /// \param entry Filled with the entry if found.
+    /// \returns true iff a fresh result was found.
+    bool find(const std::string& method,
+              const ofJson& params,
+              Entry& entry) const;
+
+    /// \brief Cache a result.
+    /// \param method The name of the method.
+    /// \param params The parameters of the call.
+    /// \param result The serialized result.
+    /// \param maxAge The time the result remains fresh. Results with no
+    ///        time to live are not cached.
+    /// \returns the entry, which is returned even if it was not cached.
+    Entry insert(const std::string& method,
+                 const ofJson& params,
+                 const std::string& result,
+                 std::chrono::seconds maxAge);
+
+    /// \brief Remove every entry.
+    void clear();
+
+    /// \returns the number of cached entries.
+    std::size_t size() const;
+
+    /// \brief Compute the quoted entity tag of a serialized result.
+    /// \param result The serialized result.
+    /// \returns the entity tag.
+    static std::string toETag(const std::string& result);
+
+    /// \brief Determine whether an If-None-Match header matches an entity tag.
+    ///
+    /// The header is a comma separated list of entity tags, or `*`. Weak
+    /// tags match their strong equivalent, as RFC 7232 requires for
+    /// If-None-Match.
+    ///
+    /// \param ifNoneMatch The value of the If-None-Match header.
+    /// \param etag The quoted entity tag of the current result.
+    /// \returns true iff the header lists the entity tag or is `*`.
+    static bool matchesETag(const std::string& ifNoneMatch, const std::string& etag);
+
+    enum
+    {
+        /// \brief The default maximum number of entries.
+        DEFAULT_CAPACITY = 4096
+    };
+
+private:
+    /// \brief Compute the key of a call.
+    /// \param method The name of the method.
+    /// \param params The parameters of the call.
+    /// \returns the key.
+    static std::string _toKey(const std::string& method, const ofJson& params);
+
+    /// \brief The wheel that expires entries.
+    TimerWheel& _timers;
+
+    /// \brief The maximum number of entries.
+    std::size_t _capacity;
+
+    /// \brief The generation of the registry the entries were produced by.
+    uint64_t _generation = 0;
+
+    /// \brief The entries, keyed by call.
+    std::unordered_map<std::string, Entry> _entries;
+
+    /// \brief A mutex to protect the entries.
+    mutable std::mutex _mutex;
+
+};
+
+
+} } // namespace ofx::JSONRPC
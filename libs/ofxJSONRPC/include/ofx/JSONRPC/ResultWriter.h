@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include "json.hpp"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Writes an array result one element at a time.
+///
+/// A method that produces a large or slow result can set
+/// MethodArgs::resultProducer instead of MethodArgs::result. The producer is
+/// called with a ResultWriter after the method returns and writes the
+/// elements of the result array. POST responses are then sent with chunked
+/// transfer encoding as the elements are written, so the client receives
+/// bytes immediately and the result is never held in memory. WebSocket
+/// responses collect the elements into a single frame.
+///
+/// ~~~{.cpp}
+///     void ofApp::getFrames(ofx::JSONRPC::MethodArgs& args)
+///     {
+///         std::size_t count = args.params["count"];
+///
+///         args.resultProducer = [this, count](ofx::JSONRPC::ResultWriter& writer) {
+///             for (std::size_t i = 0; i < count; ++i)
+///             {
+///                 writer.write(renderFrame(i));
+///                 writer.flush();
+///             }
+///         };
+///     }
+/// ~~~
+///
+/// Once a chunked response has begun, its status can no longer change. If
+/// the producer throws, the response is left incomplete, which the client
+/// sees as a truncated body.
+class ResultWriter
+{
+public:
+    /// \brief A function that writes a result.
+    ///
+    /// The producer runs after the method has returned, so it must own or
+    /// copy everything it uses.
+    typedef std::function<void(ResultWriter& writer)> Producer;
+
+    /// \brief Create a ResultWriter.
+    /// \param stream The stream receiving the serialized elements.
+    ResultWriter(std::ostream& stream);
+
+    /// \brief Destroy the ResultWriter.
+    ~ResultWriter();
+
+    /// \brief Write one element of the result array.
+    /// \param element The element to write.
+    void write(const ofJson& element);
+
+    /// \brief Write one element that has already been serialized.
+    /// \param element The serialized JSON element.
+    void writeSerialized(const std::string& element);
+
+    /// \brief Send the elements written so far to the client.
+    void flush();
+
+    /// \returns the number of elements written.
+    std::size_t size() const;
+
+    /// \brief Write a complete response whose result is produced by a
+    ///        producer.
+    /// \param stream The stream receiving the response.
+    /// \param id The id of the call.
+    /// \param producer The producer writing the result.
+    static void writeResponse(std::ostream& stream,
+                              const ofJson& id,
+                              const Producer& producer);
+
+    /// \brief Collect a produced result into an array.
+    /// \param producer The producer writing the result.
+    /// \returns the result array.
+    static ofJson collect(const Producer& producer);
+
+private:
+    /// \brief Write a separator before every element but the first.
+    void _separate();
+
+    /// \brief The stream receiving the serialized elements.
+    std::ostream& _stream;
+
+    /// \brief The number of elements written.
+    std::size_t _size = 0;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,265 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+#include "json.hpp"
+#include "ofx/JSONRPC/MethodArgs.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief An interface to a fixed table of methods.
+///
+/// A MethodRegistry consults its static method table before its dynamic
+/// methods. Implementations are usually created with StaticMethodTable.
+class AbstractStaticMethodTable
+{
+public:
+    /// \brief A function that invokes one method of a table.
+    typedef void (*Invoker)(const AbstractStaticMethodTable& table, MethodArgs& args);
+
+    /// \brief Destroy the AbstractStaticMethodTable.
+    virtual ~AbstractStaticMethodTable()
+    {
+    }
+
+    /// \brief Find a method by name.
+    /// \param method The name of the method.
+    /// \returns the method's invoker, or nullptr if not found.
+    Invoker find(const std::string& method) const
+    {
+        std::size_t position = 0;
+        return find(method, position);
+    }
+
+    /// \brief Find a method and its position by name.
+    /// \param method The name of the method.
+    /// \param position Set to the method's position in the table, from zero
+    ///        to one less than the number of methods, if it is found.
+    /// \returns the method's invoker, or nullptr if not found.
+    virtual Invoker find(const std::string& method, std::size_t& position) const = 0;
+
+    /// \returns a map of the method names and their descriptions.
+    virtual std::map<std::string, ofJson> methods() const = 0;
+
+    /// \brief Hash a method name with 64-bit FNV-1a at compile time.
+    /// \param name The null terminated method name.
+    /// \param hash The running hash value.
+    /// \returns the hash of the name.
+    static constexpr uint64_t hash(const char* name,
+                                   uint64_t hash = 14695981039346656037ULL)
+    {
+        return *name == '\0' ? hash : AbstractStaticMethodTable::hash(name + 1, (hash ^ uint64_t(uint8_t(*name))) * 1099511628211ULL);
+    }
+
+    /// \brief Hash a method name with 64-bit FNV-1a at runtime.
+    /// \param name The method name.
+    /// \returns the hash of the name.
+    static uint64_t hash(const std::string& name)
+    {
+        uint64_t result = 14695981039346656037ULL;
+
+        for (char c: name)
+        {
+            result = (result ^ uint64_t(uint8_t(c))) * 1099511628211ULL;
+        }
+
+        return result;
+    }
+
+};
+
+
+/// \brief A convenience base for statically declared methods.
+///
+/// A static method is a type with a constexpr name(), a static invoke()
+/// function and an optional static description(). Deriving from StaticMethod
+/// binds invoke() directly to a listener member function so that the call
+/// can be inlined:
+///
+/// ~~~{.cpp}
+///     struct GetText: ofx::JSONRPC::StaticMethod<ofApp, &ofApp::getText>
+///     {
+///         static constexpr const char* name() { return "get-text"; }
+///     };
+/// ~~~
+///
+/// \tparam ListenerClass The class implementing the method.
+/// \tparam ListenerMethod The member function implementing the method.
+template <class ListenerClass, void (ListenerClass::*ListenerMethod)(MethodArgs&)>
+struct StaticMethod
+{
+    /// \returns the method description advertised to clients.
+    static ofJson description()
+    {
+        return nullptr;
+    }
+
+    /// \brief Invoke the method on a listener.
+    /// \param listener The listener to invoke.
+    /// \param args The method arguments.
+    static void invoke(ListenerClass& listener, MethodArgs& args)
+    {
+        (listener.*ListenerMethod)(args);
+    }
+
+};
+
+
+/// \brief A method table whose methods are fixed at compile time.
+///
+/// Methods are declared as a type list. Each method name is hashed at
+/// compile time into a sorted array, and a static_assert rejects tables in
+/// which two names hash to the same value. Lookup hashes the requested name
+/// once, binary searches the sorted hashes and confirms the match with a
+/// single string comparison. The selected invoker calls the typed handler
+/// directly.
+///
+/// A static table is attached to a MethodRegistry with
+/// MethodRegistry_::setStaticMethods(). Methods can still be registered
+/// dynamically on the same registry; static methods take precedence.
+///
+/// ~~~{.cpp}
+///     server.setStaticMethods(std::make_shared<ofx::JSONRPC::StaticMethodTable<ofApp, GetText, SetText>>(*this));
+/// ~~~
+///
+/// \tparam ListenerClass The class implementing the methods.
+/// \tparam Methods The static method types.
+template <class ListenerClass, typename... Methods>
+class StaticMethodTable: public AbstractStaticMethodTable
+{
+public:
+    /// \brief Create a StaticMethodTable.
+    /// \param listener The listener that implements the methods. The
+    ///        listener must outlive the table.
+    StaticMethodTable(ListenerClass& listener): _listener(&listener)
+    {
+        static_assert(_distinct(_index()),
+                      "Static method names must be unique and their hashes must not collide.");
+    }
+
+    /// \brief Destroy the StaticMethodTable.
+    virtual ~StaticMethodTable()
+    {
+    }
+
+    using AbstractStaticMethodTable::find;
+
+    Invoker find(const std::string& method, std::size_t& position) const override
+    {
+        static constexpr Index index = _index();
+        static const Invoker invokers[] = { &_invoke<Methods>..., nullptr };
+        static const char* const names[] = { Methods::name()..., nullptr };
+
+        uint64_t methodHash = AbstractStaticMethodTable::hash(method);
+
+        const uint64_t* first = index.hashes;
+        const uint64_t* last = index.hashes + sizeof...(Methods);
+        const uint64_t* iter = std::lower_bound(first, last, methodHash);
+
+        if (iter == last || *iter != methodHash)
+        {
+            return nullptr;
+        }
+
+        std::size_t i = index.methods[iter - first];
+
+        if (method != names[i])
+        {
+            return nullptr;
+        }
+
+        position = i;
+        return invokers[i];
+    }
+
+    std::map<std::string, ofJson> methods() const override
+    {
+        std::map<std::string, ofJson> result;
+
+        using expander = int[];
+        (void) expander { 0, (result[Methods::name()] = Methods::description(), 0)... };
+
+        return result;
+    }
+
+private:
+    /// \brief The method name hashes in ascending order.
+    ///
+    /// Each array has a trailing unused slot so that an empty table is valid.
+    struct Index
+    {
+        /// \brief The sorted hashes.
+        uint64_t hashes[sizeof...(Methods) + 1];
+
+        /// \brief The declaration index of the method with each hash.
+        std::size_t methods[sizeof...(Methods) + 1];
+    };
+
+    /// \brief Invoke a method type on the table's listener.
+    template <typename Method>
+    static void _invoke(const AbstractStaticMethodTable& table, MethodArgs& args)
+    {
+        Method::invoke(*static_cast<const StaticMethodTable&>(table)._listener, args);
+    }
+
+    /// \returns the method name hashes, sorted at compile time.
+    static constexpr Index _index()
+    {
+        const uint64_t hashes[] = { AbstractStaticMethodTable::hash(Methods::name())..., 0 };
+
+        Index index = { { }, { } };
+
+        for (std::size_t i = 0; i < sizeof...(Methods); ++i)
+        {
+            std::size_t j = i;
+
+            while (j > 0 && index.hashes[j - 1] > hashes[i])
+            {
+                index.hashes[j] = index.hashes[j - 1];
+                index.methods[j] = index.methods[j - 1];
+                --j;
+            }
+
+            index.hashes[j] = hashes[i];
+            index.methods[j] = i;
+        }
+
+        return index;
+    }
+
+    /// \returns true iff no two sorted hashes are equal.
+    static constexpr bool _distinct(const Index& index)
+    {
+        for (std::size_t i = 1; i < sizeof...(Methods); ++i)
+        {
+            if (index.hashes[i - 1] == index.hashes[i])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// \brief The listener implementing the methods.
+    ListenerClass* _listener;
+
+};
+
+
+} } // namespace ofx::JSONRPC
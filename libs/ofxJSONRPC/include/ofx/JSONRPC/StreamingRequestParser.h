@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "ofx/JSONRPC/MessageLimits.h"
+#include "ofx/JSONRPC/ParamsStream.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Parses a request incrementally as its body is read.
+///
+/// The envelope is validated as soon as each member is read. A `jsonrpc`
+/// member other than "2.0" or a `method` that is not a string ends the parse
+/// immediately. Once the method is known, the resolver is asked for a
+/// ParamsStream. If it returns one, each element of an array-valued parameter
+/// that follows is passed to the stream and discarded instead of being added
+/// to the parsed document.
+///
+/// If the `params` member precedes the `method` member, the parameters are
+/// parsed normally and replayed to the stream once the parse is complete.
+/// Either way the returned request has its streamed arrays emptied.
+///
+/// Limits are enforced on the retained document as they are by
+/// MessageLimits::parse(). Streamed elements are checked one at a time, so
+/// the element limit applies to each element rather than to the whole body.
+/// MessageLimits::maxMessageSize is checked against the bytes read outside
+/// of streamed elements as they are read, so it holds for bodies of any
+/// declared or undeclared length. The whole body may be bounded separately.
+class StreamingRequestParser
+{
+public:
+    /// \brief A function returning a ParamsStream for a method, or nullptr
+    ///        if the method does not stream its parameters.
+    typedef std::function<std::shared_ptr<ParamsStream>(const std::string& method)> Resolver;
+
+    /// \brief Create a StreamingRequestParser.
+    /// \param limits The limits to enforce.
+    /// \param resolver The function returning streams for methods.
+    /// \param maxBodySize The maximum number of bytes to read, including
+    ///        streamed elements. Zero disables the check.
+    StreamingRequestParser(const MessageLimits& limits,
+                           Resolver resolver,
+                           uint64_t maxBodySize = 0);
+
+    /// \brief Destroy the StreamingRequestParser.
+    ~StreamingRequestParser();
+
+    /// \brief Parse a request from a stream.
+    /// \param stream The stream to read.
+    /// \returns the request with any streamed arrays emptied.
+    /// \throws Poco::InvalidArgumentException if the envelope is invalid.
+    /// \throws LimitExceededException if a limit is exceeded.
+    /// \throws std::invalid_argument if the body is not valid JSON.
+    ofJson parse(std::istream& stream);
+
+    /// \brief Parse a request whose first bytes have already been read.
+    ///
+    /// This lets a caller copy the start of a body, e.g. to record it,
+    /// without buffering the rest.
+    ///
+    /// \param head The bytes already read from the stream.
+    /// \param stream The stream to read the rest of the request from.
+    /// \returns the request with any streamed arrays emptied.
+    /// \throws Poco::InvalidArgumentException if the envelope is invalid.
+    /// \throws LimitExceededException if a limit is exceeded.
+    /// \throws std::invalid_argument if the body is not valid JSON.
+    ofJson parse(const std::string& head, std::istream& stream);
+
+    /// \returns the stream that received the parameters, or nullptr if the
+    ///          method does not stream its parameters.
+    std::shared_ptr<ParamsStream> paramsStream() const;
+
+    /// \returns the number of bytes read so far.
+    uint64_t bytesRead() const;
+
+private:
+    /// \brief Handle one parser event.
+    /// \returns false if the parsed value should be discarded.
+    bool _onEvent(int depth, ofJson::parse_event_t event, ofJson& parsed);
+
+    /// \brief Check a member of the envelope as soon as it is parsed.
+    void _onMember(const std::string& key, const ofJson& value);
+
+    /// \returns true iff an event at a depth belongs to an element of a
+    ///          streamed array parameter.
+    bool _isStreamedElement(int depth) const;
+
+    /// \brief Account for the bytes read since the last check.
+    /// \param isStreamed True iff the bytes belong to a streamed element.
+    /// \throws LimitExceededException if a size limit is exceeded.
+    void _checkSize(bool isStreamed);
+
+    /// \brief The limits to enforce.
+    MessageLimits _limits;
+
+    /// \brief The function returning streams for methods.
+    Resolver _resolver;
+
+    /// \brief The maximum number of bytes to read, or zero for no limit.
+    uint64_t _maxBodySize = 0;
+
+    /// \brief The number of bytes read from the stream.
+    uint64_t _bytesRead = 0;
+
+    /// \brief The number of bytes read when the size was last checked.
+    uint64_t _bytesChecked = 0;
+
+    /// \brief The number of bytes read outside of streamed elements.
+    uint64_t _bytesRetained = 0;
+
+    /// \brief The stream receiving the parameters, if any.
+    std::shared_ptr<ParamsStream> _stream;
+
+    /// \brief True iff the parameters were streamed while parsing.
+    bool _streamed = false;
+
+    /// \brief The container type at each depth, '{' or '['.
+    std::vector<char> _containers;
+
+    /// \brief The most recent key at each depth.
+    std::vector<std::string> _keys;
+
+    /// \brief The number of completed values at each depth.
+    std::vector<std::size_t> _counts;
+
+    /// \brief The number of retained keys and values.
+    std::size_t _elements = 0;
+
+    /// \brief The number of keys and values in the current streamed element.
+    std::size_t _elementElements = 0;
+
+};
+
+
+} } // namespace ofx::JSONRPC
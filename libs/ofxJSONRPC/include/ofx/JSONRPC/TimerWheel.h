@@ -0,0 +1,238 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A hierarchical timing wheel.
+///
+/// A TimerWheel schedules large numbers of coarse timers (session expiry,
+/// idle timeouts, call deadlines, etc) with constant time schedule and cancel
+/// operations. Time is divided into ticks of a fixed resolution. Timers that
+/// are due within the next LEVEL_SIZE ticks live in the first level; timers
+/// further in the future live in coarser levels and are cascaded down as the
+/// wheel turns.
+///
+/// The wheel can be driven manually by calling advance() periodically (or on
+/// demand), or by a dedicated thread started with start(). A single wheel
+/// thread can serve every timer in a server. Callbacks are invoked from the
+/// thread calling advance(), outside of the wheel's lock, so callbacks may
+/// safely schedule or cancel timers.
+///
+/// TimerWheel is thread-safe.
+class TimerWheel
+{
+public:
+    /// \brief The clock used by the wheel.
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief A timer callback.
+    typedef std::function<void()> Callback;
+
+    /// \brief A timer id. Zero is never a valid id.
+    typedef uint64_t TimerId;
+
+    /// \brief Create a TimerWheel.
+    /// \param resolution The duration of a single tick.
+    TimerWheel(Clock::duration resolution = std::chrono::milliseconds(DEFAULT_RESOLUTION_MS));
+
+    /// \brief Destroy the TimerWheel.
+    ///
+    /// The wheel thread is stopped if running and pending timers are
+    /// discarded.
+    ~TimerWheel();
+
+    /// \brief Start a thread that advances the wheel once per tick.
+    ///
+    /// Calling start() on a running wheel has no effect.
+    void start();
+
+    /// \brief Stop the wheel thread and wait for it to exit.
+    ///
+    /// Calling stop() on a stopped wheel has no effect.
+    void stop();
+
+    /// \returns true iff the wheel thread is running.
+    bool isRunning() const;
+
+    /// \brief Schedule a callback.
+    /// \param delay The time from now after which the callback is invoked.
+    ///        Delays are rounded up to the tick resolution.
+    /// \param callback The callback to invoke.
+    /// \returns the id of the new timer.
+    TimerId schedule(Clock::duration delay, Callback callback);
+
+    /// \brief Cancel a timer.
+    ///
+    /// A timer that has come due but whose callback has not yet started is
+    /// still cancelled. A callback that is already running is not waited
+    /// for.
+    ///
+    /// \param id The id of the timer to cancel.
+    /// \returns true iff the timer was pending and is now cancelled.
+    bool cancel(TimerId id);
+
+    /// \brief Cancel a timer and wait for its callback if it is running.
+    ///
+    /// Once this returns, the callback is not running and will not run, so
+    /// the objects it refers to may be destroyed. The exception is a
+    /// callback cancelling its own timer, which is not waited for. The
+    /// caller must not hold a lock that the callback takes.
+    ///
+    /// \param id The id of the timer to cancel.
+    /// \returns true iff the timer was pending and is now cancelled.
+    bool cancelAndWait(TimerId id);
+
+    /// \brief Fire all timers that have come due.
+    ///
+    /// If another thread is already advancing the wheel, this returns
+    /// immediately. Calling advance() when no tick has elapsed is a cheap,
+    /// lock-free check.
+    ///
+    /// \param now The current time.
+    /// \returns the number of callbacks that were invoked.
+    std::size_t advance(Clock::time_point now = Clock::now());
+
+    /// \returns the number of pending timers.
+    std::size_t size() const;
+
+    /// \returns the duration of a single tick.
+    Clock::duration resolution() const;
+
+    /// \brief The default tick resolution in milliseconds.
+    enum
+    {
+        DEFAULT_RESOLUTION_MS = 100
+    };
+
+private:
+    enum
+    {
+        /// \brief The number of bits of the tick count covered by a level.
+        LEVEL_BITS = 6,
+
+        /// \brief The number of slots in each level.
+        LEVEL_SIZE = 1 << LEVEL_BITS,
+
+        /// \brief The number of levels.
+        NUM_LEVELS = 4
+    };
+
+    /// \brief A single scheduled timer.
+    struct Timer
+    {
+        /// \brief The timer id.
+        TimerId id;
+
+        /// \brief The tick at which the timer is due.
+        uint64_t expiry;
+
+        /// \brief The callback to invoke.
+        Callback callback;
+    };
+
+    /// \brief A slot holds all timers that are cascaded or fired together.
+    typedef std::list<Timer> Slot;
+
+    /// \brief The location of a timer within the wheel.
+    struct Location
+    {
+        Slot* slot;
+        Slot::iterator iterator;
+    };
+
+    /// \brief Select the slot for a timer, relative to the current tick.
+    /// \param expiry The tick at which the timer is due.
+    /// \returns the slot that the timer belongs in.
+    Slot& _slotFor(uint64_t expiry);
+
+    /// \brief Move a node from one slot into the correct slot for its expiry.
+    /// \param from The slot currently holding the timer.
+    /// \param iterator The timer to move.
+    void _place(Slot& from, Slot::iterator iterator);
+
+    /// \brief Convert a time to a tick count since the wheel started.
+    uint64_t _tickAt(Clock::time_point time) const;
+
+    /// \brief Cancel a pending or due timer.
+    ///
+    /// The caller must hold _mutex.
+    ///
+    /// \param id The id of the timer to cancel.
+    /// \returns true iff the timer was cancelled.
+    bool _cancel(TimerId id);
+
+    /// \brief The duration of a tick.
+    Clock::duration _resolution;
+
+    /// \brief The time that the wheel started.
+    Clock::time_point _start;
+
+    /// \brief The last tick that was processed.
+    std::atomic<uint64_t> _currentTick;
+
+    /// \brief The last timer id that was issued.
+    TimerId _lastId = 0;
+
+    /// \brief The wheel levels, finest first.
+    std::array<std::array<Slot, LEVEL_SIZE>, NUM_LEVELS> _levels;
+
+    /// \brief The location of each pending timer.
+    std::unordered_map<TimerId, Location> _timers;
+
+    /// \brief The timers that have come due and whose callbacks have not
+    ///        yet started.
+    std::unordered_set<TimerId> _due;
+
+    /// \brief The timer whose callback is running, or zero.
+    TimerId _firing = 0;
+
+    /// \brief The thread running the current callback.
+    std::thread::id _firingThread;
+
+    /// \brief Signaled each time a callback returns.
+    std::condition_variable _fired;
+
+    /// \brief A mutex to protect the wheel.
+    mutable std::mutex _mutex;
+
+    /// \brief A mutex held while advancing so that only one thread advances.
+    std::mutex _advanceMutex;
+
+    /// \brief The wheel thread.
+    std::thread _thread;
+
+    /// \brief True while the wheel thread should keep running.
+    bool _running = false;
+
+    /// \brief A mutex to protect the running state.
+    mutable std::mutex _threadMutex;
+
+    /// \brief Signaled to wake the wheel thread when stopping.
+    std::condition_variable _condition;
+
+};
+
+
+} } // namespace ofx::JSONRPC
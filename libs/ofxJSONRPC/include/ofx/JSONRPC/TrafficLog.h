@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief A message recorded in a traffic log.
+struct TrafficRecord
+{
+    /// \brief The transports a message can arrive on.
+    enum Source
+    {
+        /// \brief A WebSocket text frame.
+        SOURCE_WEBSOCKET = 0,
+        /// \brief The body of a POST request.
+        SOURCE_POST = 1
+    };
+
+    /// \brief The time the message arrived, relative to the start of the
+    ///        capture.
+    std::chrono::microseconds time = std::chrono::microseconds(0);
+
+    /// \brief The id of the connection the message arrived on.
+    ///
+    /// Messages that did not arrive on a persistent connection have id 0.
+    uint64_t connectionId = 0;
+
+    /// \brief The transport the message arrived on.
+    Source source = SOURCE_WEBSOCKET;
+
+    /// \brief The raw bytes of the message.
+    std::string message;
+};
+
+
+/// \brief Records incoming messages to a compact binary log.
+///
+/// A log starts with an eight byte signature and the wall clock time of the
+/// start of the capture in microseconds since the Unix epoch. Each record
+/// follows as the microseconds since the previous record, the connection
+/// id, a source byte, the message size and the raw message. Integers are
+/// unsigned LEB128 varints, so a small message costs a few bytes more than
+/// its payload.
+///
+/// If the log can't be written, e.g. because the disk is full, an error is
+/// logged and recording stops, so that the log ends with the last complete
+/// record.
+///
+/// TrafficRecorder is thread-safe.
+class TrafficRecorder
+{
+public:
+    /// \brief The clock used to time records.
+    typedef std::chrono::steady_clock Clock;
+
+    /// \brief Create a TrafficRecorder and start a capture.
+    /// \param path The path of the log file. An existing file is replaced.
+    /// \throws Poco::IOException if the file cannot be opened.
+    TrafficRecorder(const std::string& path);
+
+    /// \brief Destroy the TrafficRecorder, flushing the log.
+    ~TrafficRecorder();
+
+    /// \brief Record a message.
+    ///
+    /// The message is ignored once recording has stopped.
+    ///
+    /// \param connectionId The id of the connection the message arrived on.
+    /// \param source The transport the message arrived on.
+    /// \param message The raw message.
+    void record(uint64_t connectionId,
+                TrafficRecord::Source source,
+                const std::string& message);
+
+    /// \brief Write buffered records to the file.
+    void flush();
+
+    /// \returns the number of records written.
+    uint64_t records() const;
+
+    /// \returns the path of the log file.
+    const std::string& path() const;
+
+    /// \returns false iff recording stopped because the log couldn't be
+    ///          written.
+    bool isRecording() const;
+
+    /// \brief The signature at the start of every log.
+    static const std::string SIGNATURE;
+
+private:
+    /// \brief Write an unsigned LEB128 varint.
+    /// \param value The value to write.
+    void _writeVarint(uint64_t value);
+
+    /// \brief Stop recording after a write failed.
+    void _fail();
+
+    /// \brief The path of the log file.
+    std::string _path;
+
+    /// \brief The log file.
+    std::ofstream _stream;
+
+    /// \brief The time the capture started.
+    Clock::time_point _start;
+
+    /// \brief The time of the previous record, relative to the start.
+    std::chrono::microseconds _previous;
+
+    /// \brief The number of records written.
+    uint64_t _records = 0;
+
+    /// \brief True iff a write failed and recording stopped.
+    bool _failed = false;
+
+    /// \brief A mutex to serialize records.
+    mutable std::mutex _mutex;
+
+};
+
+
+/// \brief Reads the records of a traffic log in order.
+class TrafficReader
+{
+public:
+    /// \brief Open a traffic log.
+    /// \param path The path of the log file.
+    /// \throws Poco::IOException if the file cannot be opened.
+    /// \throws Poco::DataFormatException if the file is not a traffic log.
+    TrafficReader(const std::string& path);
+
+    /// \brief Destroy the TrafficReader.
+    ~TrafficReader();
+
+    /// \brief Read the next record.
+    ///
+    /// A record cut short, e.g. by a crash during capture, ends the log.
+    ///
+    /// \param record Filled with the next record.
+    /// \returns true iff a record was read.
+    bool next(TrafficRecord& record);
+
+    /// \returns the wall clock time the capture started, in microseconds
+    ///          since the Unix epoch.
+    uint64_t startTime() const;
+
+private:
+    /// \brief Read an unsigned LEB128 varint.
+    /// \param value Filled with the value read.
+    /// \returns true iff a complete varint was read.
+    bool _readVarint(uint64_t& value);
+
+    /// \brief The log file.
+    std::ifstream _stream;
+
+    /// \brief The wall clock time the capture started.
+    uint64_t _startTime = 0;
+
+    /// \brief The size of the log file.
+    std::streamoff _size = 0;
+
+    /// \brief The time of the previous record, relative to the start.
+    std::chrono::microseconds _previous;
+
+};
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <string>
+#include "json.hpp"
+#include "ofx/HTTP/PostRoute.h"
+#include "ofx/JSONRPC/ParamsStream.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+/// \brief Receives the files of a multipart upload as they arrive.
+///
+/// An upload method is called by posting a `multipart/form-data` form whose
+/// file input is named after the method. Each file is written to the
+/// PostRoute's upload folder as it is received, and upload() is called as
+/// each file starts, progresses and finishes, so the file can be consumed
+/// while it is still arriving. The bytes received so far are in the file
+/// named by PostUploadEventArgs::getFilename().
+///
+/// When the form is complete, complete() is called with the parameters
+/// taken from the form's optional `params` field, which holds JSON. The
+/// result is returned as a JSON-RPC response using the form's optional `id`
+/// field.
+///
+/// ~~~{.html}
+///     <form method="post" action="/post" enctype="multipart/form-data">
+///         <input type="hidden" name="id" value="1">
+///         <input type="hidden" name="params" value='{"folder":"models"}'>
+///         <input type="file" name="upload-asset">
+///     </form>
+/// ~~~
+///
+/// Upload methods are registered with MethodRegistry_::registerUploadMethod()
+/// and may also be called without uploads like any other method.
+class UploadStream: public ParamsStream
+{
+public:
+    /// \brief Destroy the UploadStream.
+    virtual ~UploadStream();
+
+    /// \brief Receive the progress of an uploaded file.
+    /// \param args The upload state, file names and bytes transferred.
+    virtual void upload(const HTTP::PostUploadEventArgs& args) = 0;
+
+    /// \brief Ignore streamed parameter elements.
+    ///
+    /// Override this if the method also accepts streamed array parameters.
+    void element(const std::string& parameter, const ofJson& value) override;
+
+};
+
+
+} } // namespace ofx::JSONRPC
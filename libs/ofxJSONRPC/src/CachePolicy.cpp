@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/CachePolicy.h"
+#include <algorithm>
+#include "ofx/JSONRPC/JSONRPCUtils.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+const std::string CachePolicy::IDEMPOTENT_KEY = "x-idempotent";
+const std::string CachePolicy::MAX_AGE_KEY = "x-max-age";
+
+
+CachePolicy::CachePolicy():
+    _maxAge(0)
+{
+}
+
+
+CachePolicy::CachePolicy(const ofJson& description):
+    _maxAge(0)
+{
+    if (!description.is_object())
+    {
+        return;
+    }
+
+    _isIdempotent = JSONRPCUtils::hasKeyOfType(description, IDEMPOTENT_KEY, ofJson::value_t::boolean)
+                 && description[IDEMPOTENT_KEY].get<bool>();
+
+    auto maxAge = description.find(MAX_AGE_KEY);
+
+    // Parsed ages are unsigned integers, which hasIntegerKey() rejects.
+    if (_isIdempotent && maxAge != description.end() && maxAge->is_number_integer())
+    {
+        _maxAge = std::chrono::seconds(std::max<int64_t>(0, maxAge->get<int64_t>()));
+    }
+}
+
+
+CachePolicy::~CachePolicy()
+{
+}
+
+
+bool CachePolicy::isIdempotent() const
+{
+    return _isIdempotent;
+}
+
+
+std::chrono::seconds CachePolicy::maxAge() const
+{
+    return _maxAge;
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/CircuitBreaker.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerSettings& settings):
+    _settings(settings)
+{
+}
+
+
+CircuitBreaker::~CircuitBreaker()
+{
+}
+
+
+CircuitBreaker::Ticket CircuitBreaker::allow()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_metrics.state == STATE_OPEN && Clock::now() >= _openUntil)
+    {
+        _enter(STATE_HALF_OPEN);
+    }
+
+    Ticket ticket;
+
+    if (_metrics.state == STATE_CLOSED
+    || (_metrics.state == STATE_HALF_OPEN && _probes < _settings.halfOpenProbes))
+    {
+        ++_metrics.allowed;
+
+        ticket.epoch = _epoch;
+        ticket.probe = _metrics.state == STATE_HALF_OPEN;
+
+        if (ticket.probe)
+        {
+            ++_probes;
+        }
+    }
+    else
+    {
+        ++_metrics.refused;
+    }
+
+    return ticket;
+}
+
+
+void CircuitBreaker::record(const Ticket& ticket, bool success, Clock::duration latency)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // The breaker has changed state since the call was allowed.
+    if (!ticket || ticket.epoch != _epoch)
+    {
+        return;
+    }
+
+    auto now = Clock::now();
+
+    if (_metrics.averageLatency == Clock::duration::zero())
+    {
+        _metrics.averageLatency = latency;
+    }
+    else
+    {
+        _metrics.averageLatency += std::chrono::duration_cast<Clock::duration>(
+            (latency - _metrics.averageLatency) * _settings.latencyWeight);
+    }
+
+    bool slow = latency >= _settings.slowCallDuration;
+
+    _consecutiveFailures = success ? 0 : _consecutiveFailures + 1;
+    _consecutiveSlowCalls = slow ? _consecutiveSlowCalls + 1 : 0;
+
+    if (!success)
+    {
+        ++_metrics.failures;
+    }
+
+    if (_metrics.state == STATE_HALF_OPEN && ticket.probe)
+    {
+        --_probes;
+
+        // A slow probe shows the endpoint has not recovered.
+        if (!success || slow)
+        {
+            _trip(now);
+        }
+        else if (++_probeSuccesses >= _settings.halfOpenSuccesses)
+        {
+            _enter(STATE_CLOSED);
+        }
+    }
+    else if (_metrics.state == STATE_CLOSED)
+    {
+        if ((_settings.failureThreshold > 0 && _consecutiveFailures >= _settings.failureThreshold)
+         || (_settings.slowCallThreshold > 0 && _consecutiveSlowCalls >= _settings.slowCallThreshold))
+        {
+            _trip(now);
+        }
+    }
+}
+
+
+void CircuitBreaker::cancel(const Ticket& ticket)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (ticket.probe && ticket.epoch == _epoch && _probes > 0)
+    {
+        --_probes;
+    }
+}
+
+
+void CircuitBreaker::reset()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _enter(STATE_CLOSED);
+    _metrics.averageLatency = Clock::duration::zero();
+}
+
+
+CircuitBreaker::State CircuitBreaker::state() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // An open breaker reports half-open once it would allow a probe.
+    if (_metrics.state == STATE_OPEN && Clock::now() >= _openUntil)
+    {
+        return STATE_HALF_OPEN;
+    }
+
+    return _metrics.state;
+}
+
+
+CircuitBreaker::Clock::duration CircuitBreaker::averageLatency() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _metrics.averageLatency;
+}
+
+
+CircuitBreaker::Metrics CircuitBreaker::metrics() const
+{
+    Metrics metrics;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        metrics = _metrics;
+    }
+
+    metrics.state = state();
+    return metrics;
+}
+
+
+std::string CircuitBreaker::toString(State state)
+{
+    switch (state)
+    {
+        case STATE_CLOSED:
+            return "closed";
+        case STATE_OPEN:
+            return "open";
+        case STATE_HALF_OPEN:
+            return "half-open";
+    }
+
+    return "unknown";
+}
+
+
+void CircuitBreaker::_trip(Clock::time_point now)
+{
+    _enter(STATE_OPEN);
+    _openUntil = now + _settings.openDuration;
+    ++_metrics.trips;
+}
+
+
+void CircuitBreaker::_enter(State state)
+{
+    _metrics.state = state;
+    _consecutiveFailures = 0;
+    _consecutiveSlowCalls = 0;
+    _probes = 0;
+    _probeSuccesses = 0;
+    ++_epoch;
+}
+
+
+} } // namespace ofx::JSONRPC
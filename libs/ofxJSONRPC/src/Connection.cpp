@@ -0,0 +1,464 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/Connection.h"
+#include "ofx/JSONRPC/Request.h"
+#include <algorithm>
+#include "Poco/Net/WebSocket.h"
+#include "ofLog.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+Connection::State::State(uint64_t id, HTTP::WebSocketConnection* connection):
+    id(id),
+    open(connection != nullptr),
+    connection(connection),
+    lastActivity(std::chrono::steady_clock::now().time_since_epoch().count()),
+    outboundBudget(0),
+    queuedBytes(0)
+{
+}
+
+
+Connection::Connection()
+{
+}
+
+
+Connection::Connection(uint64_t id, HTTP::WebSocketConnection& connection):
+    _state(std::make_shared<State>(id, &connection))
+{
+}
+
+
+Connection::~Connection()
+{
+}
+
+
+uint64_t Connection::id() const
+{
+    return _state ? _state->id : 0;
+}
+
+
+bool Connection::isOpen() const
+{
+    return _state && _state->open.load(std::memory_order_acquire);
+}
+
+
+bool Connection::send(const std::string& text) const
+{
+    return _send(HTTP::WebSocketFrame(text), text.size());
+}
+
+
+bool Connection::send(const HTTP::WebSocketFrame& frame) const
+{
+    return _send(frame, frame.size());
+}
+
+
+bool Connection::notify(const std::string& method, const ofJson& params) const
+{
+    return send(Request::toJSON(nullptr, method, params).dump());
+}
+
+
+bool Connection::ping() const
+{
+    return send(HTTP::WebSocketFrame("", Poco::Net::WebSocket::FRAME_FLAG_FIN
+                                       | Poco::Net::WebSocket::FRAME_OP_PING));
+}
+
+
+bool Connection::disconnect() const
+{
+    return send(HTTP::WebSocketFrame("", Poco::Net::WebSocket::FRAME_FLAG_FIN
+                                       | Poco::Net::WebSocket::FRAME_OP_CLOSE));
+}
+
+
+void Connection::setOutboundBudget(std::size_t bytes) const
+{
+    if (_state)
+    {
+        _state->outboundBudget.store(bytes);
+    }
+}
+
+
+std::size_t Connection::outboundBudget() const
+{
+    return _state ? _state->outboundBudget.load() : 0;
+}
+
+
+std::size_t Connection::queuedBytes() const
+{
+    return _state ? _state->queuedBytes.load() : 0;
+}
+
+
+void Connection::sent(std::size_t bytes) const
+{
+    if (!_state)
+    {
+        return;
+    }
+
+    // Frames that were not queued through this handle may be reported too,
+    // so never let the count wrap.
+    std::size_t queued = _state->queuedBytes.load();
+
+    while (!_state->queuedBytes.compare_exchange_weak(queued, queued - std::min(queued, bytes)))
+    {
+    }
+}
+
+
+void Connection::touch() const
+{
+    if (_state)
+    {
+        _state->lastActivity.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                                   std::memory_order_relaxed);
+    }
+}
+
+
+std::chrono::steady_clock::time_point Connection::lastActivity() const
+{
+    if (!_state)
+    {
+        return std::chrono::steady_clock::time_point();
+    }
+
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(_state->lastActivity.load(std::memory_order_relaxed)));
+}
+
+
+void Connection::attach(std::shared_ptr<const Attachment> attachment) const
+{
+    if (_state)
+    {
+        std::atomic_store(&_state->attachment, attachment);
+    }
+}
+
+
+std::shared_ptr<const Connection::Attachment> Connection::attachment() const
+{
+    if (!_state)
+    {
+        return nullptr;
+    }
+
+    return std::atomic_load(&_state->attachment);
+}
+
+
+bool Connection::_send(const HTTP::WebSocketFrame& frame, std::size_t size) const
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(_state->mutex);
+
+    if (_state->connection == nullptr)
+    {
+        return false;
+    }
+
+    std::size_t budget = _state->outboundBudget.load();
+
+    if (budget > 0 && _state->queuedBytes.load() + size > budget)
+    {
+        ofLogWarning("Connection::send") << "Connection " << _state->id << " exceeded its outbound budget of " << budget << " bytes; closing.";
+
+        _state->connection->sendFrame(HTTP::WebSocketFrame("", Poco::Net::WebSocket::FRAME_FLAG_FIN
+                                                              | Poco::Net::WebSocket::FRAME_OP_CLOSE));
+        return false;
+    }
+
+    _state->queuedBytes += size;
+
+    if (!_state->connection->sendFrame(frame))
+    {
+        sent(size);
+        return false;
+    }
+
+    return true;
+}
+
+
+void Connection::close()
+{
+    if (_state)
+    {
+        _state->open.store(false, std::memory_order_release);
+        std::atomic_store(&_state->attachment, std::shared_ptr<const Attachment>());
+        std::unique_lock<std::mutex> lock(_state->mutex);
+        _state->connection = nullptr;
+    }
+}
+
+
+Connection::operator bool() const
+{
+    return _state != nullptr;
+}
+
+
+bool Connection::operator == (const Connection& other) const
+{
+    return _state == other._state;
+}
+
+
+bool Connection::operator != (const Connection& other) const
+{
+    return _state != other._state;
+}
+
+
+ConnectionRegistry::ConnectionRegistry()
+{
+}
+
+
+ConnectionRegistry::~ConnectionRegistry()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (auto& connection: _byId)
+    {
+        connection.second.close();
+    }
+}
+
+
+Connection ConnectionRegistry::add(HTTP::WebSocketConnection& connection)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto iter = _bySocket.find(&connection);
+
+    if (iter != _bySocket.end())
+    {
+        return iter->second;
+    }
+
+    Connection handle(++_lastId, connection);
+    _bySocket[&connection] = handle;
+    _byId[handle.id()] = handle;
+    return handle;
+}
+
+
+Connection ConnectionRegistry::remove(const HTTP::WebSocketConnection& connection)
+{
+    Connection handle;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _bySocket.find(&connection);
+
+        if (iter == _bySocket.end())
+        {
+            return handle;
+        }
+
+        handle = iter->second;
+        _byId.erase(handle.id());
+        _bySocket.erase(iter);
+
+        auto membership = _memberships.find(handle.id());
+
+        if (membership != _memberships.end())
+        {
+            for (const auto& name: membership->second)
+            {
+                auto group = _groups.find(name);
+
+                if (group != _groups.end())
+                {
+                    group->second.erase(handle.id());
+
+                    if (group->second.empty())
+                    {
+                        _groups.erase(group);
+                    }
+                }
+            }
+
+            _memberships.erase(membership);
+        }
+    }
+
+    handle.close();
+    return handle;
+}
+
+
+Connection ConnectionRegistry::find(const HTTP::WebSocketConnection& connection) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto iter = _bySocket.find(&connection);
+    return iter != _bySocket.end() ? iter->second : Connection();
+}
+
+
+Connection ConnectionRegistry::find(uint64_t id) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto iter = _byId.find(id);
+    return iter != _byId.end() ? iter->second : Connection();
+}
+
+
+std::vector<Connection> ConnectionRegistry::connections() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::vector<Connection> result;
+    result.reserve(_byId.size());
+
+    for (const auto& connection: _byId)
+    {
+        result.push_back(connection.second);
+    }
+
+    return result;
+}
+
+
+std::size_t ConnectionRegistry::size() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _byId.size();
+}
+
+
+bool ConnectionRegistry::join(const std::string& group,
+                              const Connection& connection)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_byId.find(connection.id()) == _byId.end())
+    {
+        return false;
+    }
+
+    if (!_groups[group].emplace(connection.id(), connection).second)
+    {
+        return false;
+    }
+
+    _memberships[connection.id()].insert(group);
+    return true;
+}
+
+
+bool ConnectionRegistry::leave(const std::string& group,
+                               const Connection& connection)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto iter = _groups.find(group);
+
+    if (iter == _groups.end() || iter->second.erase(connection.id()) == 0)
+    {
+        return false;
+    }
+
+    if (iter->second.empty())
+    {
+        _groups.erase(iter);
+    }
+
+    auto membership = _memberships.find(connection.id());
+
+    if (membership != _memberships.end())
+    {
+        membership->second.erase(group);
+
+        if (membership->second.empty())
+        {
+            _memberships.erase(membership);
+        }
+    }
+
+    return true;
+}
+
+
+std::vector<Connection> ConnectionRegistry::members(const std::string& group) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::vector<Connection> result;
+
+    auto iter = _groups.find(group);
+
+    if (iter != _groups.end())
+    {
+        result.reserve(iter->second.size());
+
+        for (const auto& connection: iter->second)
+        {
+            result.push_back(connection.second);
+        }
+    }
+
+    return result;
+}
+
+
+std::size_t ConnectionRegistry::broadcast(const std::string& method,
+                                          const ofJson& params) const
+{
+    HTTP::WebSocketFrame frame(Request::toJSON(nullptr, method, params).dump());
+    return broadcast(connections(), frame);
+}
+
+
+std::size_t ConnectionRegistry::broadcast(const std::string& group,
+                                          const std::string& method,
+                                          const ofJson& params) const
+{
+    HTTP::WebSocketFrame frame(Request::toJSON(nullptr, method, params).dump());
+    return broadcast(members(group), frame);
+}
+
+
+std::size_t ConnectionRegistry::broadcast(const std::vector<Connection>& connections,
+                                          const HTTP::WebSocketFrame& frame)
+{
+    std::size_t count = 0;
+
+    for (const auto& connection: connections)
+    {
+        if (connection.send(frame))
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -19,6 +19,10 @@ const int Errors::RPC_ERROR_METHOD_NOT_FOUND    = -32601;
 const int Errors::RPC_ERROR_INVALID_PARAMETERS  = -32602;
 const int Errors::RPC_ERROR_INTERNAL_ERROR      = -32603;
 const int Errors::RPC_ERROR_PARSE               = -32700;
+const int Errors::RPC_ERROR_TIMEOUT             = -32000;
+const int Errors::RPC_ERROR_CONNECTION_CLOSED   = -32001;
+const int Errors::RPC_ERROR_LIMIT_EXCEEDED      = -32002;
+const int Errors::RPC_ERROR_UNAVAILABLE         = -32003;
 
 
 std::string Errors::getErrorMessage(int code)
@@ -37,6 +41,14 @@ std::string Errors::getErrorMessage(int code)
             return "RPC_ERROR_INTERNAL_ERROR";
         case Errors::RPC_ERROR_PARSE:
             return "RPC_ERROR_PARSE";
+        case Errors::RPC_ERROR_TIMEOUT:
+            return "RPC_ERROR_TIMEOUT";
+        case Errors::RPC_ERROR_CONNECTION_CLOSED:
+            return "RPC_ERROR_CONNECTION_CLOSED";
+        case Errors::RPC_ERROR_LIMIT_EXCEEDED:
+            return "RPC_ERROR_LIMIT_EXCEEDED";
+        case Errors::RPC_ERROR_UNAVAILABLE:
+            return "RPC_ERROR_UNAVAILABLE";
         default:
         {
             if (code >= -32099 && code <= -32000)
@@ -77,5 +89,21 @@ POCO_IMPLEMENT_EXCEPTION(ParseException,
                          JSONRPCException,
                          "RPC_ERROR_PARSE")
 
+POCO_IMPLEMENT_EXCEPTION(CallTimeoutException,
+                         JSONRPCException,
+                         "RPC_ERROR_TIMEOUT")
+
+POCO_IMPLEMENT_EXCEPTION(ConnectionClosedException,
+                         JSONRPCException,
+                         "RPC_ERROR_CONNECTION_CLOSED")
+
+POCO_IMPLEMENT_EXCEPTION(LimitExceededException,
+                         JSONRPCException,
+                         "RPC_ERROR_LIMIT_EXCEEDED")
+
+POCO_IMPLEMENT_EXCEPTION(UnavailableException,
+                         JSONRPCException,
+                         "RPC_ERROR_UNAVAILABLE")
+
 
 } } // namespace ofx::JSONRPC
@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/HashRing.h"
+#include "ofx/JSONRPC/StaticMethodTable.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+HashRing::HashRing(std::size_t replicas):
+    _replicas(replicas > 0 ? replicas : 1)
+{
+}
+
+
+HashRing::~HashRing()
+{
+}
+
+
+void HashRing::add(const std::string& node, std::size_t weight)
+{
+    remove(node);
+
+    weight = weight > 0 ? weight : 1;
+
+    for (std::size_t i = 0; i < _replicas * weight; ++i)
+    {
+        // On a collision the earlier node keeps the point.
+        _ring.insert(std::make_pair(_point(node + '#' + std::to_string(i)), node));
+    }
+
+    _weights[node] = weight;
+}
+
+
+void HashRing::remove(const std::string& node)
+{
+    if (_weights.erase(node) == 0)
+    {
+        return;
+    }
+
+    auto iter = _ring.begin();
+
+    while (iter != _ring.end())
+    {
+        if (iter->second == node)
+        {
+            iter = _ring.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+
+std::string HashRing::find(const std::string& key) const
+{
+    if (_ring.empty())
+    {
+        return std::string();
+    }
+
+    auto iter = _ring.lower_bound(_point(key));
+
+    // The ring wraps around to its first point.
+    return iter != _ring.end() ? iter->second : _ring.begin()->second;
+}
+
+
+bool HashRing::has(const std::string& node) const
+{
+    return _weights.find(node) != _weights.end();
+}
+
+
+std::vector<std::string> HashRing::nodes() const
+{
+    std::vector<std::string> nodes;
+
+    for (const auto& weight: _weights)
+    {
+        nodes.push_back(weight.first);
+    }
+
+    return nodes;
+}
+
+
+bool HashRing::empty() const
+{
+    return _weights.empty();
+}
+
+
+uint64_t HashRing::_point(const std::string& value)
+{
+    // FNV-1a clusters similar strings, so the hash is finalized to spread
+    // the points of a node around the ring.
+    uint64_t point = AbstractStaticMethodTable::hash(value);
+    point = (point ^ (point >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    point = (point ^ (point >> 27)) * 0x94d049bb133111ebULL;
+    return point ^ (point >> 31);
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/MessageLimits.h"
+#include "ofx/JSONRPC/Errors.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+void MessageLimits::checkSize(std::size_t size) const
+{
+    if (maxMessageSize > 0 && size > maxMessageSize)
+    {
+        throw LimitExceededException("Message is " + std::to_string(size) + " bytes; the limit is " + std::to_string(maxMessageSize) + ".");
+    }
+}
+
+
+ofJson MessageLimits::parse(const std::string& text) const
+{
+    checkSize(text.size());
+
+    std::size_t elements = 0;
+
+    return ofJson::parse(text, [&](int depth, ofJson::parse_event_t event, ofJson& parsed) {
+        check(depth, event, parsed, elements);
+        return true;
+    });
+}
+
+
+void MessageLimits::check(int depth,
+                          ofJson::parse_event_t event,
+                          const ofJson& parsed,
+                          std::size_t& elements) const
+{
+    switch (event)
+    {
+        case ofJson::parse_event_t::object_start:
+        case ofJson::parse_event_t::array_start:
+            if (maxDepth > 0 && std::size_t(depth) + 1 > maxDepth)
+            {
+                throw LimitExceededException("Message is nested more than " + std::to_string(maxDepth) + " levels deep.");
+            }
+            break;
+        case ofJson::parse_event_t::key:
+        case ofJson::parse_event_t::value:
+            if (maxElements > 0 && ++elements > maxElements)
+            {
+                throw LimitExceededException("Message has more than " + std::to_string(maxElements) + " elements.");
+            }
+
+            if (maxStringLength > 0
+            && parsed.is_string()
+            && parsed.get_ref<const std::string&>().size() > maxStringLength)
+            {
+                throw LimitExceededException("Message has a string longer than " + std::to_string(maxStringLength) + " bytes.");
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+
+} } // namespace ofx::JSONRPC
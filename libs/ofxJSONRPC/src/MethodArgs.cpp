@@ -13,9 +13,11 @@ namespace JSONRPC {
 
 
 MethodArgs::MethodArgs(HTTP::ServerEventArgs& evt,
-                       const ofJson& params):
+                       const ofJson& params,
+                       const Connection& connection):
     HTTP::ServerEventArgs(evt),
     params(params),
+    connection(connection),
     result(nullptr),
     error(Error())
 {
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/MethodCatalog.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+const std::string MethodCatalog::DISCOVER_METHOD = "rpc.discover";
+const std::string MethodCatalog::OPENRPC_VERSION = "1.2.6";
+
+
+MethodCatalog::MethodCatalog():
+    _info({ { "title", "ofxJSONRPC" }, { "version", "1.0.0" } }),
+    _infoGeneration(0)
+{
+}
+
+
+MethodCatalog::~MethodCatalog()
+{
+}
+
+
+void MethodCatalog::setInfo(const ofJson& info)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _info = info;
+    ++_infoGeneration;
+}
+
+
+ofJson MethodCatalog::info() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _info;
+}
+
+
+std::shared_ptr<const std::string> MethodCatalog::document(uint64_t generation,
+                                                           const MethodSource& source) const
+{
+    return document(generation, source, *this);
+}
+
+
+std::shared_ptr<const std::string> MethodCatalog::document(uint64_t generation,
+                                                           const MethodSource& source,
+                                                           const MethodCatalog& infoSource) const
+{
+    uint64_t infoGeneration = infoSource._infoGeneration.load();
+
+    std::shared_ptr<const Document> document = std::atomic_load(&_document);
+
+    if (document && document->generation == generation && document->infoGeneration == infoGeneration)
+    {
+        return document->text;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Another thread may have rebuilt the document while we waited.
+    document = std::atomic_load(&_document);
+
+    if (document && document->generation == generation && document->infoGeneration == infoGeneration)
+    {
+        return document->text;
+    }
+
+    // Our own info is guarded by the lock we hold.
+    ofJson info = (&infoSource == this) ? _info : infoSource.info();
+
+    std::shared_ptr<const std::string> text = std::make_shared<const std::string>(toOpenRPC(info, source()).dump());
+
+    std::atomic_store(&_document, std::shared_ptr<const Document>(std::make_shared<Document>(Document { generation, infoGeneration, text })));
+
+    return text;
+}
+
+
+ofJson MethodCatalog::toOpenRPC(const ofJson& info,
+                                const std::map<std::string, ofJson>& methods)
+{
+    ofJson result;
+
+    result["openrpc"] = OPENRPC_VERSION;
+    result["info"] = info;
+    result["methods"] = ofJson::array();
+
+    for (const auto& method: methods)
+    {
+        ofJson entry = method.second.is_object() ? method.second : ofJson::object();
+
+        if (method.second.is_string())
+        {
+            entry["description"] = method.second;
+        }
+
+        entry["name"] = method.first;
+
+        if (entry.find("params") == entry.end())
+        {
+            entry["params"] = ofJson::array();
+        }
+
+        result["methods"].push_back(entry);
+    }
+
+    return result;
+}
+
+
+std::string MethodCatalog::toResponse(const ofJson& id, const std::string& result)
+{
+    std::string response;
+    std::string idText = id.dump();
+
+    response.reserve(result.size() + idText.size() + 48);
+    response += "{\"id\":";
+    response += idText;
+    response += ",\"jsonrpc\":\"2.0\",\"result\":";
+    response += result;
+    response += "}";
+
+    return response;
+}
+
+
+} } // namespace ofx::JSONRPC
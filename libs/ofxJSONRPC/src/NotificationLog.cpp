@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/NotificationLog.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+NotificationLog::NotificationLog(std::size_t capacity):
+    _capacity(capacity)
+{
+}
+
+
+NotificationLog::~NotificationLog()
+{
+    release();
+}
+
+
+void NotificationLog::setCapacity(std::size_t capacity)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _capacity = capacity;
+
+    while (_entries.size() > _capacity)
+    {
+        _entries.pop_front();
+    }
+}
+
+
+uint64_t NotificationLog::publish(const std::string& topic, Message message)
+{
+    uint64_t id = 0;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        id = ++_lastId;
+
+        if (_capacity > 0)
+        {
+            if (_entries.size() >= _capacity)
+            {
+                _entries.pop_front();
+            }
+
+            Entry entry;
+            entry.id = id;
+            entry.topic = topic;
+            entry.message = std::move(message);
+
+            _entries.push_back(std::move(entry));
+        }
+    }
+
+    _condition.notify_all();
+
+    return id;
+}
+
+
+std::vector<NotificationLog::Entry> NotificationLog::since(uint64_t id) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    std::vector<Entry> entries;
+
+    if (_entries.empty() || id >= _lastId)
+    {
+        return entries;
+    }
+
+    // Sequence numbers are contiguous, so the first newer entry is found
+    // by offset rather than by search.
+    uint64_t first = _entries.front().id;
+    std::size_t offset = id < first ? 0 : std::size_t(id - first + 1);
+
+    entries.assign(_entries.begin() + offset, _entries.end());
+
+    return entries;
+}
+
+
+uint64_t NotificationLog::lastId() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _lastId;
+}
+
+
+bool NotificationLog::wait(uint64_t id,
+                           uint64_t epoch,
+                           std::chrono::milliseconds timeout) const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    return _condition.wait_for(lock, timeout, [&]() {
+        return _lastId > id || _epoch != epoch;
+    });
+}
+
+
+uint64_t NotificationLog::epoch() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _epoch;
+}
+
+
+void NotificationLog::release()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        ++_epoch;
+    }
+
+    _condition.notify_all();
+}
+
+
+} } // namespace ofx::JSONRPC
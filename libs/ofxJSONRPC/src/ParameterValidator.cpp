@@ -0,0 +1,566 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/ParameterValidator.h"
+#include <algorithm>
+#include <cmath>
+#include "Poco/Exception.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+namespace {
+
+
+/// \brief Keywords that only annotate a schema and never affect validation.
+const char* const ANNOTATION_KEYWORDS[] = {
+    "$comment",
+    "$id",
+    "$schema",
+    "default",
+    "deprecated",
+    "description",
+    "examples",
+    "readOnly",
+    "title",
+    "writeOnly"
+};
+
+
+/// \brief Keywords that are compiled into a node.
+const char* const SUPPORTED_KEYWORDS[] = {
+    "additionalProperties",
+    "const",
+    "enum",
+    "exclusiveMaximum",
+    "exclusiveMinimum",
+    "items",
+    "maxItems",
+    "maxLength",
+    "maximum",
+    "minItems",
+    "minLength",
+    "minimum",
+    "properties",
+    "required",
+    "type"
+};
+
+
+bool isKnownKeyword(const std::string& keyword)
+{
+    for (const char* known: SUPPORTED_KEYWORDS)
+    {
+        if (keyword == known) return true;
+    }
+
+    for (const char* known: ANNOTATION_KEYWORDS)
+    {
+        if (keyword == known) return true;
+    }
+
+    return false;
+}
+
+
+/// \brief Escape a reference token for use in a JSON pointer (RFC 6901).
+std::string escapePointer(const std::string& token)
+{
+    std::string escaped;
+    escaped.reserve(token.size());
+
+    for (char c: token)
+    {
+        if (c == '~') escaped += "~0";
+        else if (c == '/') escaped += "~1";
+        else escaped += c;
+    }
+
+    return escaped;
+}
+
+
+} // namespace
+
+
+ParameterValidator::ParameterValidator()
+{
+}
+
+
+ParameterValidator::ParameterValidator(const ofJson& description)
+{
+    if (!description.is_object())
+    {
+        return;
+    }
+
+    auto params = description.find("params");
+
+    if (params == description.end() || !params->is_array())
+    {
+        return;
+    }
+
+    for (const auto& param: *params)
+    {
+        if (!param.is_object() || param.find("name") == param.end() || !param["name"].is_string())
+        {
+            throw Poco::InvalidArgumentException("Each parameter must be an object with a name.");
+        }
+
+        Parameter parameter;
+        parameter.name = param["name"].get<std::string>();
+        parameter.required = param.value("required", false);
+        parameter.node = _compile(param.value("schema", ofJson::object()));
+        _parameters.push_back(parameter);
+    }
+}
+
+
+ParameterValidator::~ParameterValidator()
+{
+}
+
+
+bool ParameterValidator::isEmpty() const
+{
+    return _parameters.empty();
+}
+
+
+bool ParameterValidator::validate(const ofJson& params, ofJson& error) const
+{
+    if (_parameters.empty())
+    {
+        return true;
+    }
+
+    if (params.is_array())
+    {
+        if (params.size() > _parameters.size())
+        {
+            error = _error("", "Expected at most " + std::to_string(_parameters.size()) + " parameters.");
+            return false;
+        }
+
+        for (std::size_t i = 0; i < _parameters.size(); ++i)
+        {
+            const Parameter& parameter = _parameters[i];
+
+            if (i >= params.size())
+            {
+                if (parameter.required)
+                {
+                    error = _error("/" + std::to_string(i), "Missing required parameter \"" + parameter.name + "\".");
+                    return false;
+                }
+            }
+            else if (!_validate(parameter.node, params[i], "/" + std::to_string(i), error))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (params.is_object() || params.is_null())
+    {
+        for (const auto& parameter: _parameters)
+        {
+            auto value = params.is_object() ? params.find(parameter.name) : params.end();
+
+            if (value == params.end())
+            {
+                if (parameter.required)
+                {
+                    error = _error("/" + escapePointer(parameter.name), "Missing required parameter \"" + parameter.name + "\".");
+                    return false;
+                }
+            }
+            else if (!_validate(parameter.node, *value, "/" + escapePointer(parameter.name), error))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    error = _error("", "Parameters must be an array or an object.");
+    return false;
+}
+
+
+std::size_t ParameterValidator::_compile(const ofJson& schema)
+{
+    if (schema.is_boolean())
+    {
+        Node node;
+        node.types = schema.get<bool>() ? TYPE_ANY : 0;
+        _nodes.push_back(node);
+        return _nodes.size() - 1;
+    }
+
+    if (!schema.is_object())
+    {
+        throw Poco::InvalidArgumentException("A schema must be an object or a boolean.");
+    }
+
+    // An unsupported keyword would silently accept values that the schema
+    // author meant to reject, so refuse to compile the schema instead.
+    for (auto keyword = schema.begin(); keyword != schema.end(); ++keyword)
+    {
+        if (!isKnownKeyword(keyword.key()))
+        {
+            throw Poco::InvalidArgumentException("Unsupported schema keyword \"" + keyword.key() + "\".");
+        }
+    }
+
+    Node node;
+
+    auto number = [&](const char* keyword, uint16_t constraint, double& target) {
+        auto iter = schema.find(keyword);
+
+        if (iter != schema.end())
+        {
+            if (!iter->is_number())
+            {
+                throw Poco::InvalidArgumentException(std::string(keyword) + " must be a number.");
+            }
+
+            target = iter->get<double>();
+            node.constraints |= constraint;
+        }
+    };
+
+    auto size = [&](const char* keyword, uint16_t constraint, std::size_t& target) {
+        auto iter = schema.find(keyword);
+
+        if (iter != schema.end())
+        {
+            if (!iter->is_number_unsigned() && !(iter->is_number_integer() && iter->get<int64_t>() >= 0))
+            {
+                throw Poco::InvalidArgumentException(std::string(keyword) + " must be a non-negative integer.");
+            }
+
+            target = iter->get<std::size_t>();
+            node.constraints |= constraint;
+        }
+    };
+
+    auto type = schema.find("type");
+
+    if (type != schema.end())
+    {
+        node.types = 0;
+
+        if (type->is_string())
+        {
+            node.types = _typeNamed(type->get<std::string>());
+        }
+        else if (type->is_array())
+        {
+            for (const auto& name: *type)
+            {
+                if (!name.is_string())
+                {
+                    throw Poco::InvalidArgumentException("type must be a string or an array of strings.");
+                }
+
+                node.types |= _typeNamed(name.get<std::string>());
+            }
+        }
+        else
+        {
+            throw Poco::InvalidArgumentException("type must be a string or an array of strings.");
+        }
+    }
+
+    auto values = schema.find("enum");
+
+    if (values != schema.end())
+    {
+        if (!values->is_array())
+        {
+            throw Poco::InvalidArgumentException("enum must be an array.");
+        }
+
+        node.values.assign(values->begin(), values->end());
+        node.constraints |= HAS_ENUM;
+    }
+
+    auto constant = schema.find("const");
+
+    if (constant != schema.end())
+    {
+        node.values.assign(1, *constant);
+        node.constraints |= HAS_ENUM;
+    }
+
+    number("minimum", HAS_MINIMUM, node.minimum);
+    number("maximum", HAS_MAXIMUM, node.maximum);
+    number("exclusiveMinimum", HAS_EXCLUSIVE_MINIMUM, node.exclusiveMinimum);
+    number("exclusiveMaximum", HAS_EXCLUSIVE_MAXIMUM, node.exclusiveMaximum);
+    size("minLength", HAS_MIN_LENGTH, node.minLength);
+    size("maxLength", HAS_MAX_LENGTH, node.maxLength);
+    size("minItems", HAS_MIN_ITEMS, node.minItems);
+    size("maxItems", HAS_MAX_ITEMS, node.maxItems);
+
+    auto required = schema.find("required");
+
+    if (required != schema.end())
+    {
+        if (!required->is_array())
+        {
+            throw Poco::InvalidArgumentException("required must be an array.");
+        }
+
+        for (const auto& name: *required)
+        {
+            if (!name.is_string())
+            {
+                throw Poco::InvalidArgumentException("required must be an array of strings.");
+            }
+
+            node.required.push_back(name.get<std::string>());
+        }
+
+        node.constraints |= HAS_REQUIRED;
+    }
+
+    auto additionalProperties = schema.find("additionalProperties");
+
+    if (additionalProperties != schema.end())
+    {
+        if (!additionalProperties->is_boolean())
+        {
+            throw Poco::InvalidArgumentException("additionalProperties must be a boolean.");
+        }
+
+        if (!additionalProperties->get<bool>())
+        {
+            node.constraints |= NO_ADDITIONAL_PROPERTIES;
+        }
+    }
+
+    // Child nodes are compiled after this node is stored, so hold its index.
+    _nodes.push_back(node);
+    std::size_t index = _nodes.size() - 1;
+
+    auto items = schema.find("items");
+
+    if (items != schema.end())
+    {
+        std::size_t child = _compile(*items);
+        _nodes[index].items = child;
+        _nodes[index].constraints |= HAS_ITEMS;
+    }
+
+    auto properties = schema.find("properties");
+
+    if (properties != schema.end())
+    {
+        if (!properties->is_object())
+        {
+            throw Poco::InvalidArgumentException("properties must be an object.");
+        }
+
+        std::vector<std::pair<std::string, std::size_t>> compiled;
+
+        for (auto property = properties->begin(); property != properties->end(); ++property)
+        {
+            compiled.push_back(std::make_pair(property.key(), _compile(property.value())));
+        }
+
+        std::sort(compiled.begin(), compiled.end());
+
+        _nodes[index].properties = std::move(compiled);
+        _nodes[index].constraints |= HAS_PROPERTIES;
+    }
+
+    return index;
+}
+
+
+bool ParameterValidator::_validate(std::size_t index,
+                                   const ofJson& value,
+                                   const std::string& path,
+                                   ofJson& error) const
+{
+    const Node& node = _nodes[index];
+
+    uint8_t type = _typeOf(value);
+    uint8_t mask = type;
+
+    // A "number" schema allows integers, and integral floats are integers.
+    if (type == TYPE_NUMBER)
+    {
+        double number = value.get<double>();
+
+        if (std::isfinite(number) && std::floor(number) == number)
+        {
+            mask |= TYPE_INTEGER;
+        }
+    }
+
+    if ((node.types & mask) == 0)
+    {
+        error = _error(path, "Unexpected type.");
+        return false;
+    }
+
+    if (node.constraints == 0)
+    {
+        return true;
+    }
+
+    if ((node.constraints & HAS_ENUM)
+    && std::find(node.values.begin(), node.values.end(), value) == node.values.end())
+    {
+        error = _error(path, "Value is not one of the allowed values.");
+        return false;
+    }
+
+    if (type == TYPE_INTEGER || type == TYPE_NUMBER)
+    {
+        double number = value.get<double>();
+
+        if (((node.constraints & HAS_MINIMUM) && number < node.minimum)
+        || ((node.constraints & HAS_MAXIMUM) && number > node.maximum)
+        || ((node.constraints & HAS_EXCLUSIVE_MINIMUM) && number <= node.exclusiveMinimum)
+        || ((node.constraints & HAS_EXCLUSIVE_MAXIMUM) && number >= node.exclusiveMaximum))
+        {
+            error = _error(path, "Value is out of range.");
+            return false;
+        }
+    }
+    else if (type == TYPE_STRING)
+    {
+        std::size_t length = value.get_ref<const std::string&>().size();
+
+        if (((node.constraints & HAS_MIN_LENGTH) && length < node.minLength)
+        || ((node.constraints & HAS_MAX_LENGTH) && length > node.maxLength))
+        {
+            error = _error(path, "String length is out of range.");
+            return false;
+        }
+    }
+    else if (type == TYPE_ARRAY)
+    {
+        if (((node.constraints & HAS_MIN_ITEMS) && value.size() < node.minItems)
+        || ((node.constraints & HAS_MAX_ITEMS) && value.size() > node.maxItems))
+        {
+            error = _error(path, "Array size is out of range.");
+            return false;
+        }
+
+        if (node.constraints & HAS_ITEMS)
+        {
+            for (std::size_t i = 0; i < value.size(); ++i)
+            {
+                if (!_validate(node.items, value[i], path + "/" + std::to_string(i), error))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    else if (type == TYPE_OBJECT)
+    {
+        if (node.constraints & HAS_REQUIRED)
+        {
+            for (const auto& name: node.required)
+            {
+                if (value.find(name) == value.end())
+                {
+                    error = _error(path + "/" + escapePointer(name), "Missing required property \"" + name + "\".");
+                    return false;
+                }
+            }
+        }
+
+        if (node.constraints & (HAS_PROPERTIES | NO_ADDITIONAL_PROPERTIES))
+        {
+            for (auto property = value.begin(); property != value.end(); ++property)
+            {
+                auto compiled = std::lower_bound(node.properties.begin(),
+                                                 node.properties.end(),
+                                                 property.key(),
+                                                 [](const std::pair<std::string, std::size_t>& lhs, const std::string& rhs) {
+                                                     return lhs.first < rhs;
+                                                 });
+
+                if (compiled != node.properties.end() && compiled->first == property.key())
+                {
+                    if (!_validate(compiled->second, property.value(), path + "/" + escapePointer(property.key()), error))
+                    {
+                        return false;
+                    }
+                }
+                else if (node.constraints & NO_ADDITIONAL_PROPERTIES)
+                {
+                    error = _error(path + "/" + escapePointer(property.key()), "Unexpected property.");
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+uint8_t ParameterValidator::_typeOf(const ofJson& value)
+{
+    switch (value.type())
+    {
+        case ofJson::value_t::null:
+            return TYPE_NULL;
+        case ofJson::value_t::boolean:
+            return TYPE_BOOLEAN;
+        case ofJson::value_t::number_integer:
+        case ofJson::value_t::number_unsigned:
+            return TYPE_INTEGER;
+        case ofJson::value_t::number_float:
+            return TYPE_NUMBER;
+        case ofJson::value_t::string:
+            return TYPE_STRING;
+        case ofJson::value_t::array:
+            return TYPE_ARRAY;
+        case ofJson::value_t::object:
+            return TYPE_OBJECT;
+        default:
+            return 0;
+    }
+}
+
+
+uint8_t ParameterValidator::_typeNamed(const std::string& name)
+{
+    if (name == "null") return TYPE_NULL;
+    if (name == "boolean") return TYPE_BOOLEAN;
+    if (name == "integer") return TYPE_INTEGER;
+    if (name == "number") return TYPE_INTEGER | TYPE_NUMBER;
+    if (name == "string") return TYPE_STRING;
+    if (name == "array") return TYPE_ARRAY;
+    if (name == "object") return TYPE_OBJECT;
+
+    throw Poco::InvalidArgumentException("Unknown schema type \"" + name + "\".");
+}
+
+
+ofJson ParameterValidator::_error(const std::string& path, const std::string& message)
+{
+    return { { "path", path }, { "message", message } };
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/ParamsStream.h"
+#include "Poco/Exception.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+ParamsStream::~ParamsStream()
+{
+}
+
+
+void ParamsStream::replay(ParamsStream& stream, const ofJson& params)
+{
+    if (params.is_array())
+    {
+        for (std::size_t i = 0; i < params.size(); ++i)
+        {
+            if (params[i].is_array())
+            {
+                std::string parameter = std::to_string(i);
+
+                for (const auto& value: params[i])
+                {
+                    stream.element(parameter, value);
+                }
+            }
+        }
+    }
+    else if (params.is_object())
+    {
+        for (auto param = params.begin(); param != params.end(); ++param)
+        {
+            if (param.value().is_array())
+            {
+                for (const auto& value: param.value())
+                {
+                    stream.element(param.key(), value);
+                }
+            }
+        }
+    }
+}
+
+
+StreamingMethod::StreamingMethod(Factory factory): _factory(factory)
+{
+    if (!_factory)
+    {
+        throw Poco::InvalidArgumentException("A streaming method requires a factory.");
+    }
+}
+
+
+StreamingMethod::~StreamingMethod()
+{
+}
+
+
+std::shared_ptr<ParamsStream> StreamingMethod::open() const
+{
+    std::shared_ptr<ParamsStream> stream = _factory();
+
+    if (!stream)
+    {
+        throw Poco::NullPointerException("The streaming method factory returned no stream.");
+    }
+
+    return stream;
+}
+
+
+void StreamingMethod::invoke(MethodArgs& args)
+{
+    std::shared_ptr<ParamsStream> stream = open();
+    ParamsStream::replay(*stream, args.params);
+    stream->complete(args);
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/PendingCalls.h"
+#include <vector>
+#include "ofx/JSONRPC/JSONRPCUtils.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+PendingCalls::PendingCalls(TimerWheel* wheel):
+    _wheel(wheel)
+{
+}
+
+
+PendingCalls::~PendingCalls()
+{
+    std::unordered_map<uint64_t, Call> calls;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        calls.swap(_calls);
+    }
+
+    // Timers are cancelled outside of the lock, since a deadline callback
+    // that is already running takes it.
+    for (auto& call: calls)
+    {
+        _cancelTimer(call.second);
+        _fail(call.second, Error(Errors::RPC_ERROR_CONNECTION_CLOSED));
+    }
+}
+
+
+uint64_t PendingCalls::nextId()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return ++_lastId;
+}
+
+
+std::future<ofJson> PendingCalls::add(uint64_t id,
+                                      uint64_t owner,
+                                      Clock::duration timeout,
+                                      std::function<void()> onComplete)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    Call& call = _calls[id];
+    call.promise = std::promise<ofJson>();
+    call.owner = owner;
+    call.deadline = Clock::now() + timeout;
+    call.onComplete = std::move(onComplete);
+
+    if (_wheel != nullptr)
+    {
+        call.timer = _wheel->schedule(timeout, [this, id]() {
+            fail(id, Error(Errors::RPC_ERROR_TIMEOUT));
+        });
+    }
+
+    return call.promise.get_future();
+}
+
+
+bool PendingCalls::resolve(const ofJson& json, uint64_t owner)
+{
+    auto idIter = json.find("id");
+
+    if (idIter == json.end() || !idIter->is_number_unsigned())
+    {
+        return false;
+    }
+
+    uint64_t id = idIter->get<uint64_t>();
+
+    Call call;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _calls.find(id);
+
+        if (iter == _calls.end() || iter->second.owner != owner)
+        {
+            return false;
+        }
+
+        call = std::move(iter->second);
+        _calls.erase(iter);
+    }
+
+    _cancelTimer(call);
+
+    auto errorIter = json.find("error");
+
+    if (errorIter != json.end() && !errorIter->is_null())
+    {
+        _fail(call, Error::fromJSON(*errorIter));
+    }
+    else
+    {
+        auto resultIter = json.find("result");
+        call.promise.set_value(resultIter != json.end() ? *resultIter : ofJson());
+
+        if (call.onComplete)
+        {
+            call.onComplete();
+        }
+    }
+
+    return true;
+}
+
+
+bool PendingCalls::fail(uint64_t id, const Error& error)
+{
+    Call call;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _calls.find(id);
+
+        if (iter == _calls.end())
+        {
+            return false;
+        }
+
+        call = std::move(iter->second);
+        _calls.erase(iter);
+    }
+
+    _cancelTimer(call);
+
+    _fail(call, error);
+    return true;
+}
+
+
+std::size_t PendingCalls::expire(Clock::time_point now)
+{
+    std::vector<Call> expired;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _calls.begin();
+
+        while (iter != _calls.end())
+        {
+            if (iter->second.deadline <= now)
+            {
+                expired.push_back(std::move(iter->second));
+                iter = _calls.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    for (auto& call: expired)
+    {
+        _cancelTimer(call);
+        _fail(call, Error(Errors::RPC_ERROR_TIMEOUT));
+    }
+
+    return expired.size();
+}
+
+
+std::size_t PendingCalls::cancel(uint64_t owner)
+{
+    std::vector<Call> cancelled;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _calls.begin();
+
+        while (iter != _calls.end())
+        {
+            if (iter->second.owner == owner)
+            {
+                cancelled.push_back(std::move(iter->second));
+                iter = _calls.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+    for (auto& call: cancelled)
+    {
+        _cancelTimer(call);
+        _fail(call, Error(Errors::RPC_ERROR_CONNECTION_CLOSED));
+    }
+
+    return cancelled.size();
+}
+
+
+std::size_t PendingCalls::size() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _calls.size();
+}
+
+
+bool PendingCalls::isResponse(const ofJson& json)
+{
+    return json.is_object()
+        && JSONRPCUtils::hasKey(json, "id")
+        && !JSONRPCUtils::hasKey(json, "method")
+        && (JSONRPCUtils::hasKey(json, "result") || JSONRPCUtils::hasKey(json, "error"));
+}
+
+
+void PendingCalls::_cancelTimer(const Call& call)
+{
+    if (_wheel != nullptr && call.timer != 0)
+    {
+        _wheel->cancelAndWait(call.timer);
+    }
+}
+
+
+void PendingCalls::_fail(Call& call, const Error& error)
+{
+    try
+    {
+        if (error.code() == Errors::RPC_ERROR_TIMEOUT)
+        {
+            throw CallTimeoutException(error.message());
+        }
+        else if (error.code() == Errors::RPC_ERROR_CONNECTION_CLOSED)
+        {
+            throw ConnectionClosedException(error.message());
+        }
+        else if (error.code() == Errors::RPC_ERROR_UNAVAILABLE)
+        {
+            throw UnavailableException(error.message());
+        }
+        else
+        {
+            throw JSONRPCException(error.message(), error.code());
+        }
+    }
+    catch (...)
+    {
+        call.promise.set_exception(std::current_exception());
+    }
+
+    if (call.onComplete)
+    {
+        call.onComplete();
+    }
+}
+
+
+} } // namespace ofx::JSONRPC
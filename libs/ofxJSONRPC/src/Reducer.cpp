@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/Reducer.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+namespace {
+
+
+/// \brief Add a number to a numeric accumulator.
+/// \param total The accumulator, or null.
+/// \param value The number to add.
+void add(ofJson& total, const ofJson& value)
+{
+    if ((total.is_null() || total.is_number_integer()) && value.is_number_integer())
+    {
+        total = (total.is_null() ? int64_t(0) : total.get<int64_t>()) + value.get<int64_t>();
+    }
+    else
+    {
+        total = (total.is_null() ? 0.0 : total.get<double>()) + value.get<double>();
+    }
+}
+
+
+} // namespace
+
+
+Reducer::Reducer(const ofJson& initial, Function function):
+    _initial(initial),
+    _function(function)
+{
+}
+
+
+Reducer::~Reducer()
+{
+}
+
+
+const ofJson& Reducer::initial() const
+{
+    return _initial;
+}
+
+
+bool Reducer::reduce(ofJson& accumulator,
+                     const std::string& backend,
+                     ofJson& result) const
+{
+    return _function ? _function(accumulator, backend, result) : false;
+}
+
+
+Reducer Reducer::concat()
+{
+    return Reducer(ofJson::array(), [](ofJson& accumulator, const std::string&, ofJson& result) {
+        if (result.is_array())
+        {
+            for (auto& element: result)
+            {
+                accumulator.push_back(std::move(element));
+            }
+        }
+        else
+        {
+            accumulator.push_back(std::move(result));
+        }
+
+        return false;
+    });
+}
+
+
+Reducer Reducer::sum()
+{
+    return Reducer(nullptr, [](ofJson& accumulator, const std::string&, ofJson& result) {
+        if (result.is_number() && (accumulator.is_null() || accumulator.is_number()))
+        {
+            add(accumulator, result);
+        }
+        else if (result.is_object() && (accumulator.is_null() || accumulator.is_object()))
+        {
+            if (accumulator.is_null())
+            {
+                accumulator = ofJson::object();
+            }
+
+            for (auto iter = result.begin(); iter != result.end(); ++iter)
+            {
+                if (iter.value().is_number())
+                {
+                    ofJson& total = accumulator[iter.key()];
+
+                    if (total.is_null() || total.is_number())
+                    {
+                        add(total, iter.value());
+                    }
+                }
+            }
+        }
+
+        return false;
+    });
+}
+
+
+Reducer Reducer::firstN(std::size_t count)
+{
+    return Reducer(ofJson::array(), [count](ofJson& accumulator, const std::string&, ofJson& result) {
+        if (accumulator.size() >= count)
+        {
+            return true;
+        }
+
+        accumulator.push_back(std::move(result));
+        return accumulator.size() >= count;
+    });
+}
+
+
+Reducer Reducer::byBackend()
+{
+    return Reducer(ofJson::object(), [](ofJson& accumulator, const std::string& backend, ofJson& result) {
+        accumulator[backend] = std::move(result);
+        return false;
+    });
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -116,6 +116,30 @@ ofJson Request::toJSON(const Request& request)
 }
 
 
+ofJson Request::toJSON(const ofJson& id,
+                       const std::string& method,
+                       const ofJson& parameters)
+{
+    ofJson result;
+
+    result[PROTOCOL_VERSION_TAG] = PROTOCOL_VERSION;
+
+    if (!id.is_null())
+    {
+        result[ID_TAG] = id;
+    }
+
+    result[METHOD_TAG] = method;
+
+    if (!parameters.is_null())
+    {
+        result[PARAMS_TAG] = parameters;
+    }
+
+    return result;
+}
+
+
 Request Request::fromJSON(HTTP::ServerEventArgs& evt,
                           const ofJson& json)
 {
@@ -6,6 +6,7 @@
 
 
 #include "ofx/JSONRPC/Response.h"
+#include <sstream>
 #include "ofx/JSONRPC/JSONRPCUtils.h"
 
 
@@ -61,6 +62,19 @@ const ofJson& Response::getResult() const
     return result();
 }
 
+
+void Response::setResultProducer(ResultWriter::Producer producer)
+{
+    _resultProducer = producer;
+}
+
+
+const ResultWriter::Producer& Response::resultProducer() const
+{
+    return _resultProducer;
+}
+
+
 const Error& Response::error() const
 {
     return _error;
@@ -81,6 +95,14 @@ bool Response::isErrorResponse() const
 
 std::string Response::toString(bool styled) const
 {
+    if (_resultProducer && !styled && !isErrorResponse())
+    {
+        // Write the produced result without building a document.
+        std::ostringstream stream;
+        ResultWriter::writeResponse(stream, id(), _resultProducer);
+        return stream.str();
+    }
+
     return JSONRPCUtils::toString(toJSON(*this), styled);
 }
 
@@ -97,6 +119,10 @@ ofJson Response::toJSON(const Response& response)
     {
         result["error"] = Error::toJSON(response.error());
     }
+    else if (response.resultProducer())
+    {
+        result["result"] = ResultWriter::collect(response.resultProducer());
+    }
     else
     {
         result["result"] = response.result();
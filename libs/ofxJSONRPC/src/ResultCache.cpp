@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/ResultCache.h"
+#include <algorithm>
+#include <cstdio>
+#include "ofx/JSONRPC/StaticMethodTable.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+ResultCache::ResultCache(TimerWheel& timers, std::size_t capacity):
+    _timers(timers),
+    _capacity(capacity)
+{
+}
+
+
+ResultCache::~ResultCache()
+{
+}
+
+
+void ResultCache::setCapacity(std::size_t capacity)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _capacity = capacity;
+
+    if (_entries.size() > _capacity)
+    {
+        _entries.clear();
+    }
+}
+
+
+void ResultCache::validate(uint64_t generation)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_generation != generation)
+    {
+        _generation = generation;
+        _entries.clear();
+    }
+}
+
+
+bool ResultCache::find(const std::string& method,
+                       const ofJson& params,
+                       Entry& entry) const
+{
+    std::string key = _toKey(method, params);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    auto iter = _entries.find(key);
+
+    if (iter == _entries.end() || iter->second.expires <= TimerWheel::Clock::now())
+    {
+        return false;
+    }
+
+    entry = iter->second;
+    return true;
+}
+
+
+ResultCache::Entry ResultCache::insert(const std::string& method,
+                                       const ofJson& params,
+                                       const std::string& result,
+                                       std::chrono::seconds maxAge)
+{
+    Entry entry;
+    entry.result = std::make_shared<const std::string>(result);
+    entry.etag = toETag(result);
+    entry.expires = TimerWheel::Clock::now() + maxAge;
+
+    if (maxAge.count() <= 0)
+    {
+        return entry;
+    }
+
+    std::string key = _toKey(method, params);
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        if (_entries.size() >= _capacity && _entries.find(key) == _entries.end())
+        {
+            return entry;
+        }
+
+        _entries[key] = entry;
+    }
+
+    TimerWheel::Clock::time_point expires = entry.expires;
+
+    _timers.schedule(maxAge, [this, key, expires]() {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        auto iter = _entries.find(key);
+
+        // The entry may have been replaced by a fresher result.
+        if (iter != _entries.end() && iter->second.expires <= expires)
+        {
+            _entries.erase(iter);
+        }
+    });
+
+    return entry;
+}
+
+
+void ResultCache::clear()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+
+std::size_t ResultCache::size() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+
+std::string ResultCache::toETag(const std::string& result)
+{
+    char etag[24];
+    std::snprintf(etag, sizeof(etag), "\"%016llx\"",
+                  static_cast<unsigned long long>(AbstractStaticMethodTable::hash(result)));
+    return etag;
+}
+
+
+bool ResultCache::matchesETag(const std::string& ifNoneMatch, const std::string& etag)
+{
+    std::size_t begin = 0;
+
+    while (begin <= ifNoneMatch.size())
+    {
+        std::size_t end = std::min(ifNoneMatch.find(',', begin), ifNoneMatch.size());
+        std::size_t first = ifNoneMatch.find_first_not_of(" \t", begin);
+        std::size_t last = ifNoneMatch.find_last_not_of(" \t", end - 1);
+
+        if (first < end && last != std::string::npos && last >= first)
+        {
+            std::string tag = ifNoneMatch.substr(first, last - first + 1);
+
+            if (tag.compare(0, 2, "W/") == 0)
+            {
+                tag.erase(0, 2);
+            }
+
+            if (tag == "*" || tag == etag)
+            {
+                return true;
+            }
+        }
+
+        begin = end + 1;
+    }
+
+    return false;
+}
+
+
+std::string ResultCache::_toKey(const std::string& method, const ofJson& params)
+{
+    // The length prefix keeps the boundary between method and params.
+    return std::to_string(method.size()) + ':' + method + params.dump();
+}
+
+
+} } // namespace ofx::JSONRPC
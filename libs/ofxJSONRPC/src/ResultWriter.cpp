@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/ResultWriter.h"
+#include <sstream>
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+ResultWriter::ResultWriter(std::ostream& stream): _stream(stream)
+{
+}
+
+
+ResultWriter::~ResultWriter()
+{
+}
+
+
+void ResultWriter::write(const ofJson& element)
+{
+    _separate();
+    _stream << element.dump();
+}
+
+
+void ResultWriter::writeSerialized(const std::string& element)
+{
+    _separate();
+    _stream << element;
+}
+
+
+void ResultWriter::flush()
+{
+    _stream.flush();
+}
+
+
+std::size_t ResultWriter::size() const
+{
+    return _size;
+}
+
+
+void ResultWriter::writeResponse(std::ostream& stream,
+                                 const ofJson& id,
+                                 const Producer& producer)
+{
+    stream << "{\"jsonrpc\":\"2.0\",\"id\":" << id.dump() << ",\"result\":[";
+
+    ResultWriter writer(stream);
+
+    if (producer)
+    {
+        producer(writer);
+    }
+
+    stream << "]}";
+    stream.flush();
+}
+
+
+ofJson ResultWriter::collect(const Producer& producer)
+{
+    std::ostringstream stream;
+    stream << '[';
+
+    ResultWriter writer(stream);
+
+    if (producer)
+    {
+        producer(writer);
+    }
+
+    stream << ']';
+
+    return ofJson::parse(stream.str());
+}
+
+
+void ResultWriter::_separate()
+{
+    if (_size++ > 0)
+    {
+        _stream << ',';
+    }
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/StreamingRequestParser.h"
+#include <streambuf>
+#include "Poco/Exception.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+namespace {
+
+
+/// \brief Reads bytes already read, then through to another buffer,
+///        counting the bytes consumed.
+///
+/// Nothing is read ahead, so the count is exactly what the parser consumed.
+class CountingBuffer: public std::streambuf
+{
+public:
+    CountingBuffer(const std::string& head, std::streambuf* source, uint64_t& count):
+        _head(head),
+        _source(source),
+        _count(count)
+    {
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (_position < _head.size())
+        {
+            return traits_type::to_int_type(_head[_position]);
+        }
+
+        return _source->sgetc();
+    }
+
+    int_type uflow() override
+    {
+        int_type c = _position < _head.size() ? traits_type::to_int_type(_head[_position++])
+                                              : _source->sbumpc();
+
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            ++_count;
+        }
+
+        return c;
+    }
+
+private:
+    const std::string& _head;
+    std::size_t _position = 0;
+    std::streambuf* _source = nullptr;
+    uint64_t& _count;
+
+};
+
+
+} // namespace
+
+
+StreamingRequestParser::StreamingRequestParser(const MessageLimits& limits,
+                                               Resolver resolver,
+                                               uint64_t maxBodySize):
+    _limits(limits),
+    _resolver(resolver),
+    _maxBodySize(maxBodySize)
+{
+}
+
+
+StreamingRequestParser::~StreamingRequestParser()
+{
+}
+
+
+ofJson StreamingRequestParser::parse(std::istream& stream)
+{
+    return parse(std::string(), stream);
+}
+
+
+ofJson StreamingRequestParser::parse(const std::string& head, std::istream& stream)
+{
+    CountingBuffer buffer(head, stream.rdbuf(), _bytesRead);
+    std::istream counted(&buffer);
+
+    ofJson json = ofJson::parse(counted, [this](int depth, ofJson::parse_event_t event, ofJson& parsed) {
+        return _onEvent(depth, event, parsed);
+    });
+
+    // Trailing whitespace is read after the last event.
+    _checkSize(false);
+
+    if (_stream && !_streamed && json.is_object())
+    {
+        // The parameters preceded the method, so they were kept.
+        auto params = json.find("params");
+
+        if (params != json.end())
+        {
+            ParamsStream::replay(*_stream, *params);
+
+            for (auto& param: *params)
+            {
+                if (param.is_array())
+                {
+                    param = ofJson::array();
+                }
+            }
+        }
+    }
+
+    return json;
+}
+
+
+std::shared_ptr<ParamsStream> StreamingRequestParser::paramsStream() const
+{
+    return _stream;
+}
+
+
+uint64_t StreamingRequestParser::bytesRead() const
+{
+    return _bytesRead;
+}
+
+
+bool StreamingRequestParser::_onEvent(int depth,
+                                      ofJson::parse_event_t event,
+                                      ofJson& parsed)
+{
+    bool isStreamed = _isStreamedElement(depth);
+
+    _checkSize(isStreamed);
+
+    _limits.check(depth, event, parsed, isStreamed ? _elementElements : _elements);
+
+    std::size_t level = std::size_t(depth);
+
+    if (_containers.size() < level + 2)
+    {
+        _containers.resize(level + 2, 0);
+        _keys.resize(level + 2);
+        _counts.resize(level + 2, 0);
+    }
+
+    switch (event)
+    {
+        case ofJson::parse_event_t::object_start:
+        case ofJson::parse_event_t::array_start:
+            _containers[level] = (event == ofJson::parse_event_t::object_start) ? '{' : '[';
+            _counts[level + 1] = 0;
+
+            // Parameters that follow a resolved method are streamed.
+            if (level == 1 && _stream && _containers[0] == '{' && _keys[1] == "params")
+            {
+                _streamed = true;
+            }
+
+            return true;
+        case ofJson::parse_event_t::key:
+            _keys[level] = parsed.get<std::string>();
+            return true;
+        case ofJson::parse_event_t::object_end:
+        case ofJson::parse_event_t::array_end:
+        case ofJson::parse_event_t::value:
+            break;
+    }
+
+    // A value at this level is complete.
+    if (isStreamed && level == 3)
+    {
+        const std::string& parameter = _containers[1] == '{' ? _keys[2] : std::to_string(_counts[2]);
+        _stream->element(parameter, parsed);
+        _elementElements = 0;
+        ++_counts[level];
+
+        // Discard the element.
+        return false;
+    }
+
+    if (level == 1 && _containers[0] == '{')
+    {
+        _onMember(_keys[1], parsed);
+    }
+
+    ++_counts[level];
+
+    return true;
+}
+
+
+void StreamingRequestParser::_onMember(const std::string& key,
+                                       const ofJson& value)
+{
+    if (key == "jsonrpc")
+    {
+        if (!value.is_string() || value.get_ref<const std::string&>() != "2.0")
+        {
+            throw Poco::InvalidArgumentException("The jsonrpc member must be \"2.0\".");
+        }
+    }
+    else if (key == "method")
+    {
+        if (!value.is_string())
+        {
+            throw Poco::InvalidArgumentException("The method member must be a string.");
+        }
+
+        if (_resolver)
+        {
+            _stream = _resolver(value.get<std::string>());
+        }
+    }
+}
+
+
+bool StreamingRequestParser::_isStreamedElement(int depth) const
+{
+    return _streamed
+        && depth >= 3
+        && _containers[0] == '{'
+        && _keys[1] == "params"
+        && _containers[2] == '[';
+}
+
+
+
+void StreamingRequestParser::_checkSize(bool isStreamed)
+{
+    if (_maxBodySize > 0 && _bytesRead > _maxBodySize)
+    {
+        throw LimitExceededException("Message is more than " + std::to_string(_maxBodySize) + " bytes.");
+    }
+
+    if (!isStreamed)
+    {
+        _bytesRetained += _bytesRead - _bytesChecked;
+
+        if (_limits.maxMessageSize > 0 && _bytesRetained > _limits.maxMessageSize)
+        {
+            throw LimitExceededException("Message retains more than " + std::to_string(_limits.maxMessageSize) + " bytes.");
+        }
+    }
+
+    _bytesChecked = _bytesRead;
+}
+
+
+} } // namespace ofx::JSONRPC
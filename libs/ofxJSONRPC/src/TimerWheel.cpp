@@ -0,0 +1,332 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/TimerWheel.h"
+#include <algorithm>
+#include "ofLog.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+TimerWheel::TimerWheel(Clock::duration resolution):
+    _resolution(std::max(resolution, Clock::duration(1))),
+    _start(Clock::now()),
+    _currentTick(0)
+{
+}
+
+
+TimerWheel::~TimerWheel()
+{
+    stop();
+}
+
+
+void TimerWheel::start()
+{
+    std::unique_lock<std::mutex> lock(_threadMutex);
+
+    if (_running)
+    {
+        return;
+    }
+
+    _running = true;
+
+    _thread = std::thread([this]() {
+        std::unique_lock<std::mutex> threadLock(_threadMutex);
+
+        while (_running)
+        {
+            _condition.wait_for(threadLock, _resolution);
+
+            if (_running)
+            {
+                threadLock.unlock();
+                advance();
+                threadLock.lock();
+            }
+        }
+    });
+}
+
+
+void TimerWheel::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(_threadMutex);
+
+        if (!_running)
+        {
+            return;
+        }
+
+        _running = false;
+    }
+
+    _condition.notify_all();
+
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+
+bool TimerWheel::isRunning() const
+{
+    std::unique_lock<std::mutex> lock(_threadMutex);
+    return _running;
+}
+
+
+TimerWheel::TimerId TimerWheel::schedule(Clock::duration delay, Callback callback)
+{
+    uint64_t ticks = 1;
+
+    if (delay > Clock::duration::zero())
+    {
+        ticks = std::max<uint64_t>(1, (delay.count() + _resolution.count() - 1) / _resolution.count());
+    }
+
+    uint64_t now = _tickAt(Clock::now());
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    uint64_t expiry = std::max(now, _currentTick.load()) + ticks;
+
+    TimerId id = ++_lastId;
+
+    Slot& slot = _slotFor(expiry);
+    Slot::iterator iterator = slot.insert(slot.end(), Timer { id, expiry, std::move(callback) });
+    _timers[id] = Location { &slot, iterator };
+
+    return id;
+}
+
+
+bool TimerWheel::cancel(TimerId id)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _cancel(id);
+}
+
+
+bool TimerWheel::cancelAndWait(TimerId id)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_cancel(id))
+    {
+        return true;
+    }
+
+    // A callback cancelling its own timer would wait for itself.
+    if (_firing == id && _firingThread != std::this_thread::get_id())
+    {
+        _fired.wait(lock, [&]() { return _firing != id; });
+    }
+
+    return false;
+}
+
+
+std::size_t TimerWheel::advance(Clock::time_point now)
+{
+    uint64_t target = _tickAt(now);
+
+    // The common case: no tick has elapsed since the last advance.
+    if (target <= _currentTick.load())
+    {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> advanceLock(_advanceMutex, std::try_to_lock);
+
+    if (!advanceLock.owns_lock())
+    {
+        return 0;
+    }
+
+    Slot expired;
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        while (_currentTick.load() < target)
+        {
+            if (_timers.empty())
+            {
+                _currentTick.store(target);
+                break;
+            }
+
+            uint64_t tick = _currentTick.load() + 1;
+            _currentTick.store(tick);
+
+            // Cascade coarser levels whose slot boundary has been reached.
+            for (std::size_t level = 1; level < NUM_LEVELS; ++level)
+            {
+                if ((tick & ((uint64_t(1) << (LEVEL_BITS * level)) - 1)) != 0)
+                {
+                    break;
+                }
+
+                Slot& slot = _levels[level][(tick >> (LEVEL_BITS * level)) & (LEVEL_SIZE - 1)];
+
+                while (!slot.empty())
+                {
+                    _place(slot, slot.begin());
+                }
+            }
+
+            Slot& due = _levels[0][tick & (LEVEL_SIZE - 1)];
+
+            while (!due.empty())
+            {
+                Slot::iterator iterator = due.begin();
+
+                if (iterator->expiry > tick)
+                {
+                    // A timer beyond the wheel's range that was clamped.
+                    _place(due, iterator);
+                }
+                else
+                {
+                    _timers.erase(iterator->id);
+                    _due.insert(iterator->id);
+                    expired.splice(expired.end(), due, iterator);
+                }
+            }
+        }
+    }
+
+    std::size_t count = 0;
+
+    for (auto& timer: expired)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+
+            // The timer was cancelled after it came due.
+            if (_due.erase(timer.id) == 0)
+            {
+                continue;
+            }
+
+            _firing = timer.id;
+            _firingThread = std::this_thread::get_id();
+        }
+
+        ++count;
+
+        try
+        {
+            timer.callback();
+        }
+        catch (const std::exception& exc)
+        {
+            ofLogError("TimerWheel::advance") << "Timer callback threw: " << exc.what();
+        }
+        catch (...)
+        {
+            ofLogError("TimerWheel::advance") << "Timer callback threw an unknown exception.";
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _firing = 0;
+        }
+
+        _fired.notify_all();
+    }
+
+    return count;
+}
+
+
+std::size_t TimerWheel::size() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _timers.size();
+}
+
+
+TimerWheel::Clock::duration TimerWheel::resolution() const
+{
+    return _resolution;
+}
+
+
+TimerWheel::Slot& TimerWheel::_slotFor(uint64_t expiry)
+{
+    static const uint64_t MAXIMUM_DELTA = (uint64_t(1) << (LEVEL_BITS * NUM_LEVELS)) - 1;
+
+    uint64_t current = _currentTick.load();
+
+    if (expiry <= current)
+    {
+        // Already due; place it in the slot that is about to be processed.
+        return _levels[0][current & (LEVEL_SIZE - 1)];
+    }
+
+    uint64_t delta = expiry - current;
+
+    if (delta > MAXIMUM_DELTA)
+    {
+        delta = MAXIMUM_DELTA;
+        expiry = current + delta;
+    }
+
+    std::size_t level = 0;
+
+    while (level + 1 < NUM_LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))
+    {
+        ++level;
+    }
+
+    return _levels[level][(expiry >> (LEVEL_BITS * level)) & (LEVEL_SIZE - 1)];
+}
+
+
+void TimerWheel::_place(Slot& from, Slot::iterator iterator)
+{
+    Slot& to = _slotFor(iterator->expiry);
+    to.splice(to.end(), from, iterator);
+    _timers[iterator->id].slot = &to;
+}
+
+
+bool TimerWheel::_cancel(TimerId id)
+{
+    auto iter = _timers.find(id);
+
+    if (iter != _timers.end())
+    {
+        iter->second.slot->erase(iter->second.iterator);
+        _timers.erase(iter);
+        return true;
+    }
+
+    return _due.erase(id) != 0;
+}
+
+
+uint64_t TimerWheel::_tickAt(Clock::time_point time) const
+{
+    if (time <= _start)
+    {
+        return 0;
+    }
+
+    return uint64_t((time - _start) / _resolution);
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/TrafficLog.h"
+#include "Poco/Exception.h"
+#include "ofLog.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+const std::string TrafficRecorder::SIGNATURE = std::string("JRPCLOG") + char(1);
+
+
+TrafficRecorder::TrafficRecorder(const std::string& path):
+    _path(path),
+    _stream(path, std::ios::binary | std::ios::trunc),
+    _start(Clock::now()),
+    _previous(0)
+{
+    if (!_stream)
+    {
+        throw Poco::IOException("Unable to open traffic log", path);
+    }
+
+    auto wallClock = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+
+    _stream.write(SIGNATURE.data(), SIGNATURE.size());
+    _writeVarint(uint64_t(wallClock.count()));
+}
+
+
+TrafficRecorder::~TrafficRecorder()
+{
+    flush();
+}
+
+
+void TrafficRecorder::record(uint64_t connectionId,
+                             TrafficRecord::Source source,
+                             const std::string& message)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (_failed)
+    {
+        return;
+    }
+
+    // Time is taken under the lock so that records are in time order.
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - _start);
+
+    _writeVarint(uint64_t((time - _previous).count()));
+    _writeVarint(connectionId);
+    _stream.put(char(source));
+    _writeVarint(message.size());
+    _stream.write(message.data(), message.size());
+
+    if (!_stream)
+    {
+        _fail();
+        return;
+    }
+
+    _previous = time;
+    ++_records;
+}
+
+
+void TrafficRecorder::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    if (!_failed && !_stream.flush())
+    {
+        _fail();
+    }
+}
+
+
+uint64_t TrafficRecorder::records() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _records;
+}
+
+
+const std::string& TrafficRecorder::path() const
+{
+    return _path;
+}
+
+
+bool TrafficRecorder::isRecording() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return !_failed;
+}
+
+
+void TrafficRecorder::_fail()
+{
+    // A partly written record can't be followed by another, so stop here.
+    _failed = true;
+    ofLogError("TrafficRecorder::_fail") << "Unable to write to traffic log \"" << _path << "\", recording stopped after " << _records << " records.";
+}
+
+
+void TrafficRecorder::_writeVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        _stream.put(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+
+    _stream.put(char(value));
+}
+
+
+TrafficReader::TrafficReader(const std::string& path):
+    _stream(path, std::ios::binary),
+    _previous(0)
+{
+    if (!_stream)
+    {
+        throw Poco::IOException("Unable to open traffic log", path);
+    }
+
+    std::string signature(TrafficRecorder::SIGNATURE.size(), '\0');
+    _stream.read(&signature[0], signature.size());
+
+    if (!_stream || signature != TrafficRecorder::SIGNATURE || !_readVarint(_startTime))
+    {
+        throw Poco::DataFormatException("Not a traffic log", path);
+    }
+
+    std::streampos position = _stream.tellg();
+    _stream.seekg(0, std::ios::end);
+    _size = _stream.tellg();
+    _stream.seekg(position);
+}
+
+
+TrafficReader::~TrafficReader()
+{
+}
+
+
+bool TrafficReader::next(TrafficRecord& record)
+{
+    uint64_t delta = 0;
+    uint64_t connectionId = 0;
+    uint64_t size = 0;
+
+    if (!_readVarint(delta))
+    {
+        return false;
+    }
+
+    if (!_readVarint(connectionId))
+    {
+        ofLogWarning("TrafficReader::next") << "The log ends with an incomplete record.";
+        return false;
+    }
+
+    int source = _stream.get();
+
+    // A corrupt size must not allocate more than the rest of the file.
+    if (source == std::char_traits<char>::eof()
+     || !_readVarint(size)
+     || size > uint64_t(_size - _stream.tellg()))
+    {
+        ofLogWarning("TrafficReader::next") << "The log ends with an incomplete record.";
+        return false;
+    }
+
+    record.message.resize(size);
+    _stream.read(&record.message[0], size);
+
+    if (!_stream)
+    {
+        ofLogWarning("TrafficReader::next") << "The log ends with an incomplete record.";
+        return false;
+    }
+
+    _previous += std::chrono::microseconds(delta);
+
+    record.time = _previous;
+    record.connectionId = connectionId;
+    record.source = TrafficRecord::Source(source);
+
+    return true;
+}
+
+
+uint64_t TrafficReader::startTime() const
+{
+    return _startTime;
+}
+
+
+bool TrafficReader::_readVarint(uint64_t& value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = _stream.get();
+
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+
+        value |= uint64_t(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+} } // namespace ofx::JSONRPC
@@ -0,0 +1,25 @@
+//
+// Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/JSONRPC/UploadStream.h"
+
+
+namespace ofx {
+namespace JSONRPC {
+
+
+UploadStream::~UploadStream()
+{
+}
+
+
+void UploadStream::element(const std::string&, const ofJson&)
+{
+}
+
+
+} } // namespace ofx::JSONRPC
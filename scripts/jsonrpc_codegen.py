@@ -0,0 +1,583 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2014 Christopher Baker <https://christopherbaker.net>
+#
+# SPDX-License-Identifier:	MIT
+#
+
+"""Generate typed ofxJSONRPC server stubs and clients from an OpenRPC file.
+
+Usage:
+
+    jsonrpc_codegen.py api.openrpc.json --name Demo --out src/
+
+For an API named Demo this writes:
+
+    DemoServer.h  A DemoHandler interface with one typed virtual function per
+                  method, a DemoDispatcher that decodes parameters and encodes
+                  results, and a DemoStaticMethods table to attach with
+                  MethodRegistry_::setStaticMethods().
+    DemoClient.h  A DemoClient proxy with one typed function per method. Calls
+                  are sent through a transport, e.g. JSONRPCServer_::call().
+    DemoClient.js A DemoClient wrapper for jquery.jsonrpcclient.js, for use in
+                  a server's DocumentRoot.
+
+Parameter schemas map to C++ types as follows. Any other schema maps to
+ofJson.
+
+    integer            int64_t
+    number             double
+    string             std::string
+    boolean            bool
+    array of the above std::vector<T>
+
+Method and parameter names become camel case identifiers. A name that is a
+C++ or JavaScript reserved word gets a trailing underscore, e.g. a method
+named delete becomes delete_(), as does a parameter named args, params,
+result, response, success or error.
+
+The input is an OpenRPC document, e.g. the result of calling rpc.discover on
+a running server. Only the Python standard library is required.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+
+SCALAR_TYPES = {
+    "integer": "int64_t",
+    "number": "double",
+    "string": "std::string",
+    "boolean": "bool",
+}
+
+
+def cpp_type(schema):
+    """Return the C++ type for a JSON Schema."""
+    if not isinstance(schema, dict):
+        return "ofJson"
+
+    kind = schema.get("type")
+
+    if kind in SCALAR_TYPES:
+        return SCALAR_TYPES[kind]
+
+    if kind == "array":
+        item = cpp_type(schema.get("items"))
+
+        if item != "ofJson":
+            return "std::vector<" + item + ">"
+
+    return "ofJson"
+
+
+def argument_type(schema):
+    """Return the C++ type used to pass a parameter."""
+    kind = cpp_type(schema)
+
+    if kind in ("int64_t", "double", "bool"):
+        return kind
+
+    return "const " + kind + "&"
+
+
+# C++ and JavaScript keywords and reserved words, which can't be identifiers.
+RESERVED_WORDS = set("""
+    alignas alignof and and_eq asm auto bitand bitor bool break case catch
+    char char16_t char32_t class compl const constexpr const_cast continue
+    decltype default delete do double dynamic_cast else enum explicit export
+    extern false float for friend goto if inline int long mutable namespace
+    new noexcept not not_eq nullptr operator or or_eq private protected
+    public register reinterpret_cast return short signed sizeof static
+    static_assert static_cast struct switch template this thread_local throw
+    true try typedef typeid typename union unsigned using virtual void
+    volatile wchar_t while xor xor_eq
+    arguments await debugger eval function implements in instanceof interface
+    let null package super typeof var with yield
+""".split())
+
+# Names that parameters are kept apart from. Generated function bodies use
+# names starting with an underscore, which identifier() never produces.
+RESERVED_PARAMETERS = set([
+    "args",
+    "params",
+    "result",
+    "response",
+    "success",
+    "error",
+])
+
+
+def identifier(name, capitalize=False):
+    """Convert a method or parameter name to a camel case identifier.
+
+    A reserved word has an underscore appended.
+    """
+    words = [word for word in re.split(r"[^0-9A-Za-z]+", name) if word]
+
+    if not words:
+        raise ValueError("Cannot make an identifier from \"" + name + "\".")
+
+    result = words[0][0].lower() + words[0][1:]
+
+    for word in words[1:]:
+        result += word[0].upper() + word[1:]
+
+    if capitalize:
+        result = result[0].upper() + result[1:]
+
+    if result[0].isdigit():
+        result = "_" + result
+
+    if result in RESERVED_WORDS:
+        result += "_"
+
+    return result
+
+
+def parameter(name):
+    """Convert a parameter name to an identifier that can't clash with the
+    names used in generated function bodies."""
+    result = identifier(name)
+
+    if result in RESERVED_PARAMETERS:
+        result += "_"
+
+    return result
+
+
+def cpp_string(text):
+    """Return a C++ string literal."""
+    return json.dumps(text)
+
+
+def doc_comment(method, indent):
+    """Return a Doxygen comment for a method."""
+    text = method.get("summary") or method.get("description") or ""
+    lines = ["/// \\brief " + (text if text else "Call " + method["name"] + ".")]
+
+    for param in method["params"]:
+        description = param.get("description", param.get("summary", ""))
+        lines.append("/// \\param " + parameter(param["name"]) + (" " + description if description else ""))
+
+    if "result" in method:
+        lines.append("/// \\returns the " + method["result"].get("name", "result") + ".")
+
+    return "".join(indent + line + "\n" for line in lines)
+
+
+class Method(object):
+    """A method parsed from an OpenRPC document."""
+
+    def __init__(self, description):
+        if "name" not in description:
+            raise ValueError("Every method must have a name.")
+
+        self.description = description
+        self.name = description["name"]
+        self.function = identifier(self.name)
+        self.type = identifier(self.name, True)
+        self.params = description.get("params", [])
+        self.result = description.get("result")
+        self.result_type = cpp_type(self.result.get("schema")) if self.result else "void"
+
+        variables = set()
+
+        for param in self.params:
+            if "$ref" in param:
+                raise ValueError("Parameter references are not supported in " + self.name + ".")
+
+            variable = parameter(param["name"])
+
+            if variable in variables:
+                raise ValueError("Parameter names of " + self.name + " map to the same identifier: " + variable)
+
+            variables.add(variable)
+
+    def arguments(self):
+        return ", ".join(argument_type(param.get("schema")) + " " + parameter(param["name"])
+                         for param in self.params)
+
+
+DECODERS = """
+namespace {namespace}Detail {{
+
+
+inline void decode(const ofJson& value, const std::string& path, int64_t& out)
+{{
+    if (!value.is_number_integer() && !value.is_number_unsigned())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be an integer.");
+    }}
+
+    out = value.get<int64_t>();
+}}
+
+
+inline void decode(const ofJson& value, const std::string& path, double& out)
+{{
+    if (!value.is_number())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be a number.");
+    }}
+
+    out = value.get<double>();
+}}
+
+
+inline void decode(const ofJson& value, const std::string& path, std::string& out)
+{{
+    if (!value.is_string())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be a string.");
+    }}
+
+    out = value.get_ref<const std::string&>();
+}}
+
+
+inline void decode(const ofJson& value, const std::string& path, bool& out)
+{{
+    if (!value.is_boolean())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be a boolean.");
+    }}
+
+    out = value.get<bool>();
+}}
+
+
+inline void decode(const ofJson& value, const std::string&, ofJson& out)
+{{
+    out = value;
+}}
+
+
+/// \\brief The elements of a std::vector<bool> are proxies, not bool&.
+inline void decode(const ofJson& value, const std::string& path, std::vector<bool>& out)
+{{
+    if (!value.is_array())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be an array.");
+    }}
+
+    out.resize(value.size());
+
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {{
+        bool item = false;
+        decode(value[i], path + "/" + std::to_string(i), item);
+        out[i] = item;
+    }}
+}}
+
+
+template <typename Type>
+inline void decode(const ofJson& value, const std::string& path, std::vector<Type>& out)
+{{
+    if (!value.is_array())
+    {{
+        throw Poco::InvalidArgumentException(path + " must be an array.");
+    }}
+
+    out.resize(value.size());
+
+    for (std::size_t i = 0; i < value.size(); ++i)
+    {{
+        decode(value[i], path + "/" + std::to_string(i), out[i]);
+    }}
+}}
+
+
+/// \\brief Decode a parameter passed by name or by position.
+template <typename Type>
+inline void decodeParam(const ofJson& params,
+                        std::size_t index,
+                        const std::string& name,
+                        bool required,
+                        Type& out)
+{{
+    const ofJson* value = nullptr;
+
+    if (params.is_object())
+    {{
+        auto iter = params.find(name);
+        value = iter != params.end() ? &*iter : nullptr;
+    }}
+    else if (params.is_array())
+    {{
+        value = index < params.size() ? &params[index] : nullptr;
+    }}
+
+    if (value != nullptr)
+    {{
+        decode(*value, "/" + name, out);
+    }}
+    else if (required)
+    {{
+        throw Poco::InvalidArgumentException("Missing required parameter \\"" + name + "\\".");
+    }}
+}}
+
+
+}} // namespace {namespace}Detail
+"""
+
+
+def open_namespace(namespace):
+    return "".join("namespace " + part + " {\n" for part in namespace.split("::")) + "\n\n"
+
+
+def close_namespace(namespace):
+    return "} " * len(namespace.split("::")) + "// namespace " + namespace + "\n"
+
+
+def header_preamble(source, includes):
+    lines = [
+        "//",
+        "// Generated by scripts/jsonrpc_codegen.py from " + os.path.basename(source) + ".",
+        "// Do not edit.",
+        "//",
+        "",
+        "",
+        "#pragma once",
+        "",
+        "",
+    ]
+
+    lines += ["#include " + include for include in includes]
+    lines += ["", ""]
+
+    return "\n".join(lines)
+
+
+def generate_server(name, namespace, methods, source):
+    out = header_preamble(source, [
+        "<cstdint>",
+        "<memory>",
+        "<string>",
+        "<vector>",
+        "\"json.hpp\"",
+        "\"Poco/Exception.h\"",
+        "\"ofx/JSONRPC/MethodArgs.h\"",
+        "\"ofx/JSONRPC/StaticMethodTable.h\"",
+    ])
+
+    out += open_namespace(namespace)
+
+    out += DECODERS.format(namespace=name) + "\n\n"
+
+    # The handler interface.
+    out += "/// \\brief The methods of the " + name + " API.\n"
+    out += "///\n"
+    out += "/// Implement this interface and attach it to a registry with a\n"
+    out += "/// " + name + "Dispatcher.\n"
+    out += "class " + name + "Handler\n{\npublic:\n"
+    out += "    virtual ~" + name + "Handler()\n    {\n    }\n"
+
+    for method in methods:
+        out += "\n" + doc_comment(method.description, "    ")
+        out += "    virtual " + method.result_type + " " + method.function + "(" + method.arguments() + ") = 0;\n"
+
+    out += "\n};\n\n\n"
+
+    # The dispatcher.
+    out += "/// \\brief Decodes calls and invokes a " + name + "Handler.\n"
+    out += "class " + name + "Dispatcher\n{\npublic:\n"
+    out += "    /// \\brief Create a " + name + "Dispatcher.\n"
+    out += "    /// \\param handler The handler to invoke. It must outlive the dispatcher.\n"
+    out += "    " + name + "Dispatcher(" + name + "Handler& handler): _handler(handler)\n    {\n    }\n"
+
+    for method in methods:
+        out += "\n    /// \\brief Decode and invoke " + method.name + ".\n"
+        # A method without parameters or a result doesn't use its args.
+        uses_args = method.params or method.result_type != "void"
+        out += "    void " + method.function + "(ofx::JSONRPC::MethodArgs&" + (" _args" if uses_args else "") + ")\n    {\n"
+
+        for index, param in enumerate(method.params):
+            variable = parameter(param["name"])
+            out += "        " + cpp_type(param.get("schema")) + " " + variable + " = " + cpp_type(param.get("schema")) + "();\n"
+            out += "        " + name + "Detail::decodeParam(_args.params, " + str(index) + ", " + cpp_string(param["name"]) + ", " + ("true" if param.get("required", False) else "false") + ", " + variable + ");\n"
+
+        call = "_handler." + method.function + "(" + ", ".join(parameter(param["name"]) for param in method.params) + ")"
+
+        if method.params:
+            out += "\n"
+
+        if method.result_type == "void":
+            out += "        " + call + ";\n"
+        else:
+            out += "        _args.result = " + call + ";\n"
+
+        out += "    }\n"
+
+    out += "\nprivate:\n"
+    out += "    /// \\brief The handler to invoke.\n"
+    out += "    " + name + "Handler& _handler;\n\n};\n\n\n"
+
+    # The static method types.
+    out += "namespace " + name + "Methods {\n\n\n"
+
+    for method in methods:
+        out += "struct " + method.type + ": ofx::JSONRPC::StaticMethod<" + name + "Dispatcher, &" + name + "Dispatcher::" + method.function + ">\n{\n"
+        out += "    static constexpr const char* name()\n    {\n        return " + cpp_string(method.name) + ";\n    }\n\n"
+        out += "    static ofJson description()\n    {\n        return ofJson::parse(" + cpp_string(json.dumps(method.description, sort_keys=True)) + ");\n    }\n};\n\n\n"
+
+    out += "} // namespace " + name + "Methods\n\n\n"
+
+    out += "/// \\brief A static method table for a " + name + "Dispatcher.\n"
+    out += "///\n"
+    out += "/// ~~~{.cpp}\n"
+    out += "///     server.setStaticMethods(std::make_shared<" + name + "StaticMethods>(dispatcher));\n"
+    out += "/// ~~~\n"
+    out += "typedef ofx::JSONRPC::StaticMethodTable<" + name + "Dispatcher"
+
+    for method in methods:
+        out += ",\n                                        " + name + "Methods::" + method.type
+
+    out += "> " + name + "StaticMethods;\n\n\n"
+    out += close_namespace(namespace)
+
+    return out
+
+
+def generate_client(name, namespace, methods, source):
+    out = header_preamble(source, [
+        "<cstdint>",
+        "<functional>",
+        "<future>",
+        "<memory>",
+        "<string>",
+        "<vector>",
+        "\"json.hpp\"",
+        "\"Poco/Exception.h\"",
+    ])
+
+    out += open_namespace(namespace)
+    out += DECODERS.format(namespace=name + "Client") + "\n\n"
+
+    out += "/// \\brief A client proxy for the " + name + " API.\n"
+    out += "///\n"
+    out += "/// Calls are sent through a transport, e.g. a server calling a connected\n"
+    out += "/// client:\n"
+    out += "///\n"
+    out += "/// ~~~{.cpp}\n"
+    out += "///     " + name + "Client client([&](const std::string& method, const ofJson& params) {\n"
+    out += "///         return server.call(connection, method, params);\n"
+    out += "///     });\n"
+    out += "/// ~~~\n"
+    out += "class " + name + "Client\n{\npublic:\n"
+    out += "    /// \\brief A function that sends a call and returns its future result.\n"
+    out += "    typedef std::function<std::future<ofJson>(const std::string&, const ofJson&)> Transport;\n\n"
+    out += "    /// \\brief Create a " + name + "Client.\n"
+    out += "    /// \\param transport The transport used to send calls.\n"
+    out += "    " + name + "Client(Transport transport): _transport(transport)\n    {\n    }\n"
+
+    for method in methods:
+        out += "\n" + doc_comment(method.description, "    ")
+        out += "    std::future<" + method.result_type + "> " + method.function + "(" + method.arguments() + ")\n    {\n"
+
+        if method.params:
+            out += "        ofJson _params = ofJson::object();\n"
+
+            for param in method.params:
+                out += "        _params[" + cpp_string(param["name"]) + "] = " + parameter(param["name"]) + ";\n"
+        else:
+            out += "        ofJson _params = nullptr;\n"
+
+        out += "\n        std::shared_ptr<std::future<ofJson>> _response = std::make_shared<std::future<ofJson>>(_transport(" + cpp_string(method.name) + ", _params));\n\n"
+        out += "        return std::async(std::launch::deferred, [_response]() {\n"
+
+        if method.result_type == "void":
+            out += "            _response->get();\n"
+        else:
+            out += "            " + method.result_type + " _result = " + method.result_type + "();\n"
+            out += "            " + name + "ClientDetail::decode(_response->get(), \"/result\", _result);\n"
+            out += "            return _result;\n"
+
+        out += "        });\n    }\n"
+
+    out += "\nprivate:\n"
+    out += "    /// \\brief The transport used to send calls.\n"
+    out += "    Transport _transport;\n\n};\n\n\n"
+    out += close_namespace(namespace)
+
+    return out
+
+
+def generate_javascript(name, methods, source):
+    out = "//\n"
+    out += "// Generated by scripts/jsonrpc_codegen.py from " + os.path.basename(source) + ".\n"
+    out += "// Do not edit.\n"
+    out += "//\n\n"
+    out += "/// A client for the " + name + " API.\n"
+    out += "///\n"
+    out += "/// client is a $.JsonRpcClient from jquery.jsonrpcclient.js.\n"
+    out += "function " + name + "Client(client) {\n"
+    out += "    this.client = client;\n"
+    out += "}\n"
+
+    for method in methods:
+        arguments = [parameter(param["name"]) for param in method.params]
+        params = "{ " + ", ".join(json.dumps(param["name"]) + ": " + parameter(param["name"]) for param in method.params) + " }" if method.params else "null"
+
+        out += "\n"
+        text = method.description.get("summary") or method.description.get("description")
+
+        if text:
+            out += "/// " + text + "\n"
+
+        out += name + "Client.prototype." + method.function + " = function(" + ", ".join(arguments + ["_success", "_error"]) + ") {\n"
+        out += "    this.client.call(" + json.dumps(method.name) + ", " + params + ", _success, _error);\n"
+        out += "};\n"
+
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate ofxJSONRPC server stubs and clients from an OpenRPC document.")
+    parser.add_argument("input", help="the OpenRPC document")
+    parser.add_argument("--name", required=True, help="the API name, used as a prefix for generated types")
+    parser.add_argument("--namespace", default="", help="the C++ namespace for generated types, e.g. my::api")
+    parser.add_argument("--out", default=".", help="the output directory")
+    args = parser.parse_args()
+
+    with open(args.input) as file:
+        document = json.load(file)
+
+    if "result" in document and "methods" not in document:
+        # A saved rpc.discover response.
+        document = document["result"]
+
+    methods = [Method(method) for method in document.get("methods", [])]
+
+    names = set()
+
+    for method in methods:
+        if method.function in names:
+            sys.exit("Method names map to the same identifier: " + method.function)
+
+        names.add(method.function)
+
+    name = identifier(args.name, True)
+    namespace = args.namespace.replace(".", "::") if args.namespace else name[0].lower() + name[1:]
+
+    outputs = {
+        name + "Server.h": generate_server(name, namespace, methods, args.input),
+        name + "Client.h": generate_client(name, namespace, methods, args.input),
+        name + "Client.js": generate_javascript(name, methods, args.input),
+    }
+
+    if not os.path.isdir(args.out):
+        os.makedirs(args.out)
+
+    for filename, contents in outputs.items():
+        with open(os.path.join(args.out, filename), "w") as file:
+            file.write(contents)
+
+
+if __name__ == "__main__":
+    main()
@@ -11,12 +11,40 @@
 #include "json.hpp"
 #include "ofxHTTP.h"
 #include "ofx/JSONRPC/BaseMessage.h"
+#include "ofx/JSONRPC/CachePolicy.h"
+#include "ofx/JSONRPC/CircuitBreaker.h"
+#include "ofx/JSONRPC/Connection.h"
 #include "ofx/JSONRPC/Error.h"
 #include "ofx/JSONRPC/Errors.h"
+#include "ofx/JSONRPC/HashRing.h"
+#include "ofx/JSONRPC/LockingPolicy.h"
+#include "ofx/JSONRPC/MessageLimits.h"
 #include "ofx/JSONRPC/MethodArgs.h"
+#include "ofx/JSONRPC/MethodCatalog.h"
+#include "ofx/JSONRPC/ParameterValidator.h"
+#include "ofx/JSONRPC/ParamsStream.h"
 #include "ofx/JSONRPC/MethodRegistry.h"
+#include "ofx/JSONRPC/NotificationLog.h"
+#include "ofx/JSONRPC/PendingCalls.h"
+#include "ofx/JSONRPC/Reducer.h"
 #include "ofx/JSONRPC/Request.h"
 #include "ofx/JSONRPC/Response.h"
+#include "ofx/JSONRPC/ResultCache.h"
+#include "ofx/JSONRPC/ResultWriter.h"
+#include "ofx/JSONRPC/StaticMethodTable.h"
+#include "ofx/JSONRPC/StreamingRequestParser.h"
+#include "ofx/JSONRPC/TimerWheel.h"
+#include "ofx/JSONRPC/TrafficLog.h"
+#include "ofx/JSONRPC/UploadStream.h"
+#include "ofx/HTTP/Gateway.h"
+#include "ofx/HTTP/GetRoute.h"
 #include "ofx/HTTP/JSONRPCServer.h"
+#include "ofx/HTTP/KeepAliveTracker.h"
+#include "ofx/HTTP/PreforkSupervisor.h"
+#include "ofx/HTTP/ServerSentEventsRoute.h"
+#include "ofx/HTTP/ShardedSessionStore.h"
+#include "ofx/HTTP/StreamingPostRoute.h"
+#include "ofx/HTTP/TrafficReplayer.h"
+#include "ofx/HTTP/UpstreamConnection.h"
 
 namespace ofxJSONRPC = ofx::JSONRPC;